@@ -0,0 +1,114 @@
+// Accessor for tables written by LazyResult.Columnar() into a SharedArrayBuffer. It does not load the
+// addon, so that workers which only consume results can use it. A table is described by a plain object,
+// which can be posted to other workers without copying the buffer:
+// {buffer, rows, byteLength, heapOffset, heapLength, columns: [{name, type, kind, offset, width}]}
+
+const CHUNK = 8192;
+
+function decodeUtf16(units) {
+    let text = '';
+    for(let i = 0; i < units.length; i += CHUNK) {
+        text += String.fromCharCode.apply(null, units.subarray(i, i + CHUNK));
+    }
+    return text;
+}
+
+class ColumnarTable {
+    constructor(descriptor) {
+        this.descriptor = descriptor;
+        this.length = descriptor.rows;
+        this.columns = descriptor.columns.map(column => column.name);
+        this._columns = {};
+        descriptor.columns.forEach(column => {
+            this._columns[column.name] = column;
+        });
+    }
+
+    // Typed array over the values of a numeric column, or over the raw cells of other columns
+    column(name) {
+        const column = this._column(name);
+        const buffer = this.descriptor.buffer;
+        const rows = this.length;
+        switch(column.kind) {
+            case 'int32':
+                return new Int32Array(buffer, column.offset, rows);
+            case 'int16':
+                return new Int16Array(buffer, column.offset, rows);
+            case 'uint8':
+                return new Uint8Array(buffer, column.offset, rows);
+            case 'float64':
+                return new Float64Array(buffer, column.offset, rows);
+            case 'char':
+                return new Uint16Array(buffer, column.offset, rows * column.width / 2);
+            case 'string':
+            case 'xstring':
+                return new Uint32Array(buffer, column.offset, rows * 2);
+            default:
+                return new Uint8Array(buffer, column.offset, rows * column.width);
+        }
+    }
+
+    // Decoded value of a single cell, like the field of a regular result row. Byte fields are views
+    // on the shared buffer instead of copies.
+    get(index, name) {
+        if(index < 0 || index >= this.length) {
+            throw new RangeError('Row index out of range');
+        }
+        const column = this._column(name);
+        const buffer = this.descriptor.buffer;
+        const cell = column.offset + index * column.width;
+        switch(column.kind) {
+            case 'int32':
+                return new Int32Array(buffer, cell, 1)[0];
+            case 'int16':
+                return new Int16Array(buffer, cell, 1)[0];
+            case 'uint8':
+                return new Uint8Array(buffer, cell, 1)[0];
+            case 'float64':
+                return new Float64Array(buffer, cell, 1)[0];
+            case 'char': {
+                const units = new Uint16Array(buffer, cell, column.width / 2);
+                const end = units.indexOf(0);
+                return decodeUtf16(end < 0 ? units : units.subarray(0, end));
+            }
+            case 'bytes':
+                return new Uint8Array(buffer, cell, column.width);
+            case 'string':
+            case 'xstring': {
+                const reference = new Uint32Array(buffer, cell, 2);
+                const start = this.descriptor.heapOffset + reference[0];
+                if(column.kind === 'xstring') {
+                    return new Uint8Array(buffer, start, reference[1]);
+                }
+                return decodeUtf16(new Uint16Array(buffer, start, reference[1] / 2));
+            }
+        }
+        return undefined;
+    }
+
+    row(index) {
+        const row = {};
+        this.columns.forEach(name => {
+            row[name] = this.get(index, name);
+        });
+        return row;
+    }
+
+    toArray() {
+        const rows = new Array(this.length);
+        for(let i = 0; i < this.length; i++) {
+            rows[i] = this.row(i);
+        }
+        return rows;
+    }
+
+    _column(name) {
+        const column = this._columns[name];
+        if(!column) {
+            throw new TypeError('Unknown column: ' + name);
+        }
+        return column;
+    }
+}
+
+module.exports = ColumnarTable;
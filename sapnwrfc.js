@@ -1,5 +1,8 @@
+const fs = require('fs');
+const path = require('path');
 const load = require('./load');
 const sapnwrfc = require(load.modulePath);
+const ColumnarTable = require('./columnar');
 
 let _logger;
 
@@ -20,6 +23,418 @@ function _log(level, message, meta) {
 }
 
 sapnwrfc.Connection.prototype._log = _log;
+sapnwrfc.ConnectionPool.prototype._log = _log;
 sapnwrfc.Function.prototype._log = _log;
+sapnwrfc.LazyResult.prototype._log = _log;
+sapnwrfc.Server.prototype._log = _log;
+sapnwrfc.Transaction.prototype._log = _log;
+sapnwrfc.Unit.prototype._log = _log;
+
+function isIndex(prop) {
+    return typeof prop === 'string' && /^(0|[1-9][0-9]*)$/.test(prop);
+}
+
+// Array-like view on a table parameter, rows are decoded on first access
+function lazyTable(native, name) {
+    const length = native.RowCount(name);
+    const rows = new Array(length);
+
+    function row(index) {
+        if(!(index in rows)) {
+            rows[index] = native.Row(name, index);
+        }
+        return rows[index];
+    }
+
+    return new Proxy(rows, {
+        get(target, prop, receiver) {
+            if(isIndex(prop) && Number(prop) < length) {
+                return row(Number(prop));
+            }
+            return Reflect.get(target, prop, receiver);
+        },
+        has(target, prop) {
+            if(isIndex(prop)) {
+                return Number(prop) < length;
+            }
+            return Reflect.has(target, prop);
+        },
+        getOwnPropertyDescriptor(target, prop) {
+            if(isIndex(prop) && Number(prop) < length) {
+                return {get: () => row(Number(prop)), enumerable: true, configurable: true};
+            }
+            return Reflect.getOwnPropertyDescriptor(target, prop);
+        },
+        ownKeys(target) {
+            return Object.keys(Array.from({length})).concat('length');
+        }
+    });
+}
+
+// Result object whose parameters are decoded on first access
+function lazyResult(native) {
+    const types = native.Parameters();
+    const values = {};
+
+    function value(name) {
+        if(!(name in values)) {
+            values[name] = types[name] === 'RFCTYPE_TABLE' ? lazyTable(native, name) : native.Get(name);
+        }
+        return values[name];
+    }
+
+    function dispose() {
+        return native.Dispose();
+    }
+
+    return new Proxy({}, {
+        get(target, prop) {
+            if(prop === 'dispose') {
+                return dispose;
+            }
+            if(typeof prop === 'string' && prop in types) {
+                return value(prop);
+            }
+            return undefined;
+        },
+        has(target, prop) {
+            return prop in types;
+        },
+        getOwnPropertyDescriptor(target, prop) {
+            if(typeof prop === 'string' && prop in types) {
+                return {get: () => value(prop), enumerable: true, configurable: true};
+            }
+            return undefined;
+        },
+        ownKeys() {
+            return Object.keys(types);
+        }
+    });
+}
+
+// Result object with tables written into SharedArrayBuffers, the container is released right away
+function columnarResult(native) {
+    const types = native.Parameters();
+    const result = {};
+    try {
+        Object.keys(types).forEach(function(name) {
+            if(types[name] === 'RFCTYPE_TABLE') {
+                let buffer;
+                const layout = native.Columnar(name, function(byteLength) {
+                    buffer = new SharedArrayBuffer(byteLength);
+                    return new Uint8Array(buffer);
+                });
+                layout.buffer = buffer;
+                result[name] = new ColumnarTable(layout);
+            } else {
+                result[name] = native.Get(name);
+            }
+        });
+    } finally {
+        native.Dispose();
+    }
+    return result;
+}
+
+sapnwrfc.ColumnarTable = ColumnarTable;
+
+const invoke = sapnwrfc.Function.prototype.Invoke;
+
+sapnwrfc.Function.prototype.Invoke = function(params, callback, options) {
+    if(options && options.columnar && typeof callback === 'function') {
+        return invoke.call(this, params, function(err, result) {
+            if(err) {
+                return callback(err);
+            }
+            let columnar;
+            try {
+                columnar = columnarResult(result);
+            } catch(e) {
+                return callback(e);
+            }
+            callback(undefined, columnar);
+        }, Object.assign({}, options, {lazy: true}));
+    }
+    if(options && options.lazy && typeof callback === 'function') {
+        return invoke.call(this, params, function(err, result) {
+            callback(err, result instanceof sapnwrfc.LazyResult ? lazyResult(result) : result);
+        }, options);
+    }
+    return invoke.apply(this, arguments);
+};
+
+function abortError(err) {
+    err = err || new Error('Call cancelled');
+    err.name = 'AbortError';
+    return err;
+}
+
+// Runs a callback based native call as Promise, which is cancelled when the signal is aborted.
+// start(callback) returns the id of the native call or undefined if it cannot be cancelled.
+function cancellable(signal, start, cancel, abandon) {
+    return new Promise(function(resolve, reject) {
+        if(signal && signal.aborted) {
+            return reject(abortError());
+        }
+
+        let id;
+        function onAbort() {
+            if(id === undefined || !cancel(id) || abandon) {
+                reject(abortError());
+            }
+        }
+
+        if(signal) {
+            signal.addEventListener('abort', onAbort);
+        }
+        id = start(function(err, result) {
+            if(signal) {
+                signal.removeEventListener('abort', onAbort);
+            }
+            if(err) {
+                reject(signal && signal.aborted && err.key === 'RFC_CANCELED' ? abortError(err) : err);
+            } else {
+                resolve(result);
+            }
+        });
+    });
+}
+
+function withoutSignal(options) {
+    const copy = Object.assign({}, options);
+    delete copy.signal;
+    return copy;
+}
+
+sapnwrfc.Function.prototype.InvokeAsync = function(params, options) {
+    const func = this;
+    options = options || {};
+    return cancellable(options.signal, function(callback) {
+        return func.Invoke(params, callback, withoutSignal(options));
+    }, function(id) {
+        return func.Cancel(id);
+    });
+};
+
+// Opening cannot be interrupted, an aborted Open settles at once and the late connection is closed
+sapnwrfc.Connection.prototype.OpenAsync = function(params, options) {
+    const con = this;
+    options = options || {};
+    return cancellable(options.signal, function(callback) {
+        return con.Open(params, callback, withoutSignal(options));
+    }, function(id) {
+        return con.Cancel(id);
+    }, true);
+};
+
+// A cancelled connection has been closed by the SDK, one which timed out may still be in the call
+function isInterrupted(err) {
+    return !!err && (err.key === 'RFC_CANCELED' || err.key === 'RFC_TIMEOUT');
+}
+
+// Leases a pooled connection for the duration of a single invocation
+sapnwrfc.ConnectionPool.prototype.Invoke = function(functionName, params, callback, options) {
+    const pool = this;
+    pool.Acquire(function(err, connection) {
+        if(err) {
+            return callback(err);
+        }
+        connection.LookupAsync(functionName, function(err, func) {
+            if(err) {
+                pool.Release(connection);
+                return callback(err);
+            }
+            func.Invoke(params, function(err, result) {
+                pool.Release(connection, isInterrupted(err));
+                callback(err, result);
+            }, options);
+        });
+    });
+};
+
+sapnwrfc.ConnectionPool.prototype.InvokeAsync = function(functionName, params, options) {
+    const pool = this;
+    options = options || {};
+    return new Promise(function(resolve, reject) {
+        pool.Acquire(function(err, connection) {
+            if(err) {
+                return reject(err);
+            }
+            connection.LookupAsync(functionName).then(function(func) {
+                return func.InvokeAsync(params, options);
+            }).then(function(result) {
+                pool.Release(connection);
+                resolve(result);
+            }, function(err) {
+                pool.Release(connection, isInterrupted(err));
+                reject(err);
+            });
+        });
+    });
+};
+
+sapnwrfc.ConnectionPool.prototype.WarmUpAsync = function(options) {
+    const pool = this;
+    return new Promise(function(resolve, reject) {
+        pool.WarmUp(options || {}, function(err, report) {
+            if(err) {
+                err.report = report;
+                return reject(err);
+            }
+            resolve(report);
+        });
+    });
+};
+
+sapnwrfc.Server.prototype.StartAsync = function() {
+    const server = this;
+    return new Promise(function(resolve, reject) {
+        server.Start(function(err) {
+            return err ? reject(err) : resolve();
+        });
+    });
+};
+
+sapnwrfc.Server.prototype.StopAsync = function() {
+    const server = this;
+    return new Promise(function(resolve) {
+        server.Stop(resolve);
+    });
+};
+
+// Submits bgRFC units of calls [{fn, params}] on up to concurrency pooled connections at a time. Each connection
+// sends its units one after another, so that building the next unit overlaps with the others being posted.
+// Resolves with {submitted, failed: [{index, unitId, error}]}, failed units can be retried with their unitId.
+sapnwrfc.ConnectionPool.prototype.SubmitUnits = function(units, options) {
+    const pool = this;
+    options = options || {};
+    const iterator = units[Symbol.iterator]();
+    const concurrency = Math.max(1, options.concurrency || pool.Stats().max);
+    const report = {submitted: 0, failed: []};
+    let next = 0;
+
+    function take() {
+        const item = iterator.next();
+        return item.done ? undefined : {index: next++, calls: item.value};
+    }
+
+    function submit(connection, functions, unit) {
+        return unit.calls.reduce(function(chain, call) {
+            return chain.then(function(added) {
+                if(!functions.has(call.fn)) {
+                    functions.set(call.fn, connection.LookupAsync(call.fn));
+                }
+                return functions.get(call.fn).then(function(func) {
+                    added.Add(func, call.params);
+                    return added;
+                });
+            });
+        }, Promise.resolve(connection.Unit({queues: options.queues, history: options.history}))).then(function(added) {
+            return added.Submit();
+        });
+    }
+
+    // A connection which failed to communicate is discarded at once and the lane continues on a new one. Errors
+    // of the lane itself, e.g. of the units iterator, discard its connection and reject.
+    function lane() {
+        return new Promise(function(resolve, reject) {
+            let unit;
+            let connection;
+            let functions;
+            function fail(err) {
+                const held = connection;
+                connection = undefined;
+                try {
+                    if(held) {
+                        pool.Release(held, true);
+                    }
+                } finally {
+                    reject(err);
+                }
+            }
+            function release(discard) {
+                const held = connection;
+                connection = undefined;
+                pool.Release(held, discard);
+            }
+            function acquire() {
+                pool.Acquire(function(err, acquired) {
+                    if(err) {
+                        return reject(err);
+                    }
+                    connection = acquired;
+                    functions = new Map();
+                    step();
+                });
+            }
+            function step() {
+                Promise.resolve().then(function() {
+                    if(!unit) {
+                        release(false);
+                        return resolve();
+                    }
+                    const current = unit;
+                    return Promise.resolve().then(function() {
+                        return submit(connection, functions, current);
+                    }).then(function() {
+                        report.submitted++;
+                        return false;
+                    }, function(error) {
+                        report.failed.push({index: current.index, unitId: error && error.unitId, error});
+                        return Boolean(error) && error.key === 'RFC_COMMUNICATION_FAILURE';
+                    }).then(function(broken) {
+                        if(!broken) {
+                            unit = take();
+                            return step();
+                        }
+                        release(true);
+                        unit = take();
+                        if(!unit) {
+                            return resolve();
+                        }
+                        acquire();
+                    });
+                }).catch(fail);
+            }
+            try {
+                unit = take();
+            } catch(err) {
+                return reject(err);
+            }
+            if(!unit) {
+                return resolve();
+            }
+            acquire();
+        });
+    }
+
+    const lanes = [];
+    for(let i = 0; i < concurrency; i++) {
+        lanes.push(lane());
+    }
+    return Promise.all(lanes).then(function() {
+        report.failed.sort(function(a, b) {
+            return a.index - b.index;
+        });
+        return report;
+    });
+};
+
+// Buffers are stored as {type: 'Buffer', data} by JSON.stringify()
+function reviveBuffer(key, value) {
+    if(value && value.type === 'Buffer' && Array.isArray(value.data)) {
+        return Buffer.from(value.data);
+    }
+    return value;
+}
+
+// Transactions recorded in a TID store which have not been executed yet: [{tid, queue, calls: [{name, params}]}]
+sapnwrfc.PendingTransactions = function(store) {
+    return fs.readdirSync(store).filter(function(name) {
+        return /^[0-9A-Za-z]{24}\.json$/.test(name);
+    }).map(function(name) {
+        return JSON.parse(fs.readFileSync(path.join(store, name), 'utf8'), reviveBuffer);
+    });
+};
 
 module.exports = sapnwrfc;
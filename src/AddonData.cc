@@ -0,0 +1,89 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#include "AddonData.h"
+#include "RfcQueue.h"
+#include "RfcWorker.h"
+#include <algorithm>
+
+void AddonData::Init(Napi::Env env) {
+  auto data = new AddonData;
+  auto status = napi_set_instance_data(env, data, Finalize, nullptr);
+  if (status != napi_ok) {
+    delete data;
+    throw Napi::Error::New(env);
+  }
+
+  // Created before the cleanup hook is added, hooks run in reverse order
+  RfcWorker::CreateCompletions(env, data->completions);
+
+  data->localQueue = std::make_shared<RfcQueue>();
+  data->AddQueue(data->localQueue);
+
+  status = napi_add_env_cleanup_hook(env, Cleanup, data);
+  if (status != napi_ok) {
+    throw Napi::Error::New(env);
+  }
+}
+
+AddonData &AddonData::Get(Napi::Env env) {
+  void *data{};
+  auto status = napi_get_instance_data(env, &data);
+  if (status != napi_ok || data == nullptr) {
+    throw Napi::Error::New(env, "Addon has not been initialized in this environment");
+  }
+  return *static_cast<AddonData *>(data);
+}
+
+void AddonData::AddQueue(const std::shared_ptr<RfcQueue> &queue) {
+  // Queues of collected connections are dropped on the way
+  queues.erase(std::remove_if(queues.begin(), queues.end(), [](const std::weak_ptr<RfcQueue> &q) {
+    return q.expired();
+  }), queues.end());
+  queues.push_back(queue);
+}
+
+/*
+ * Called when the environment is torn down, before the finalizers of the remaining objects.
+ */
+void AddonData::Cleanup(void *arg) {
+  auto data = static_cast<AddonData *>(arg);
+
+  for (auto &weak : data->queues) {
+    auto queue = weak.lock();
+    if (queue) {
+      queue->Drain();
+    }
+  }
+  data->queues.clear();
+
+  // No executor thread posts completions anymore, posted ones are dropped by RfcWorker::CallJs()
+  napi_release_threadsafe_function(data->completions, napi_tsfn_abort);
+  data->completions = nullptr;
+}
+
+void AddonData::Finalize(napi_env, void *data, void *) {
+  delete static_cast<AddonData *>(data);
+}
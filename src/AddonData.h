@@ -0,0 +1,88 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#ifndef SAPNWRFC_ADDONDATA_H
+#define SAPNWRFC_ADDONDATA_H
+
+#include <napi.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "FunctionSchema.h"
+#include "ResultCache.h"
+
+class FunctionInvoke;
+class RfcQueue;
+
+/*
+ * State of the addon in one JavaScript environment, i.e. the main thread or a worker thread.
+ * It is stored as instance data of the environment, so that the addon can be loaded in several
+ * worker_threads at once. Only the RfcExecutor and RfcWatchdog threads are shared by all of them.
+ *
+ * When a worker thread exits, waiting calls are dropped, running calls are cancelled and the
+ * environment waits until the executor has let go of all its connections.
+ */
+class AddonData {
+  public:
+    static void Init(Napi::Env env);
+    static AddonData &Get(Napi::Env env);
+
+    AddonData(const AddonData &) = delete;
+    AddonData &operator=(const AddonData &) = delete;
+
+    /*
+     * Registers the queue of a new connection, so that it can be drained on cleanup.
+     */
+    void AddQueue(const std::shared_ptr<RfcQueue> &queue);
+
+    Napi::FunctionReference connectionCtor;
+    Napi::FunctionReference connectionPoolCtor;
+    Napi::FunctionReference functionCtor;
+    Napi::FunctionReference lazyResultCtor;
+    Napi::FunctionReference transactionCtor;
+    Napi::FunctionReference unitCtor;
+
+    ResultCache resultCache;
+    SchemaCache schemaCache;
+    std::unordered_map<std::string, FunctionInvoke *> inFlight;
+
+    // Completions of RfcWorkers, see RfcWorker::Queue()
+    napi_threadsafe_function completions{};
+    size_t pendingWorkers{};
+
+    // Runs workers which need no connection, drained on cleanup like the queues of the connections
+    std::shared_ptr<RfcQueue> localQueue;
+
+  private:
+    AddonData() = default;
+
+    static void Cleanup(void *data);
+    static void Finalize(napi_env env, void *data, void *hint);
+
+    std::vector<std::weak_ptr<RfcQueue> > queues;
+};
+
+#endif //SAPNWRFC_ADDONDATA_H
@@ -25,15 +25,27 @@ SOFTWARE.
 
 #include "Utils.h"
 #include "Connection.h"
+#include "AddonData.h"
 #include "ConnectionOpen.h"
+#include "ConnectionPing.h"
+#include "ConnectionIsOpen.h"
+#include "ConnectionClose.h"
+#include "ConnectionLookup.h"
+#include "FunctionDescriptor.h"
+#include "ConnectionBatch.h"
 #include "Function.h"
-
-Napi::FunctionReference Connection::ctor;
+#include "Transaction.h"
+#include "Unit.h"
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+#include <random>
 
 Connection::Connection(const Napi::CallbackInfo &info)
     : Napi::ObjectWrap<Connection>(info) {
   uv_mutex_init(&invocationMutex);
   init(Value());
+  AddonData::Get(info.Env()).AddQueue(queue);
 }
 
 Connection::~Connection() {
@@ -48,12 +60,7 @@ Connection::~Connection() {
   }
 
   uv_mutex_destroy(&invocationMutex);
-
-  for (unsigned int i = 0; i < loginParamsSize; i++) {
-    free(const_cast<SAP_UC *>(loginParams[i].name));
-    free(const_cast<SAP_UC *>(loginParams[i].value));
-  }
-  free(loginParams);
+  FreeLoginParams(loginParams, loginParamsSize);
 
   deferLog(Levels::SILLY, "Connection::~Connection [end]");
 }
@@ -67,11 +74,21 @@ Napi::Object Connection::Init(Napi::Env env, Napi::Object exports) {
       InstanceMethod("Ping", &Connection::Ping),
       InstanceMethod("IsOpen", &Connection::IsOpen),
       InstanceMethod("Lookup", &Connection::Lookup),
+      InstanceMethod("Define", &Connection::Define),
       InstanceMethod("SetIniPath", &Connection::SetIniPath),
+      InstanceMethod("CloseAsync", &Connection::CloseAsync),
+      InstanceMethod("PingAsync", &Connection::PingAsync),
+      InstanceMethod("IsOpenAsync", &Connection::IsOpenAsync),
+      InstanceMethod("LookupAsync", &Connection::LookupAsync),
+      InstanceMethod("InvokeBatch", &Connection::InvokeBatch),
+      InstanceMethod("Cancel", &Connection::Cancel),
+      InstanceMethod("ReconnectStats", &Connection::ReconnectStats),
+      InstanceMethod("LookupStats", &Connection::LookupStats),
+      InstanceMethod("Transaction", &Connection::Transaction),
+      InstanceMethod("Unit", &Connection::Unit),
   });
 
-  ctor = Napi::Persistent(con);
-  ctor.SuppressDestruct();
+  AddonData::Get(env).connectionCtor = Napi::Persistent(con);
   exports.Set("Connection", con);
   return exports;
 }
@@ -109,35 +126,100 @@ Napi::Value Connection::Open(const Napi::CallbackInfo &info) {
   if (!info[1].IsFunction()) {
     throw Napi::TypeError::New(env, "Argument 2 must be a function");
   }
+  if (info.Length() > 2 && !info[2].IsUndefined() && !info[2].IsObject()) {
+    throw Napi::TypeError::New(env, "Argument 3 must be an object");
+  }
+
+  uint32_t timeout{};
+  if (info.Length() > 2 && info[2].IsObject()) {
+    auto options = info[2].ToObject();
+    auto timeoutOption = options.Get("timeout");
+    if (!timeoutOption.IsUndefined()) {
+      if (!timeoutOption.IsNumber() || timeoutOption.ToNumber().DoubleValue() < 0) {
+        throw Napi::TypeError::New(env, "Option timeout must be a non-negative number");
+      }
+      timeout = timeoutOption.ToNumber().Uint32Value();
+    }
+    SetReconnectOptions(env, options.Get("reconnect"));
+  }
 
   auto optionsObj = info[0].ToObject();
   auto props = optionsObj.GetPropertyNames();
 
-  loginParamsSize = props.Length();
-  loginParams = static_cast<RFC_CONNECTION_PARAMETER *>(malloc(loginParamsSize * sizeof(RFC_CONNECTION_PARAMETER)));
-  memset(loginParams, 0, loginParamsSize * sizeof(RFC_CONNECTION_PARAMETER));
-  memset(&errorInfo, 0, sizeof(RFC_ERROR_INFO));
+  // The new parameters may point to another system
+  functions.clear();
+  logonKey.clear();
+
+  // Taken over by Reopen() on the executor, as a running worker may still use the current ones
+  auto paramsSize = props.Length();
+  auto params = static_cast<RFC_CONNECTION_PARAMETER *>(malloc(paramsSize * sizeof(RFC_CONNECTION_PARAMETER)));
+  memset(params, 0, paramsSize * sizeof(RFC_CONNECTION_PARAMETER));
 
   log(env, Levels::DBG, "Connection params", optionsObj);
 
-  for (unsigned int i = 0; i < loginParamsSize; i++) {
+  static const char *const logonInfoNames[] = {"dest", "ashost", "mshost", "gwhost", "sysnr", "sysid", "r3name",
+                                               "group", "client", "user", "lang"};
+  auto logon = Napi::Object::New(env);
+
+  for (unsigned int i = 0; i < paramsSize; i++) {
     auto name = props.Get(i);
     auto value = optionsObj.Get(name);
 
-    loginParams[i].name = convertToSAPUC(name.ToString());
-    loginParams[i].value = convertToSAPUC(value.ToString());
+    params[i].name = convertToSAPUC(name.ToString());
+    params[i].value = convertToSAPUC(value.ToString());
+
+    auto lowerName = name.ToString().Utf8Value();
+    std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), ::tolower);
+    if (std::find(std::begin(logonInfoNames), std::end(logonInfoNames), lowerName) != std::end(logonInfoNames)) {
+      logon.Set(lowerName, value.ToString());
+    }
 
 #ifndef NDEBUG
     std::cout << name.ToString().Utf8Value() << "--> " << value.ToString().Utf8Value() << std::endl;
 #endif
   }
+  logonInfo = Napi::Persistent(logon);
 
   // Store callback
   auto callback = info[1].As<Napi::Function>();
-  auto worker = new ConnectionOpen{callback, this};
+  auto worker = new ConnectionOpen{callback, this, params, paramsSize};
+  worker->SetTimeout(timeout);
+  auto id = worker->Id();
   worker->Queue();
   Reference::Ref();
-  return env.Undefined();
+  return scope.Escape(Napi::Number::New(env, id));
+}
+
+static uint32_t reconnectOption(Napi::Env env, Napi::Object options, const char *name, uint32_t defaultValue) {
+  auto value = options.Get(name);
+  if (value.IsUndefined()) {
+    return defaultValue;
+  }
+  if (!value.IsNumber() || value.ToNumber().DoubleValue() < 0) {
+    throw Napi::TypeError::New(env, std::string("Option reconnect.") + name + " must be a non-negative number");
+  }
+  return value.ToNumber().Uint32Value();
+}
+
+/*
+ * reconnect: true or { retries, initialDelay, maxDelay }
+ */
+void Connection::SetReconnectOptions(Napi::Env env, Napi::Value value) {
+  if (value.IsUndefined()) {
+    return;
+  }
+  if (!value.IsObject()) {
+    reconnect.enabled = value.ToBoolean();
+    return;
+  }
+
+  auto options = value.ToObject();
+  ReconnectOptions parsed;
+  parsed.enabled = true;
+  parsed.retries = reconnectOption(env, options, "retries", parsed.retries);
+  parsed.initialDelay = std::max(reconnectOption(env, options, "initialDelay", parsed.initialDelay), uint32_t{1});
+  parsed.maxDelay = std::max(reconnectOption(env, options, "maxDelay", parsed.maxDelay), parsed.initialDelay);
+  reconnect = parsed;
 }
 
 Napi::Value Connection::Close(const Napi::CallbackInfo &info) {
@@ -152,9 +234,10 @@ Napi::Value Connection::CloseConnection(Napi::Env env) {
 
   log(env, Levels::SILLY, "Connection::CloseConnection");
 
-  auto handle = connectionHandle;
+  HandleLock lock{env, this};
+  logonKey.clear();
+  auto handle = connectionHandle.exchange(nullptr);
   if (handle != nullptr) {
-    this->connectionHandle = nullptr;
     CALL_API("Connection::CloseConnection: Error closing connection",
               RfcCloseConnection, handle);
   }
@@ -162,6 +245,92 @@ Napi::Value Connection::CloseConnection(Napi::Env env) {
   return scope.Escape(Napi::Boolean::New(env, true));
 }
 
+/**
+ * @return logon parameters identifying the system, without credentials
+ */
+Napi::Object Connection::LogonInfo(Napi::Env env) {
+  Napi::EscapableHandleScope scope{env};
+  if (logonInfo.IsEmpty()) {
+    return scope.Escape(Napi::Object::New(env)).ToObject();
+  }
+  return scope.Escape(logonInfo.Value()).ToObject();
+}
+
+void Connection::FreeLoginParams(RFC_CONNECTION_PARAMETER *params, unsigned int paramsSize) {
+  if (params == nullptr) {
+    return;
+  }
+  for (unsigned int i = 0; i < paramsSize; i++) {
+    free(const_cast<SAP_UC *>(params[i].name));
+    free(const_cast<SAP_UC *>(params[i].value));
+  }
+  free(params);
+}
+
+bool Connection::IsHandleValid() {
+  if (connectionHandle == nullptr) {
+    return false;
+  }
+  RFC_ERROR_INFO errorInfo{};
+  int isValid{};
+  RfcIsConnectionHandleValid(connectionHandle, &isValid, &errorInfo);
+  return isValid != 0;
+}
+
+/*
+ * Replaces a broken handle by a new connection, opened with the stored logon parameters. With new parameters, the
+ * connection is opened for the first time or with another logon, which does not count as reconnect.
+ */
+bool Connection::Reopen(RFC_ERROR_INFO &errorInfo, RFC_CONNECTION_PARAMETER *params, unsigned int paramsSize) {
+  auto start = std::chrono::steady_clock::now();
+  bool reconnecting = params == nullptr;
+  if (reconnecting) {
+    reconnectAttempts++;
+  } else {
+    FreeLoginParams(loginParams, loginParamsSize);
+    loginParams = params;
+    loginParamsSize = paramsSize;
+  }
+
+  auto handle = connectionHandle.exchange(nullptr);
+  if (handle != nullptr) {
+    RFC_ERROR_INFO closeErrorInfo{};
+    RfcCloseConnection(handle, &closeErrorInfo);
+  }
+
+  connectionHandle = RfcOpenConnection(loginParams, loginParamsSize, &errorInfo);
+  deferLogAPICall("RfcOpenConnection", __FILE__, BOOST_CURRENT_FUNCTION, __LINE__, errorInfo);
+  if (connectionHandle == nullptr) {
+    return false;
+  }
+  if (!reconnecting) {
+    return true;
+  }
+
+  auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+  reconnects++;
+  lastReconnectMillis = millis.count();
+  totalReconnectMillis += millis.count();
+  deferLog(Levels::INFO, "Connection reopened after " + std::to_string(millis.count()) + " ms");
+  return true;
+}
+
+/*
+ * Exponential backoff with jitter, so that connections broken at the same time do not reconnect at once.
+ */
+std::chrono::milliseconds Connection::Backoff(uint32_t attempt) {
+  static thread_local std::mt19937 random{std::random_device{}()};
+
+  uint64_t delay = reconnect.initialDelay;
+  for (uint32_t i = 1; i < attempt && delay < reconnect.maxDelay; i++) {
+    delay *= 2;
+  }
+  delay = std::min<uint64_t>(delay, reconnect.maxDelay);
+
+  std::uniform_int_distribution<uint64_t> jitter{delay / 2, delay};
+  return std::chrono::milliseconds(std::max<uint64_t>(jitter(random), 1));
+}
+
 RFC_CONNECTION_HANDLE Connection::GetConnectionHandle(void) {
   return this->connectionHandle;
 }
@@ -170,7 +339,12 @@ void Connection::LockMutex() {
   uv_mutex_lock(&this->invocationMutex);
 }
 
+bool Connection::TryLockMutex() {
+  return uv_mutex_trylock(&this->invocationMutex) == 0;
+}
+
 void Connection::UnlockMutex() {
+  handleValid = IsHandleValid();
   uv_mutex_unlock(&this->invocationMutex);
 }
 
@@ -186,15 +360,14 @@ Napi::Value Connection::IsOpen(const Napi::CallbackInfo &info) {
 
   log(env, Levels::SILLY, "Connection::IsOpen");
 
-  int isValid;
-  RfcIsConnectionHandleValid(connectionHandle, &isValid, &errorInfo);
-  LOG_API(env, this, "RfcIsConnectionHandleValid");
+  // Never waits for a running call, the validity is refreshed whenever a worker releases the handle
+  bool isValid = connectionHandle.load() != nullptr && handleValid;
   if (!isValid) {
-    log(env, Levels::SILLY, "Connection::IsOpen: RfcIsConnectionHandleValid returned false");
+    log(env, Levels::SILLY, "Connection::IsOpen: handle is not valid");
   } else {
-    log(env, Levels::SILLY, "Connection::IsOpen: RfcIsConnectionHandleValid returned true");
+    log(env, Levels::SILLY, "Connection::IsOpen: handle is valid");
   }
-  return scope.Escape(Napi::Boolean::New(env, static_cast<bool>(isValid)));
+  return scope.Escape(Napi::Boolean::New(env, isValid));
 }
 
 /**
@@ -211,7 +384,8 @@ Napi::Value Connection::Ping(const Napi::CallbackInfo &info) {
     throw Napi::Error::New(env, "No arguments expected");
   }
 
-  CALL_API("Connection::Ping: RfcPing failed", RfcPing, connectionHandle);
+  HandleLock lock{env, this};
+  CALL_API("Connection::Ping: RfcPing failed", RfcPing, connectionHandle.load());
 
   return scope.Escape(Napi::Boolean::New(env, true));
 }
@@ -238,6 +412,16 @@ Napi::Value Connection::Lookup(const Napi::CallbackInfo &info) {
   bool refreshMeta = info.Length() > 1 && info[1].ToObject().Get("refreshMeta").ToBoolean();
   auto functionName = info[0].ToString().Utf16Value();
 
+  // Cached functions are returned without touching the handle, so they never wait for a running call
+  if (!refreshMeta) {
+    auto cached = CachedFunction(functionName);
+    if (!cached.IsEmpty()) {
+      return scope.Escape(cached);
+    }
+  }
+
+  // Held until the descriptor has been looked up
+  HandleLock lock{env, this};
   int isValid{};
   RfcIsConnectionHandleValid(connectionHandle, &isValid, &errorInfo);
   LOG_API(env, this, "RfcIsConnectionHandleValid");
@@ -248,9 +432,85 @@ Napi::Value Connection::Lookup(const Napi::CallbackInfo &info) {
     log(env, Levels::SILLY, "Connection::Lookup: RfcIsConnectionHandleValid returned true");
   }
 
+  if (refreshMeta) {
+    DropFunction(functionName);
+  }
+
   log(env, Levels::SILLY, "Connection::Lookup: About to create function instance");
   auto jsf = Function::NewInstance(env, *this).As<Napi::Object>();
   Napi::ObjectWrap<Function>::Unwrap(jsf)->Lookup(env, functionName, refreshMeta);
+  CacheFunction(functionName, jsf);
+  return scope.Escape(jsf);
+}
+
+/**
+ * Define(schema[, { name, repository, refresh }])
+ *
+ * @return Function
+ */
+Napi::Value Connection::Define(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+  log(env, Levels::SILLY, "Connection::Define");
+
+  if (info.Length() < 1 || info.Length() > 2) {
+    throw Napi::Error::New(env, "Function expects 1 or 2 arguments");
+  }
+  if (!info[0].IsObject()) {
+    throw Napi::TypeError::New(env, "Argument 1 must be a function schema");
+  }
+  if (info.Length() > 1 && !info[1].IsObject()) {
+    throw Napi::TypeError::New(env, "Argument 2 must be an object");
+  }
+
+  auto schema = info[0].ToObject();
+  auto options = info.Length() > 1 ? info[1].ToObject() : Napi::Object::New(env);
+
+  // The name defaults to the one in the title of MetaData()
+  std::u16string functionName;
+  auto name = options.Get("name");
+  auto title = schema.Get("title");
+  if (name.IsString()) {
+    functionName = name.ToString().Utf16Value();
+  } else if (title.IsString()) {
+    static const std::u16string prefix = u"Signature of SAP RFC function ";
+    auto titleValue = title.ToString().Utf16Value();
+    if (titleValue.compare(0, prefix.size(), prefix) == 0) {
+      functionName = titleValue.substr(prefix.size());
+    }
+  }
+  if (functionName.empty()) {
+    throw Napi::TypeError::New(env, "Option name is required if the schema has no title");
+  }
+
+  // Descriptors of an open connection go to the cache of its system, so that later lookups find them
+  std::u16string repository;
+  bool defaultRepository = false;
+  auto repositoryValue = options.Get("repository");
+  if (repositoryValue.IsString()) {
+    repository = repositoryValue.ToString().Utf16Value();
+  } else {
+    HandleLock lock{env, this};
+    int isValid{};
+    RfcIsConnectionHandleValid(connectionHandle, &isValid, &errorInfo);
+    RFC_ATTRIBUTES connectionAttributes{};
+    if (isValid && RfcGetConnectionAttributes(connectionHandle, &connectionAttributes, &errorInfo) == RFC_OK) {
+      repository = reinterpret_cast<const char16_t *>(connectionAttributes.sysId);
+    } else {
+      defaultRepository = true;
+    }
+  }
+
+  FunctionDescriptor descriptor{env, defaultRepository ? nullptr : reinterpret_cast<const SAP_UC *>(repository.c_str()),
+                                options.Get("refresh").ToBoolean()};
+  auto functionDescHandle = descriptor.Define(functionName, schema);
+  DropFunction(functionName);
+  if (options.Get("refresh").ToBoolean()) {
+    AddonData::Get(env).schemaCache.Invalidate();
+  }
+
+  auto jsf = Function::NewInstance(env, *this).As<Napi::Object>();
+  Napi::ObjectWrap<Function>::Unwrap(jsf)->SetFunctionDesc(env, functionName, functionDescHandle);
   return scope.Escape(jsf);
 }
 
@@ -278,3 +538,324 @@ Napi::Value Connection::SetIniPath(const Napi::CallbackInfo &info) {
 
   return scope.Escape(Napi::Boolean::New(env, true));
 }
+
+/*
+ * The asynchronous variants below take an optional callback as last argument. Without callback
+ * they return a Promise.
+ */
+static void checkCallbackArgument(const Napi::CallbackInfo &info, size_t maxArgs) {
+  auto env = info.Env();
+  if (info.Length() > maxArgs) {
+    throw Napi::Error::New(env, "Function expects at most " + std::to_string(maxArgs) + " arguments");
+  }
+  if (info.Length() == maxArgs && !info[maxArgs - 1].IsFunction() && !info[maxArgs - 1].IsUndefined()) {
+    throw Napi::TypeError::New(env, "Argument " + std::to_string(maxArgs) + " must be a function");
+  }
+}
+
+static Napi::Value callbackArgument(const Napi::CallbackInfo &info) {
+  return info.Length() > 0 ? info[info.Length() - 1] : info.Env().Undefined();
+}
+
+/**
+ *
+ * @return Promise resolving to true, or undefined if callback is given
+ */
+Napi::Value Connection::CloseAsync(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+  log(env, Levels::SILLY, "Connection::CloseAsync");
+
+  checkCallbackArgument(info, 1);
+
+  auto worker = new ConnectionClose{env, callbackArgument(info), this};
+  auto promise = worker->Promise();
+  worker->Queue();
+  return scope.Escape(promise);
+}
+
+/**
+ *
+ * @return Promise resolving to true, or undefined if callback is given
+ */
+Napi::Value Connection::PingAsync(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+  log(env, Levels::SILLY, "Connection::PingAsync");
+
+  checkCallbackArgument(info, 1);
+
+  auto worker = new ConnectionPing{env, callbackArgument(info), this};
+  auto promise = worker->Promise();
+  worker->Queue();
+  return scope.Escape(promise);
+}
+
+/**
+ *
+ * @return Promise resolving to a boolean, or undefined if callback is given
+ */
+Napi::Value Connection::IsOpenAsync(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+  log(env, Levels::SILLY, "Connection::IsOpenAsync");
+
+  checkCallbackArgument(info, 1);
+
+  auto worker = new ConnectionIsOpen{env, callbackArgument(info), this};
+  auto promise = worker->Promise();
+  worker->Queue();
+  return scope.Escape(promise);
+}
+
+/**
+ * LookupAsync(functionName[, options][, callback])
+ *
+ * @return Promise resolving to a Function, or undefined if callback is given
+ */
+Napi::Value Connection::LookupAsync(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+  log(env, Levels::SILLY, "Connection::LookupAsync");
+
+  if (info.Length() < 1 || info.Length() > 3) {
+    throw Napi::Error::New(env, "Function expects 1 to 3 arguments");
+  }
+  if (!info[0].IsString()) {
+    throw Napi::TypeError::New(env, "Argument 1 must be function module name");
+  }
+
+  Napi::Value options = env.Undefined();
+  Napi::Value callback = env.Undefined();
+  if (info.Length() > 1 && info[1].IsFunction()) {
+    if (info.Length() > 2) {
+      throw Napi::Error::New(env, "Callback must be the last argument");
+    }
+    callback = info[1];
+  } else {
+    options = info.Length() > 1 ? info[1] : env.Undefined();
+    callback = info.Length() > 2 ? info[2] : env.Undefined();
+  }
+  if (!options.IsUndefined() && !options.IsObject()) {
+    throw Napi::TypeError::New(env, "Argument 2 must be an object");
+  }
+  if (!callback.IsUndefined() && !callback.IsFunction()) {
+    throw Napi::TypeError::New(env, "Argument 3 must be a function");
+  }
+
+  bool refreshMeta = options.IsObject() && options.ToObject().Get("refreshMeta").ToBoolean();
+
+  auto worker = new ConnectionLookup{env, callback, this, info[0].ToString().Utf16Value(), refreshMeta};
+  auto promise = worker->Promise();
+  worker->Queue();
+  return scope.Escape(promise);
+}
+
+/**
+ * InvokeBatch(calls[, options][, callback]): invokes [{fn, params}, ...] one after another in a single
+ * worker task. fn is a Function of this connection or a function module name.
+ *
+ * @return Promise resolving to the array of results, or the call id if callback is given
+ */
+Napi::Value Connection::InvokeBatch(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+  log(env, Levels::SILLY, "Connection::InvokeBatch");
+
+  if (info.Length() < 1 || info.Length() > 3) {
+    throw Napi::Error::New(env, "Function expects 1 to 3 arguments");
+  }
+  if (!info[0].IsArray()) {
+    throw Napi::TypeError::New(env, "Argument 1 must be an array of calls");
+  }
+
+  Napi::Value options = env.Undefined();
+  Napi::Value callback = env.Undefined();
+  if (info.Length() > 1 && info[1].IsFunction()) {
+    if (info.Length() > 2) {
+      throw Napi::Error::New(env, "Callback must be the last argument");
+    }
+    callback = info[1];
+  } else {
+    options = info.Length() > 1 ? info[1] : env.Undefined();
+    callback = info.Length() > 2 ? info[2] : env.Undefined();
+  }
+  if (!options.IsUndefined() && !options.IsObject()) {
+    throw Napi::TypeError::New(env, "Argument 2 must be an object");
+  }
+  if (!callback.IsUndefined() && !callback.IsFunction()) {
+    throw Napi::TypeError::New(env, "Argument 3 must be a function");
+  }
+
+  auto timeout = options.IsObject() ? options.ToObject().Get("timeout") : env.Undefined();
+  if (!timeout.IsUndefined() && (!timeout.IsNumber() || timeout.ToNumber().DoubleValue() < 0)) {
+    throw Napi::TypeError::New(env, "Option timeout must be a non-negative number");
+  }
+
+  auto calls = info[0].As<Napi::Array>();
+  for (uint32_t i = 0; i < calls.Length(); i++) {
+    auto call = calls.Get(i);
+    if (!call.IsObject()) {
+      throw Napi::TypeError::New(env, "Call " + std::to_string(i) + " must be an object");
+    }
+    auto fn = call.ToObject().Get("fn");
+    auto params = call.ToObject().Get("params");
+    if (!fn.IsString() && !(fn.IsObject() && fn.ToObject().InstanceOf(AddonData::Get(env).functionCtor.Value()))) {
+      throw Napi::TypeError::New(env, "Call " + std::to_string(i) + ": fn must be a Function or a function module name");
+    }
+    if (fn.IsObject() && Napi::ObjectWrap<Function>::Unwrap(fn.ToObject())->connection != this) {
+      throw Napi::TypeError::New(env, "Call " + std::to_string(i) + ": Function belongs to another connection");
+    }
+    if (!params.IsUndefined() && !params.IsObject()) {
+      throw Napi::TypeError::New(env, "Call " + std::to_string(i) + ": params must be an object");
+    }
+  }
+
+  auto worker = new ConnectionBatch{env, callback, this};
+  for (uint32_t i = 0; i < calls.Length(); i++) {
+    Napi::HandleScope callScope{env};
+    auto call = calls.Get(i).ToObject();
+    auto fn = call.Get("fn");
+    auto params = call.Get("params");
+    auto inputParam = params.IsObject() ? params.ToObject() : Napi::Object::New(env);
+
+    // Names which have not been looked up yet are resolved by the worker, errors of a single call are reported in
+    // its result entry
+    Function *function{};
+    if (fn.IsString()) {
+      auto functionName = fn.ToString().Utf16Value();
+      auto cached = CachedFunction(functionName);
+      if (cached.IsEmpty()) {
+        worker->AddNamedCall(functionName, inputParam);
+        continue;
+      }
+      function = Napi::ObjectWrap<Function>::Unwrap(cached.As<Napi::Object>());
+    } else {
+      function = Napi::ObjectWrap<Function>::Unwrap(fn.ToObject());
+    }
+
+    RFC_FUNCTION_HANDLE functionHandle{};
+    auto prepared = function->PrepareInvocation(env, inputParam, functionHandle);
+    if (IsException(env, prepared)) {
+      worker->AddFailedCall(function, prepared);
+    } else {
+      worker->AddCall(function, functionHandle);
+    }
+  }
+
+  if (!timeout.IsUndefined()) {
+    worker->SetTimeout(timeout.ToNumber().Uint32Value());
+  }
+  auto id = worker->Id();
+  auto promise = worker->Promise();
+  worker->Queue();
+
+  if (callback.IsFunction()) {
+    return scope.Escape(Napi::Number::New(env, id));
+  }
+  return scope.Escape(promise);
+}
+
+/**
+ * Cancel(id): cancels a call returned by Open() or Function.Invoke() on this connection.
+ *
+ * @return true if the call was still waiting or running
+ */
+Napi::Value Connection::Cancel(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+  log(env, Levels::SILLY, "Connection::Cancel");
+
+  if (info.Length() != 1 || !info[0].IsNumber()) {
+    throw Napi::TypeError::New(env, "Argument 1 must be a call id");
+  }
+
+  auto cancelled = queue->Cancel(info[0].ToNumber().Uint32Value());
+  return scope.Escape(Napi::Boolean::New(env, cancelled));
+}
+
+/**
+ * @return Object with counters of automatic reconnects
+ */
+Napi::Value Connection::ReconnectStats(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+
+  auto stats = Napi::Object::New(env);
+  stats.Set("enabled", Napi::Boolean::New(env, reconnect.enabled));
+  stats.Set("attempts", Napi::Number::New(env, reconnectAttempts));
+  stats.Set("reconnects", Napi::Number::New(env, reconnects));
+  stats.Set("failures", Napi::Number::New(env, reconnectAttempts - reconnects));
+  stats.Set("retriedCalls", Napi::Number::New(env, retriedCalls));
+  stats.Set("lastLatency", Napi::Number::New(env, lastReconnectMillis));
+  stats.Set("totalLatency", Napi::Number::New(env, totalReconnectMillis));
+  return scope.Escape(stats);
+}
+
+/**
+ * @return Object with the hits and misses of Lookup()
+ */
+Napi::Value Connection::LookupStats(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+
+  auto stats = Napi::Object::New(env);
+  stats.Set("hits", Napi::Number::New(env, static_cast<double>(functionHits)));
+  stats.Set("misses", Napi::Number::New(env, static_cast<double>(functionMisses)));
+  stats.Set("functions", Napi::Number::New(env, functions.size()));
+  return scope.Escape(stats);
+}
+
+/**
+ * Transaction([{queue, tid, store}]): creates a tRFC transaction, or a qRFC transaction if a queue is given.
+ */
+Napi::Value Connection::Transaction(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+  log(env, Levels::SILLY, "Connection::Transaction");
+
+  if (info.Length() > 1) {
+    throw Napi::Error::New(env, "Function expects 0 or 1 arguments");
+  }
+  if (info.Length() > 0 && !info[0].IsUndefined() && !info[0].IsObject()) {
+    throw Napi::TypeError::New(env, "Argument 1 must be an object");
+  }
+
+  return scope.Escape(::Transaction::NewInstance(env, *this, info.Length() > 0 ? info[0] : env.Undefined()));
+}
+
+/**
+ * Unit([{queues, unitId, history}]): creates a bgRFC unit.
+ */
+Napi::Value Connection::Unit(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+  log(env, Levels::SILLY, "Connection::Unit");
+
+  if (info.Length() > 1) {
+    throw Napi::Error::New(env, "Function expects 0 or 1 arguments");
+  }
+  if (info.Length() > 0 && !info[0].IsUndefined() && !info[0].IsObject()) {
+    throw Napi::TypeError::New(env, "Argument 1 must be an object");
+  }
+
+  return scope.Escape(::Unit::NewInstance(env, *this, info.Length() > 0 ? info[0] : env.Undefined()));
+}
+
+Napi::Value Connection::CachedFunction(const std::u16string &functionName) {
+  auto it = functions.find(functionName);
+  if (it == functions.end()) {
+    functionMisses++;
+    return Napi::Value();
+  }
+  functionHits++;
+  return it->second.Value();
+}
+
+void Connection::CacheFunction(const std::u16string &functionName, Napi::Object function) {
+  functions[functionName] = Napi::Persistent(function);
+}
+
+void Connection::DropFunction(const std::u16string &functionName) {
+  functions.erase(functionName);
+}
@@ -28,13 +28,30 @@ SOFTWARE.
 
 #include "Loggable.h"
 #include <uv.h>
+#include "RfcQueue.h"
 #include <sapnwrfc.h>
 #include <iostream>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <unordered_map>
 
 class Connection : public Loggable, public Napi::ObjectWrap<Connection> {
     friend class Function;
     friend class FunctionInvoke;
     friend class ConnectionOpen;
+    friend class ConnectionWorker;
+    friend class ConnectionPing;
+    friend class ConnectionIsOpen;
+    friend class ConnectionClose;
+    friend class ConnectionLookup;
+    friend class ConnectionBatch;
+    friend class ConnectionPool;
+    friend class DescriptorCache;
+    friend class Transaction;
+    friend class TransactionSubmit;
+    friend class Unit;
+    friend class UnitSubmit;
 
   public:
     static Napi::Object Init(Napi::Env env, Napi::Object exports);
@@ -48,22 +65,105 @@ class Connection : public Loggable, public Napi::ObjectWrap<Connection> {
     Napi::Value Close(const Napi::CallbackInfo &info);
     Napi::Value Ping(const Napi::CallbackInfo &info);
     Napi::Value Lookup(const Napi::CallbackInfo &info);
+    Napi::Value Define(const Napi::CallbackInfo &info);
     Napi::Value IsOpen(const Napi::CallbackInfo &info);
     Napi::Value SetIniPath(const Napi::CallbackInfo &info);
+    Napi::Value CloseAsync(const Napi::CallbackInfo &info);
+    Napi::Value PingAsync(const Napi::CallbackInfo &info);
+    Napi::Value LookupAsync(const Napi::CallbackInfo &info);
+    Napi::Value IsOpenAsync(const Napi::CallbackInfo &info);
+    Napi::Value InvokeBatch(const Napi::CallbackInfo &info);
+    Napi::Value Cancel(const Napi::CallbackInfo &info);
+    Napi::Value ReconnectStats(const Napi::CallbackInfo &info);
+    Napi::Value LookupStats(const Napi::CallbackInfo &info);
+    Napi::Value Transaction(const Napi::CallbackInfo &info);
+    Napi::Value Unit(const Napi::CallbackInfo &info);
 
     Napi::Value CloseConnection(Napi::Env env);
+    void SetReconnectOptions(Napi::Env env, Napi::Value value);
 
     RFC_CONNECTION_HANDLE GetConnectionHandle();
+
+    /*
+     * The following are called on the executor thread with the mutex held. Reopen() is the only place which opens
+     * handles and replaces the logon parameters, given parameters are taken over.
+     */
+    bool IsHandleValid();
+    bool Reopen(RFC_ERROR_INFO &errorInfo, RFC_CONNECTION_PARAMETER *params = nullptr, unsigned int paramsSize = 0);
+    std::chrono::milliseconds Backoff(uint32_t attempt);
+
+    static void FreeLoginParams(RFC_CONNECTION_PARAMETER *params, unsigned int paramsSize);
+
+    /*
+     * Holds the mutex while a synchronous method on the main thread uses the handle, so that it cannot be closed
+     * or replaced by a worker meanwhile. Workers hold the mutex across network calls, so the main thread never
+     * waits for it: a busy connection throws instead.
+     */
+    class HandleLock {
+      public:
+        HandleLock(Napi::Env env, Connection *connection) : connection{connection} {
+          if (!connection->TryLockMutex()) {
+            throw Napi::Error::New(env, "Connection is busy, use the asynchronous method instead");
+          }
+        }
+        HandleLock(const HandleLock &) = delete;
+        HandleLock &operator=(const HandleLock &) = delete;
+        ~HandleLock() {
+          connection->UnlockMutex();
+        }
+
+      private:
+        Connection *connection;
+    };
+
+    /*
+     * Functions are reused by Lookup(), LookupAsync() and named calls of InvokeBatch(). Returns an empty value
+     * and counts a miss if the function module has not been looked up yet.
+     */
+    Napi::Value CachedFunction(const std::u16string &functionName);
+    void CacheFunction(const std::u16string &functionName, Napi::Object function);
+    void DropFunction(const std::u16string &functionName);
+
+    Napi::Object LogonInfo(Napi::Env env);
     void LockMutex();
+    bool TryLockMutex();
     void UnlockMutex();
     void addObjectInfoToLogMeta(Napi::Object meta) override;
 
+    // Guarded by invocationMutex, see Reopen()
     unsigned int loginParamsSize{};
     RFC_CONNECTION_PARAMETER *loginParams{};
-    RFC_CONNECTION_HANDLE connectionHandle{};
-    static Napi::FunctionReference ctor;
+    std::atomic<RFC_CONNECTION_HANDLE> connectionHandle{};
+    // Validity of the handle when the mutex was released last, read by IsOpen() without locking
+    std::atomic<bool> handleValid{};
+
+    // Logon parameters without credentials for errors, only used on the main thread
+    Napi::ObjectReference logonInfo;
+
+    // Logon attributes in keys of cached results, set on the main thread once the connection is open
+    std::string logonKey;
+
+    struct ReconnectOptions {
+      bool enabled{};
+      uint32_t retries{5};
+      uint32_t initialDelay{100};
+      uint32_t maxDelay{30000};
+    };
+    ReconnectOptions reconnect;
+
+    std::atomic<uint64_t> reconnectAttempts{};
+    std::atomic<uint64_t> reconnects{};
+    std::atomic<uint64_t> retriedCalls{};
+    std::atomic<uint64_t> lastReconnectMillis{};
+    std::atomic<uint64_t> totalReconnectMillis{};
+
+    // Dropped when the descriptor is refreshed or the connection is opened with new parameters
+    std::unordered_map<std::u16string, Napi::ObjectReference> functions;
+    uint64_t functionHits{};
+    uint64_t functionMisses{};
 
     uv_mutex_t invocationMutex;
+    std::shared_ptr<RfcQueue> queue{std::make_shared<RfcQueue>()};
 };
 
 #endif /* CONNECTION_H_ */
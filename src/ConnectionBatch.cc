@@ -0,0 +1,221 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#include "ConnectionBatch.h"
+#include "Utils.h"
+
+ConnectionBatch::ConnectionBatch(Napi::Env env, const Napi::Value &callback, Connection *connection)
+    : ConnectionWorker{env, callback, connection} {}
+
+ConnectionBatch::~ConnectionBatch() {
+  for (auto &call : calls) {
+    if (call.functionHandle) {
+      RFC_ERROR_INFO errorInfo{};
+      RfcDestroyFunction(call.functionHandle, &errorInfo);
+    }
+    if (call.function) {
+      call.function->Reference::Unref();
+    }
+  }
+}
+
+void ConnectionBatch::AddCall(Function *function, RFC_FUNCTION_HANDLE functionHandle) {
+  // The function must be alive when the batch completes
+  function->Reference::Ref();
+  calls.push_back(Call{function, functionHandle, Napi::ObjectReference(), RFC_ERROR_INFO{}, false, std::u16string(),
+                       Napi::ObjectReference(), nullptr});
+}
+
+void ConnectionBatch::AddFailedCall(Function *function, Napi::Value error) {
+  if (function) {
+    function->Reference::Ref();
+  }
+  calls.push_back(Call{function, nullptr, Napi::Persistent(error.ToObject()), RFC_ERROR_INFO{}, false,
+                       std::u16string(), Napi::ObjectReference(), nullptr});
+}
+
+void ConnectionBatch::AddNamedCall(const std::u16string &functionName, Napi::Object params) {
+  resolving = true;
+  calls.push_back(Call{nullptr, nullptr, Napi::ObjectReference(), RFC_ERROR_INFO{}, false, functionName,
+                       Napi::Persistent(params), nullptr});
+}
+
+void ConnectionBatch::Cancel() {
+  RfcWorker::Cancel();
+
+  // The running RfcInvoke returns with RFC_CANCELED, the SDK closes the connection
+  RFC_ERROR_INFO cancelErrorInfo{};
+  RfcCancel(connection->connectionHandle, &cancelErrorInfo);
+  connection->deferLogAPICall("RfcCancel", __FILE__, BOOST_CURRENT_FUNCTION, __LINE__, cancelErrorInfo);
+}
+
+void ConnectionBatch::Execute() {
+  if (IsCancelled()) {
+    return;
+  }
+  if (resolving) {
+    Resolve();
+  } else {
+    Invoke();
+  }
+}
+
+void ConnectionBatch::Resolve() {
+  connection->LockMutex();
+
+  for (auto &call : calls) {
+    if (call.functionName.empty() || call.function) {
+      continue;
+    }
+    if (connection->reconnect.enabled && !connection->IsHandleValid() && !connection->Reopen(call.errorInfo)) {
+      continue;
+    }
+
+    call.functionDescHandle = RfcGetFunctionDesc(connection->GetConnectionHandle(),
+                                                 (const SAP_UC *) call.functionName.c_str(), &call.errorInfo);
+    connection->deferLogAPICall("RfcGetFunctionDesc", __FILE__, BOOST_CURRENT_FUNCTION, __LINE__, call.errorInfo);
+  }
+
+  connection->UnlockMutex();
+}
+
+void ConnectionBatch::Invoke() {
+  connection->LockMutex();
+
+  for (auto &call : calls) {
+    if (!call.functionHandle) {
+      continue;
+    }
+    if (IsCancelled()) {
+      break;
+    }
+
+    // A call may have broken the connection, the following calls still get their chance
+    if (connection->reconnect.enabled && !connection->IsHandleValid() && !connection->Reopen(call.errorInfo)) {
+      call.invoked = true;
+      continue;
+    }
+
+    RfcInvoke(connection->GetConnectionHandle(), call.functionHandle, &call.errorInfo);
+    connection->deferLogAPICall("RfcInvoke", __FILE__, BOOST_CURRENT_FUNCTION, __LINE__, call.errorInfo);
+    call.invoked = true;
+
+    if (call.errorInfo.code == RFC_CANCELED) {
+      connection->connectionHandle = nullptr;
+      break;
+    }
+  }
+
+  connection->UnlockMutex();
+}
+
+void ConnectionBatch::PrepareResolvedCalls() {
+  auto env = Env();
+
+  for (auto &call : calls) {
+    Napi::HandleScope callScope{env};
+    if (call.functionName.empty() || call.function) {
+      continue;
+    }
+
+    if (call.functionDescHandle == nullptr) {
+      call.error = Napi::Persistent(RfcError(env, call.errorInfo).Value().ToObject());
+      call.params.Reset();
+      continue;
+    }
+
+    // The same name may occur several times or have been looked up meanwhile
+    auto cached = connection->CachedFunction(call.functionName);
+    if (cached.IsEmpty()) {
+      cached = Function::NewInstance(env, *connection);
+      Napi::ObjectWrap<Function>::Unwrap(cached.ToObject())->SetFunctionDesc(env, call.functionName,
+                                                                              call.functionDescHandle);
+      connection->CacheFunction(call.functionName, cached.ToObject());
+    }
+    call.function = Napi::ObjectWrap<Function>::Unwrap(cached.ToObject());
+    call.function->Reference::Ref();
+
+    RFC_FUNCTION_HANDLE functionHandle{};
+    auto prepared = call.function->PrepareInvocation(env, call.params.Value(), functionHandle);
+    if (IsException(env, prepared)) {
+      call.error = Napi::Persistent(prepared.ToObject());
+    } else {
+      call.functionHandle = functionHandle;
+    }
+    call.params.Reset();
+  }
+}
+
+void ConnectionBatch::OnOK() {
+  if (resolving) {
+    Napi::HandleScope scope{Env()};
+    connection->logDeferred(Env());
+    resolving = false;
+    PrepareResolvedCalls();
+
+    // Continues with the invocations, unless the batch has been cancelled meanwhile
+    if (!IsCancelled()) {
+      Continue();
+      return;
+    }
+  }
+  ConnectionWorker::OnOK();
+}
+
+void ConnectionBatch::OnError(const Napi::Error &e) {
+  Napi::HandleScope scope{Env()};
+  connection->logDeferred(Env());
+
+  // A cancelled batch still passes the results of the calls which have finished, a timeout is reported while the
+  // calls may still be running
+  if (IsCancelled() && !IsTimedOut()) {
+    resolving = false;
+    ConnectionWorker::OnOK();
+    return;
+  }
+  Reject(e.Value());
+}
+
+Napi::Value ConnectionBatch::Result() {
+  auto env = Env();
+  Napi::EscapableHandleScope scope{env};
+
+  auto results = Napi::Array::New(env, calls.size());
+  for (uint32_t i = 0; i < calls.size(); i++) {
+    Napi::HandleScope callScope{env};
+    auto &call = calls[i];
+
+    if (!call.error.IsEmpty()) {
+      results.Set(i, call.error.Value());
+    } else if (!call.invoked || call.errorInfo.code == RFC_CANCELED) {
+      results.Set(i, CancelledError(env).Value());
+    } else if (call.errorInfo.code != RFC_OK) {
+      results.Set(i, RfcError(env, call.errorInfo).Value());
+    } else {
+      results.Set(i, call.function->DoReceive(env, call.functionHandle));
+    }
+  }
+  return scope.Escape(results);
+}
@@ -0,0 +1,92 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#ifndef SAPNWRFC_CONNECTIONBATCH_H
+#define SAPNWRFC_CONNECTIONBATCH_H
+
+#include <string>
+#include <vector>
+#include "ConnectionWorker.h"
+#include "Function.h"
+
+/*
+ * Invokes several function modules one after another on the connection within a single worker task.
+ * A failing call does not affect the others, its entry in the result array is the error.
+ *
+ * Function module names which have not been looked up on the connection yet are resolved by a first Execute()
+ * under the connection mutex. Their parameters are then marshalled on the main thread before the worker continues
+ * with the invocations.
+ */
+class ConnectionBatch : public ConnectionWorker {
+  public:
+    ConnectionBatch(Napi::Env env, const Napi::Value &callback, Connection *connection);
+    ~ConnectionBatch() override;
+
+    /*
+     * Adds a call with marshalled input parameters, or a call that already failed with the given error.
+     */
+    void AddCall(Function *function, RFC_FUNCTION_HANDLE functionHandle);
+    void AddFailedCall(Function *function, Napi::Value error);
+
+    /*
+     * Adds a call of a function module which is looked up by the worker.
+     */
+    void AddNamedCall(const std::u16string &functionName, Napi::Object params);
+
+    void Cancel() override;
+
+  protected:
+    void Execute() override;
+    void OnOK() override;
+    void OnError(const Napi::Error &e) override;
+    Napi::Value Result() override;
+
+  private:
+    struct Call {
+      Function *function;
+      RFC_FUNCTION_HANDLE functionHandle;
+      Napi::ObjectReference error;
+      RFC_ERROR_INFO errorInfo;
+      bool invoked;
+
+      // Named calls until they are resolved
+      std::u16string functionName;
+      Napi::ObjectReference params;
+      RFC_FUNCTION_DESC_HANDLE functionDescHandle;
+    };
+
+    void Resolve();
+    void Invoke();
+
+    /*
+     * Creates the functions of resolved names on the main thread and marshals their parameters.
+     */
+    void PrepareResolvedCalls();
+
+    std::vector<Call> calls;
+    bool resolving{};
+};
+
+#endif //SAPNWRFC_CONNECTIONBATCH_H
@@ -0,0 +1,46 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "ConnectionClose.h"
+
+void ConnectionClose::Execute() {
+  connection->LockMutex();
+  auto handle = connection->connectionHandle.exchange(nullptr);
+  if (handle != nullptr) {
+    RfcCloseConnection(handle, &errorInfo);
+  }
+  connection->UnlockMutex();
+
+  if (handle != nullptr) {
+    connection->deferLogAPICall("RfcCloseConnection", __FILE__, BOOST_CURRENT_FUNCTION, __LINE__, errorInfo);
+    if (errorInfo.code != RFC_OK) {
+      SetError("Connection::CloseAsync: Error closing connection");
+    }
+  }
+}
+
+Napi::Value ConnectionClose::Result() {
+  connection->logonKey.clear();
+  return Napi::Boolean::New(Env(), true);
+}
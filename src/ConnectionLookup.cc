@@ -0,0 +1,84 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "ConnectionLookup.h"
+#include "AddonData.h"
+#include "Function.h"
+
+ConnectionLookup::ConnectionLookup(Napi::Env env, const Napi::Value &callback, Connection *connection,
+                                   std::u16string functionName, bool refreshMeta)
+    : ConnectionWorker{env, callback, connection}, functionName{std::move(functionName)}, refreshMeta{refreshMeta} {
+  if (refreshMeta) {
+    connection->DropFunction(this->functionName);
+    AddonData::Get(env).schemaCache.Invalidate();
+    return;
+  }
+  auto function = connection->CachedFunction(this->functionName);
+  if (!function.IsEmpty()) {
+    cached = Napi::Persistent(function.As<Napi::Object>());
+  }
+}
+
+bool ConnectionLookup::UsesConnection() {
+  // Functions looked up before are returned without a descriptor lookup
+  return cached.IsEmpty();
+}
+
+void ConnectionLookup::Execute() {
+  connection->LockMutex();
+
+  if (refreshMeta) {
+    RFC_ATTRIBUTES connectionAttributes{};
+    if (RfcGetConnectionAttributes(connection->connectionHandle, &connectionAttributes, &errorInfo) == RFC_OK) {
+      RfcRemoveFunctionDesc(connectionAttributes.sysId, (const SAP_UC *) functionName.c_str(), &errorInfo);
+    }
+  }
+
+  functionDescHandle = RfcGetFunctionDesc(connection->connectionHandle, (const SAP_UC *) functionName.c_str(),
+                                          &errorInfo);
+  connection->UnlockMutex();
+  connection->deferLogAPICall("RfcGetFunctionDesc", __FILE__, BOOST_CURRENT_FUNCTION, __LINE__, errorInfo);
+
+  if (functionDescHandle == nullptr) {
+    SetError("Connection::LookupAsync: Function description handle is NULL");
+  }
+}
+
+Napi::Value ConnectionLookup::Result() {
+  auto env = Env();
+  Napi::EscapableHandleScope scope{env};
+
+  if (!cached.IsEmpty()) {
+    return scope.Escape(cached.Value());
+  }
+  if (refreshMeta) {
+    // Schemas may have been built from the replaced descriptor meanwhile
+    AddonData::Get(env).schemaCache.Invalidate();
+  }
+
+  auto jsf = Function::NewInstance(env, *connection).As<Napi::Object>();
+  Napi::ObjectWrap<Function>::Unwrap(jsf)->SetFunctionDesc(env, functionName, functionDescHandle);
+  connection->CacheFunction(functionName, jsf);
+  return scope.Escape(jsf);
+}
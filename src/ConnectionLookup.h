@@ -0,0 +1,48 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef SAPNWRFC_CONNECTIONLOOKUP_H
+#define SAPNWRFC_CONNECTIONLOOKUP_H
+
+#include <string>
+#include "ConnectionWorker.h"
+
+class ConnectionLookup : public ConnectionWorker {
+  public:
+    ConnectionLookup(Napi::Env env, const Napi::Value &callback, Connection *connection,
+                     std::u16string functionName, bool refreshMeta);
+
+  protected:
+    bool UsesConnection() override;
+    void Execute() override;
+    Napi::Value Result() override;
+
+  private:
+    std::u16string functionName;
+    bool refreshMeta;
+    RFC_FUNCTION_DESC_HANDLE functionDescHandle{};
+    Napi::ObjectReference cached;
+};
+
+#endif //SAPNWRFC_CONNECTIONLOOKUP_H
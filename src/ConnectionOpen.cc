@@ -24,17 +24,25 @@ SOFTWARE.
 */
 
 #include "ConnectionOpen.h"
+#include "ResultCache.h"
 #include "Utils.h"
 #include <sapnwrfc.h>
 
-ConnectionOpen::ConnectionOpen(const Napi::Function &callback, Connection *connection)
-    : AsyncWorker{callback}, connection{connection} {}
+ConnectionOpen::ConnectionOpen(const Napi::Function &callback, Connection *connection,
+                               RFC_CONNECTION_PARAMETER *params, unsigned int paramsSize)
+    : RfcWorker{callback.Env(), callback, *connection->queue}, connection{connection}, params{params},
+      paramsSize{paramsSize} {}
 
 void ConnectionOpen::Execute() {
-  connection->connectionHandle = RfcOpenConnection(connection->loginParams,
-                                                   connection->loginParamsSize,
-                                                   &connection->errorInfo);
-  DEFER_LOG_API(connection, "RfcOpenConnection");
+  if (IsCancelled()) {
+    SetError("Call cancelled");
+    return;
+  }
+
+  connection->LockMutex();
+
+  connection->Reopen(connection->errorInfo, params, paramsSize);
+  params = nullptr;
   if (!connection->connectionHandle) {
     SetError("Connection handle is NULL, connection failed");
   } else {
@@ -46,14 +54,43 @@ void ConnectionOpen::Execute() {
       SetError("Connection not valid");
     } else {
       connection->deferLog(Loggable::Levels::SILLY, "Connection still valid");
+      RFC_ERROR_INFO attributesErrorInfo{};
+      RfcGetConnectionAttributes(connection->connectionHandle, &attributes, &attributesErrorInfo);
     }
   }
+
+  // Opening cannot be interrupted, an abandoned or late connection is closed right away
+  auto handle = IsCancelled() ? connection->connectionHandle.exchange(nullptr) : nullptr;
+  if (handle != nullptr) {
+    RfcCloseConnection(handle, &connection->errorInfo);
+    DEFER_LOG_API(connection, "RfcCloseConnection");
+    SetError("Call cancelled");
+  }
+
+  connection->UnlockMutex();
+}
+
+void ConnectionOpen::OnOK() {
+  connection->logonKey = ResultCache::LogonKey(attributes);
+  RfcWorker::OnOK();
 }
 
 void ConnectionOpen::OnError(const Napi::Error &e) {
-  Callback().Call({RfcError(Env(), connection->errorInfo).Value()});
+  Callback().Call({IsCancelled() ? e.Value() : RfcError(Env(), connection->errorInfo).Value()});
+}
+
+void ConnectionOpen::OnTimeout() {
+  Napi::HandleScope scope{Env()};
+
+  auto error = TimeoutError(Env(), Timeout());
+  error.Set("connection", connection->LogonInfo(Env()));
+  connection->log(Env(), Loggable::Levels::WARN, "Connection::Open: Call timed out", error.Value());
+
+  OnError(error);
 }
 
 ConnectionOpen::~ConnectionOpen() {
+  // Not taken over if the worker was cancelled before it was executed
+  Connection::FreeLoginParams(params, paramsSize);
   connection->Reference::Unref();
 }
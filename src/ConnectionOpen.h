@@ -28,24 +28,32 @@ SOFTWARE.
 
 #include <napi.h>
 #include "Connection.h"
+#include "RfcWorker.h"
 
-class ConnectionOpen : public Napi::AsyncWorker {
+class ConnectionOpen : public RfcWorker {
   public:
-    ConnectionOpen(const Napi::Function &callback, Connection *connection);
+    /*
+     * Takes over the logon parameters, which replace those of the connection when it is opened.
+     */
+    ConnectionOpen(const Napi::Function &callback, Connection *connection, RFC_CONNECTION_PARAMETER *params,
+                   unsigned int paramsSize);
     ConnectionOpen(const ConnectionOpen &) = delete;
     ConnectionOpen &operator=(const ConnectionOpen &) = delete;
-    ConnectionOpen(ConnectionOpen &&) = default;
-    ConnectionOpen &operator=(ConnectionOpen &&) = default;
 
     ~ConnectionOpen() override;
 
-  protected:
     void Execute() override;
 
+  protected:
+    void OnOK() override;
     void OnError(const Napi::Error &e) override;
+    void OnTimeout() override;
 
   private:
     Connection *connection;
+    RFC_CONNECTION_PARAMETER *params;
+    unsigned int paramsSize;
+    RFC_ATTRIBUTES attributes{};
 };
 
 
@@ -0,0 +1,685 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "ConnectionPool.h"
+#include "AddonData.h"
+#include "ConnectionIsOpen.h"
+#include "ConnectionClose.h"
+#include "ConnectionLookup.h"
+#include "PoolFanOut.h"
+#include "Utils.h"
+#include <algorithm>
+
+static uint32_t uint32Option(Napi::Env env, Napi::Object options, const char *name, uint32_t defaultValue) {
+  auto value = options.Get(name);
+  if (value.IsUndefined()) {
+    return defaultValue;
+  }
+  if (!value.IsNumber() || value.As<Napi::Number>().DoubleValue() < 0) {
+    throw Napi::TypeError::New(env, std::string("Option ") + name + " must be a non-negative number");
+  }
+  return value.As<Napi::Number>().Uint32Value();
+}
+
+static void noop(const Napi::CallbackInfo &) {}
+
+/**
+ * new ConnectionPool(connectionParams[, {min, max, idleTimeout}])
+ */
+ConnectionPool::ConnectionPool(const Napi::CallbackInfo &info)
+    : Napi::ObjectWrap<ConnectionPool>(info) {
+  auto env = info.Env();
+  init(Value());
+
+  if (info.Length() < 1 || !info[0].IsObject()) {
+    throw Napi::TypeError::New(env, "Argument 1 must be an object");
+  }
+  if (info.Length() > 1 && !info[1].IsUndefined() && !info[1].IsObject()) {
+    throw Napi::TypeError::New(env, "Argument 2 must be an object");
+  }
+
+  // Later changes of the caller's object must not affect connections opened later on
+  auto params = info[0].ToObject();
+  auto copy = Napi::Object::New(env);
+  auto names = params.GetPropertyNames();
+  for (uint32_t i = 0; i < names.Length(); i++) {
+    copy.Set(names.Get(i), params.Get(names.Get(i)));
+  }
+  connectionParams = Napi::Persistent(copy);
+
+  if (info.Length() > 1 && info[1].IsObject()) {
+    auto options = info[1].ToObject();
+    min = uint32Option(env, options, "min", min);
+    max = uint32Option(env, options, "max", max);
+    idleTimeout = uint32Option(env, options, "idleTimeout", idleTimeout);
+  }
+  if (max < 1 || min > max) {
+    throw Napi::RangeError::New(env, "Pool size must satisfy 0 <= min <= max and max >= 1");
+  }
+
+  log(env, Levels::SILLY, "ConnectionPool::ConnectionPool");
+}
+
+ConnectionPool::~ConnectionPool() {
+  deferLog(Levels::SILLY, "ConnectionPool::~ConnectionPool");
+  StopEvictionTimer();
+}
+
+Napi::Object ConnectionPool::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "ConnectionPool", {
+      InstanceMethod("Open", &ConnectionPool::Open),
+      InstanceMethod("Acquire", &ConnectionPool::Acquire),
+      InstanceMethod("Release", &ConnectionPool::Release),
+      InstanceMethod("Close", &ConnectionPool::Close),
+      InstanceMethod("Stats", &ConnectionPool::Stats),
+      InstanceMethod("FanOut", &ConnectionPool::FanOut),
+      InstanceMethod("WarmUp", &ConnectionPool::WarmUp)
+  });
+
+  AddonData::Get(env).connectionPoolCtor = Napi::Persistent(func);
+  exports.Set("ConnectionPool", func);
+  return exports;
+}
+
+/**
+ * Open([callback]): opens min connections, callback(err) is called when all of them are open.
+ */
+Napi::Value ConnectionPool::Open(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::HandleScope scope{env};
+  log(env, Levels::SILLY, "ConnectionPool::Open");
+
+  if (info.Length() > 0 && !info[0].IsUndefined() && !info[0].IsFunction()) {
+    throw Napi::TypeError::New(env, "Argument 1 must be a function");
+  }
+  if (isOpen || isClosed) {
+    throw Napi::Error::New(env, "Connection pool has already been opened");
+  }
+
+  isOpen = true;
+  // An open pool stays alive until it is closed
+  Reference::Ref();
+  StartEvictionTimer(env);
+
+  openPending = min;
+  if (info.Length() > 0 && info[0].IsFunction()) {
+    openCallback = Napi::Persistent(info[0].As<Napi::Function>());
+  }
+  if (openPending == 0) {
+    if (!openCallback.IsEmpty()) {
+      openCallback.Call({});
+      openCallback.Reset();
+    }
+  } else {
+    for (uint32_t i = 0; i < min; i++) {
+      OpenConnection(env, true);
+    }
+  }
+
+  return env.Undefined();
+}
+
+/**
+ * Acquire(callback): callback(err, connection) receives an open connection which must be
+ * given back with Release().
+ */
+Napi::Value ConnectionPool::Acquire(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::HandleScope scope{env};
+  log(env, Levels::SILLY, "ConnectionPool::Acquire");
+
+  if (info.Length() != 1 || !info[0].IsFunction()) {
+    throw Napi::TypeError::New(env, "Argument 1 must be a function");
+  }
+  if (!isOpen) {
+    throw Napi::Error::New(env, isClosed ? "Connection pool closed" : "Connection pool is not open");
+  }
+
+  waiting.emplace_back(Napi::Persistent(info[0].As<Napi::Function>()));
+  Dispatch(env);
+  return env.Undefined();
+}
+
+/**
+ * Release(connection[, discard]): gives a leased connection back, a discarded connection is closed.
+ */
+Napi::Value ConnectionPool::Release(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::HandleScope scope{env};
+  log(env, Levels::SILLY, "ConnectionPool::Release");
+
+  if (info.Length() < 1 || !info[0].IsObject() || !info[0].ToObject().InstanceOf(AddonData::Get(env).connectionCtor.Value())) {
+    throw Napi::TypeError::New(env, "Argument 1 must be a connection");
+  }
+
+  auto connection = Napi::ObjectWrap<Connection>::Unwrap(info[0].ToObject());
+  if (leased.count(connection) == 0) {
+    throw Napi::Error::New(env, "Connection is not leased from this pool");
+  }
+
+  ReleaseConnection(env, connection, info.Length() > 1 && info[1].ToBoolean());
+  return env.Undefined();
+}
+
+/**
+ * Close(): fails all waiting Acquire() calls and closes idle connections. Leased connections
+ * are closed when they are released.
+ */
+Napi::Value ConnectionPool::Close(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::HandleScope scope{env};
+  log(env, Levels::SILLY, "ConnectionPool::Close");
+
+  if (isClosed) {
+    return env.Undefined();
+  }
+  isClosed = true;
+  StopEvictionTimer();
+
+  while (!idle.empty()) {
+    auto connection = idle.front().connection;
+    idle.pop_front();
+    Discard(env, connection);
+  }
+
+  std::deque<Napi::FunctionReference> failed;
+  failed.swap(waiting);
+  if (isOpen) {
+    isOpen = false;
+    Reference::Unref();
+  }
+
+  for (auto &callback : failed) {
+    callback.Call({ClosedError(env)});
+  }
+
+  return env.Undefined();
+}
+
+/**
+ * @return Object with pool size and counters
+ */
+Napi::Value ConnectionPool::Stats(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+
+  auto stats = Napi::Object::New(env);
+  stats.Set("size", Napi::Number::New(env, connections.size()));
+  stats.Set("idle", Napi::Number::New(env, idle.size()));
+  stats.Set("leased", Napi::Number::New(env, leased.size()));
+  stats.Set("opening", Napi::Number::New(env, opening));
+  stats.Set("waiting", Napi::Number::New(env, waiting.size()));
+  stats.Set("min", Napi::Number::New(env, min));
+  stats.Set("max", Napi::Number::New(env, max));
+  stats.Set("opened", Napi::Number::New(env, openedCount));
+  stats.Set("failed", Napi::Number::New(env, failedCount));
+  stats.Set("acquired", Napi::Number::New(env, acquiredCount));
+  stats.Set("evicted", Napi::Number::New(env, evictedCount));
+  stats.Set("discarded", Napi::Number::New(env, discardedCount));
+  return scope.Escape(stats);
+}
+
+/**
+ * FanOut(functionName, params, {table, chunkSize[, parallel][, timeout][, idempotent][, progress]}, callback):
+ * invokes the function module once per chunkSize rows of the table parameter, on up to parallel
+ * pooled connections at a time. callback(err, merged, chunkResults) is called when all chunks are
+ * done or after the first error, whose chunk property names the failed chunk.
+ */
+Napi::Value ConnectionPool::FanOut(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::HandleScope scope{env};
+  log(env, Levels::SILLY, "ConnectionPool::FanOut");
+
+  if (info.Length() != 4) {
+    throw Napi::Error::New(env, "Function expects 4 arguments");
+  }
+  if (!info[0].IsString()) {
+    throw Napi::TypeError::New(env, "Argument 1 must be function module name");
+  }
+  if (!info[1].IsObject()) {
+    throw Napi::TypeError::New(env, "Argument 2 must be an object");
+  }
+  if (!info[2].IsObject()) {
+    throw Napi::TypeError::New(env, "Argument 3 must be an object");
+  }
+  if (!info[3].IsFunction()) {
+    throw Napi::TypeError::New(env, "Argument 4 must be a function");
+  }
+  if (!isOpen) {
+    throw Napi::Error::New(env, isClosed ? "Connection pool closed" : "Connection pool is not open");
+  }
+
+  auto params = info[1].ToObject();
+  auto options = info[2].ToObject();
+  auto table = options.Get("table");
+  if (!table.IsString() || !params.Get(table).IsArray()) {
+    throw Napi::TypeError::New(env, "Option table must name a table parameter given as array");
+  }
+  auto chunkSize = uint32Option(env, options, "chunkSize", 0);
+  if (chunkSize == 0) {
+    throw Napi::RangeError::New(env, "Option chunkSize must be at least 1");
+  }
+  auto parallel = uint32Option(env, options, "parallel", max);
+  if (parallel == 0) {
+    throw Napi::RangeError::New(env, "Option parallel must be at least 1");
+  }
+  uint32Option(env, options, "timeout", 0);
+  auto progress = options.Get("progress");
+  if (!progress.IsUndefined() && !progress.IsFunction()) {
+    throw Napi::TypeError::New(env, "Option progress must be a function");
+  }
+
+  auto fanOut = new PoolFanOut{env, this, info[0].ToString().Utf16Value(), params, table.ToString().Utf8Value(),
+                               chunkSize, parallel, options, info[3].As<Napi::Function>()};
+  fanOut->Start();
+  return env.Undefined();
+}
+
+/*
+ * Progress of a WarmUp() call, shared by the callbacks of its connections and lookups.
+ */
+struct WarmUpState {
+  typedef std::chrono::steady_clock Clock;
+
+  Napi::FunctionReference callback;
+  std::vector<std::u16string> functions;
+  Napi::ObjectReference error;
+  uint32_t pending{};
+  uint32_t opened{};
+  uint32_t failed{};
+  uint32_t fetched{};
+  Napi::ObjectReference lookupErrors;
+  Clock::time_point start{Clock::now()};
+  Clock::time_point connected{};
+  Clock::time_point prefetched{};
+
+  static double Millis(Clock::time_point from, Clock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+  }
+};
+
+/**
+ * WarmUp({connections, functions}, callback): opens connections until the pool holds the given
+ * number of them (at most max), all at once on the executor, then fetches the descriptors of the
+ * function modules. callback(err, report) receives the timing of both phases, err is the first
+ * error of either phase.
+ */
+Napi::Value ConnectionPool::WarmUp(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::HandleScope scope{env};
+  log(env, Levels::SILLY, "ConnectionPool::WarmUp");
+
+  if (info.Length() != 2) {
+    throw Napi::Error::New(env, "Function expects 2 arguments");
+  }
+  if (!info[0].IsObject()) {
+    throw Napi::TypeError::New(env, "Argument 1 must be an object");
+  }
+  if (!info[1].IsFunction()) {
+    throw Napi::TypeError::New(env, "Argument 2 must be a function");
+  }
+  if (!isOpen) {
+    throw Napi::Error::New(env, isClosed ? "Connection pool closed" : "Connection pool is not open");
+  }
+
+  auto options = info[0].ToObject();
+  auto count = std::min(uint32Option(env, options, "connections", min), max);
+  auto state = std::make_shared<WarmUpState>();
+  auto functions = options.Get("functions");
+  if (!functions.IsUndefined()) {
+    if (!functions.IsArray()) {
+      throw Napi::TypeError::New(env, "Option functions must be an array of function module names");
+    }
+    auto names = functions.As<Napi::Array>();
+    for (uint32_t i = 0; i < names.Length(); i++) {
+      if (!names.Get(i).IsString()) {
+        throw Napi::TypeError::New(env, "Option functions must be an array of function module names");
+      }
+      state->functions.push_back(names.Get(i).ToString().Utf16Value());
+    }
+  }
+  state->callback = Napi::Persistent(info[1].As<Napi::Function>());
+  state->lookupErrors = Napi::Persistent(Napi::Object::New(env));
+
+  // The pool must be alive until the warm-up has finished
+  Reference::Ref();
+
+  auto missing = count > connections.size() ? count - static_cast<uint32_t>(connections.size()) : 0;
+  state->pending = missing;
+  if (missing == 0) {
+    state->connected = WarmUpState::Clock::now();
+    PrefetchFunctions(env, state);
+    return env.Undefined();
+  }
+
+  for (uint32_t i = 0; i < missing; i++) {
+    OpenConnection(env, false, [this, state](Napi::Env env, Napi::Value error) {
+      if (error.IsUndefined() || error.IsNull()) {
+        state->opened++;
+      } else {
+        state->failed++;
+        if (state->error.IsEmpty()) {
+          state->error = Napi::Persistent(error.ToObject());
+        }
+      }
+      if (--state->pending == 0) {
+        state->connected = WarmUpState::Clock::now();
+        PrefetchFunctions(env, state);
+      }
+    });
+  }
+  return env.Undefined();
+}
+
+/*
+ * Descriptors are cached by the SDK per system, so each of them is fetched once, spread over up to
+ * one lease per open connection. The connections are acquired like by any other caller and released
+ * when their lookups are done, so that they are not handed out meanwhile.
+ */
+void ConnectionPool::PrefetchFunctions(Napi::Env env, std::shared_ptr<WarmUpState> state) {
+  if (state->functions.empty() || connections.empty() || isClosed) {
+    if (!state->functions.empty() && state->error.IsEmpty()) {
+      state->error = Napi::Persistent(Napi::Error::New(env, "No open connection to fetch function descriptors").Value());
+    }
+    state->prefetched = WarmUpState::Clock::now();
+    FinishWarmUp(env, state);
+    return;
+  }
+
+  state->pending = static_cast<uint32_t>(state->functions.size());
+  auto leases = std::min(state->functions.size(), connections.size());
+  for (size_t lease = 0; lease < leases; lease++) {
+    auto acquired = Napi::Function::New(env, [this, state, lease, leases](const Napi::CallbackInfo &info) {
+      auto env = info.Env();
+      std::vector<std::u16string> names;
+      for (size_t i = lease; i < state->functions.size(); i += leases) {
+        names.push_back(state->functions[i]);
+      }
+
+      auto error = info.Length() > 0 ? info[0] : env.Undefined();
+      if (!error.IsUndefined() && !error.IsNull()) {
+        for (auto &name : names) {
+          OnPrefetched(env, state, name, error);
+        }
+        return;
+      }
+
+      auto connection = Napi::ObjectWrap<Connection>::Unwrap(info[1].ToObject());
+      auto remaining = std::make_shared<size_t>(names.size());
+      for (auto &name : names) {
+        auto done = Napi::Function::New(env, [this, state, name, connection, remaining](const Napi::CallbackInfo &info) {
+          auto env = info.Env();
+          if (--*remaining == 0) {
+            ReleaseConnection(env, connection, false);
+          }
+          OnPrefetched(env, state, name, info.Length() > 0 ? info[0] : env.Undefined());
+        });
+        (new ConnectionLookup{env, done, connection, name, false})->Queue();
+      }
+    });
+    waiting.emplace_back(Napi::Persistent(acquired));
+  }
+  Dispatch(env);
+}
+
+void ConnectionPool::OnPrefetched(Napi::Env env, std::shared_ptr<WarmUpState> state, const std::u16string &name,
+                                  Napi::Value error) {
+  if (error.IsUndefined() || error.IsNull()) {
+    state->fetched++;
+  } else {
+    state->lookupErrors.Value().Set(Napi::String::New(env, name), error);
+    if (state->error.IsEmpty()) {
+      state->error = Napi::Persistent(error.ToObject());
+    }
+  }
+  if (--state->pending == 0) {
+    state->prefetched = WarmUpState::Clock::now();
+    FinishWarmUp(env, state);
+  }
+}
+
+void ConnectionPool::FinishWarmUp(Napi::Env env, std::shared_ptr<WarmUpState> state) {
+  Napi::HandleScope scope{env};
+
+  auto report = Napi::Object::New(env);
+  auto connectionPhase = Napi::Object::New(env);
+  connectionPhase.Set("opened", Napi::Number::New(env, state->opened));
+  connectionPhase.Set("failed", Napi::Number::New(env, state->failed));
+  connectionPhase.Set("size", Napi::Number::New(env, connections.size()));
+  connectionPhase.Set("millis", Napi::Number::New(env, WarmUpState::Millis(state->start, state->connected)));
+  report.Set("connections", connectionPhase);
+
+  auto functionPhase = Napi::Object::New(env);
+  functionPhase.Set("fetched", Napi::Number::New(env, state->fetched));
+  functionPhase.Set("errors", state->lookupErrors.Value());
+  functionPhase.Set("millis", Napi::Number::New(env, WarmUpState::Millis(state->connected, state->prefetched)));
+  report.Set("functions", functionPhase);
+  report.Set("millis", Napi::Number::New(env, WarmUpState::Millis(state->start, state->prefetched)));
+
+  log(env, Levels::VERBOSE, "ConnectionPool::WarmUp: finished", report);
+
+  auto callback = std::move(state->callback);
+  auto error = state->error.IsEmpty() ? env.Undefined() : state->error.Value();
+  Reference::Unref();
+  callback.Call({error, report});
+}
+
+/*
+ * Hands idle connections to waiting callers and opens new connections while below max.
+ */
+void ConnectionPool::Dispatch(Napi::Env env) {
+  while (!waiting.empty()) {
+    if (!idle.empty()) {
+      // Most recently used first, so that surplus connections age and get evicted
+      auto connection = idle.back().connection;
+      idle.pop_back();
+      leased.insert(connection);
+
+      auto leaseId = nextLeaseId++;
+      validating.emplace(leaseId, std::move(waiting.front()));
+      waiting.pop_front();
+
+      Reference::Ref();
+      auto done = Napi::Function::New(env, [this, connection, leaseId](const Napi::CallbackInfo &info) {
+        OnValidated(info.Env(), connection, leaseId, info.Length() > 1 && info[1].ToBoolean());
+      });
+      (new ConnectionIsOpen{env, done, connection})->Queue();
+    } else if (connections.size() < max && opening < waiting.size()) {
+      OpenConnection(env, false);
+    } else {
+      break;
+    }
+  }
+}
+
+void ConnectionPool::OpenConnection(Napi::Env env, bool initial, OpenedCallback opened) {
+  auto obj = AddonData::Get(env).connectionCtor.New({});
+  auto connection = Napi::ObjectWrap<Connection>::Unwrap(obj);
+  connections.emplace(connection, Napi::Persistent(obj));
+  opening++;
+
+  Reference::Ref();
+  auto done = Napi::Function::New(env, [this, connection, initial, opened](const Napi::CallbackInfo &info) {
+    OnOpened(info.Env(), connection, initial, info.Length() > 0 ? info[0] : info.Env().Undefined(), opened);
+  });
+
+  try {
+    obj.Get("Open").As<Napi::Function>().Call(obj, {connectionParams.Value(), done});
+  } catch (const Napi::Error &e) {
+    OnOpened(env, connection, initial, e.Value(), opened);
+  }
+}
+
+void ConnectionPool::OnOpened(Napi::Env env, Connection *connection, bool initial, Napi::Value error,
+                              const OpenedCallback &opened) {
+  Napi::HandleScope scope{env};
+  opening--;
+
+  bool failed = !error.IsUndefined() && !error.IsNull();
+  if (failed) {
+    log(env, Levels::DBG, "ConnectionPool::OnOpened: Opening pooled connection failed", error);
+    connections.erase(connection);
+    failedCount++;
+  } else {
+    openedCount++;
+    if (isClosed) {
+      Discard(env, connection);
+    } else {
+      idle.push_back({connection, std::chrono::steady_clock::now()});
+    }
+  }
+
+  if (opened) {
+    opened(env, error);
+  } else if (initial && openPending > 0) {
+    if (failed && openError.IsEmpty()) {
+      openError = Napi::Persistent(error.ToObject());
+    }
+    if (--openPending == 0 && !openCallback.IsEmpty()) {
+      auto callback = std::move(openCallback);
+      auto err = openError.IsEmpty() ? env.Undefined() : openError.Value();
+      openError.Reset();
+      callback.Call({err});
+    }
+  } else if (failed && !waiting.empty()) {
+    // Report to the longest waiting caller instead of retrying forever
+    auto callback = std::move(waiting.front());
+    waiting.pop_front();
+    callback.Call({error});
+  }
+
+  Dispatch(env);
+  Reference::Unref();
+}
+
+void ConnectionPool::OnValidated(Napi::Env env, Connection *connection, uint32_t leaseId, bool isValid) {
+  Napi::HandleScope scope{env};
+
+  auto it = validating.find(leaseId);
+  auto callback = std::move(it->second);
+  validating.erase(it);
+
+  if (!isValid || isClosed) {
+    leased.erase(connection);
+    Discard(env, connection);
+    if (isClosed) {
+      callback.Call({ClosedError(env)});
+    } else {
+      log(env, Levels::DBG, "ConnectionPool::OnValidated: Discarding invalid connection");
+      waiting.emplace_front(std::move(callback));
+      Dispatch(env);
+    }
+  } else {
+    acquiredCount++;
+    callback.Call({env.Undefined(), connections[connection].Value()});
+  }
+
+  Reference::Unref();
+}
+
+void ConnectionPool::ReleaseConnection(Napi::Env env, Connection *connection, bool discard) {
+  leased.erase(connection);
+  if (discard || isClosed) {
+    Discard(env, connection);
+  } else {
+    idle.push_back({connection, std::chrono::steady_clock::now()});
+  }
+
+  Dispatch(env);
+}
+
+/*
+ * Removes the connection from the pool and closes it in the background.
+ */
+void ConnectionPool::Discard(Napi::Env env, Connection *connection) {
+  auto it = connections.find(connection);
+  if (it == connections.end()) {
+    return;
+  }
+  discardedCount++;
+  // The worker keeps the connection alive until it is closed
+  (new ConnectionClose{env, Napi::Function::New(env, noop), connection})->Queue();
+  connections.erase(it);
+}
+
+void ConnectionPool::EvictIdle(Napi::Env env) {
+  auto now = std::chrono::steady_clock::now();
+  auto timeout = std::chrono::milliseconds(idleTimeout);
+
+  // The oldest idle connections are at the front
+  while (!idle.empty() && connections.size() > min && now - idle.front().since >= timeout) {
+    auto connection = idle.front().connection;
+    idle.pop_front();
+    evictedCount++;
+    Discard(env, connection);
+  }
+}
+
+Napi::Value ConnectionPool::ClosedError(Napi::Env env) {
+  return Napi::Error::New(env, "Connection pool closed").Value();
+}
+
+void ConnectionPool::StartEvictionTimer(Napi::Env env) {
+  if (idleTimeout == 0) {
+    return;
+  }
+
+  uv_loop_t *loop{};
+  napi_get_uv_event_loop(env, &loop);
+
+  uint64_t interval = idleTimeout / 2 + 1;
+  evictionTimer = new uv_timer_t;
+  uv_timer_init(loop, evictionTimer);
+  evictionTimer->data = this;
+  uv_timer_start(evictionTimer, OnEvictionTimer, interval, interval);
+  // Idle connections must not keep the process running
+  uv_unref(reinterpret_cast<uv_handle_t *>(evictionTimer));
+}
+
+void ConnectionPool::StopEvictionTimer() {
+  if (evictionTimer != nullptr) {
+    uv_timer_stop(evictionTimer);
+    uv_close(reinterpret_cast<uv_handle_t *>(evictionTimer), [](uv_handle_t *handle) {
+      delete reinterpret_cast<uv_timer_t *>(handle);
+    });
+    evictionTimer = nullptr;
+  }
+}
+
+void ConnectionPool::OnEvictionTimer(uv_timer_t *timer) {
+  auto self = static_cast<ConnectionPool *>(timer->data);
+  auto env = self->Env();
+  Napi::HandleScope scope{env};
+  try {
+    self->EvictIdle(env);
+  } catch (const Napi::Error &e) {
+    self->deferLog(Levels::DBG, "ConnectionPool::OnEvictionTimer: " + std::string(e.what()));
+  }
+}
+
+void ConnectionPool::addObjectInfoToLogMeta(Napi::Object meta) {
+  char ptr[2 + sizeof(void *) * 2 + 1]; // optional "0x" + each byte of pointer represented by 2 digits + terminator
+  snprintf(ptr, 2 + sizeof(void *) * 2 + 1, "%p", this);
+  meta.Set("nativeConnectionPool", ptr);
+}
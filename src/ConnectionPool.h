@@ -0,0 +1,128 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef SAPNWRFC_CONNECTIONPOOL_H
+#define SAPNWRFC_CONNECTIONPOOL_H
+
+#include "Loggable.h"
+#include <uv.h>
+#include <sapnwrfc.h>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include "Connection.h"
+
+struct WarmUpState;
+
+/*
+ * Keeps a set of open connections, each of them leased to at most one user at a time. Idle
+ * connections are validated when they are handed out and closed after idleTimeout as long as
+ * more than min connections are open. If max connections are in use, Acquire() waits in a FIFO.
+ */
+class ConnectionPool : public Loggable, public Napi::ObjectWrap<ConnectionPool> {
+    friend class PoolFanOut;
+
+  public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+
+    explicit ConnectionPool(const Napi::CallbackInfo &info);
+    ~ConnectionPool();
+
+    RFC_ERROR_INFO errorInfo{};
+
+  protected:
+    Napi::Value Open(const Napi::CallbackInfo &info);
+    Napi::Value Acquire(const Napi::CallbackInfo &info);
+    Napi::Value Release(const Napi::CallbackInfo &info);
+    Napi::Value Close(const Napi::CallbackInfo &info);
+    Napi::Value Stats(const Napi::CallbackInfo &info);
+    Napi::Value FanOut(const Napi::CallbackInfo &info);
+    Napi::Value WarmUp(const Napi::CallbackInfo &info);
+
+    void Dispatch(Napi::Env env);
+    typedef std::function<void(Napi::Env env, Napi::Value error)> OpenedCallback;
+
+    /*
+     * Opens a connection on the executor. Errors are reported to Open(), to the opened callback
+     * or else to the longest waiting Acquire().
+     */
+    void OpenConnection(Napi::Env env, bool initial, OpenedCallback opened = nullptr);
+    void OnOpened(Napi::Env env, Connection *connection, bool initial, Napi::Value error,
+                  const OpenedCallback &opened);
+    void PrefetchFunctions(Napi::Env env, std::shared_ptr<WarmUpState> state);
+    void OnPrefetched(Napi::Env env, std::shared_ptr<WarmUpState> state, const std::u16string &name,
+                      Napi::Value error);
+    void FinishWarmUp(Napi::Env env, std::shared_ptr<WarmUpState> state);
+    void OnValidated(Napi::Env env, Connection *connection, uint32_t leaseId, bool isValid);
+    void ReleaseConnection(Napi::Env env, Connection *connection, bool discard);
+    void Discard(Napi::Env env, Connection *connection);
+    void EvictIdle(Napi::Env env);
+    Napi::Value ClosedError(Napi::Env env);
+
+    void StartEvictionTimer(Napi::Env env);
+    void StopEvictionTimer();
+    static void OnEvictionTimer(uv_timer_t *timer);
+
+    void addObjectInfoToLogMeta(Napi::Object meta) override;
+
+
+    struct IdleConnection {
+      Connection *connection;
+      std::chrono::steady_clock::time_point since;
+    };
+
+    Napi::ObjectReference connectionParams;
+    uint32_t min{};
+    uint32_t max{10};
+    uint32_t idleTimeout{60000};
+
+    bool isOpen{};
+    bool isClosed{};
+
+    // All connections of the pool, regardless of their state
+    std::unordered_map<Connection *, Napi::ObjectReference> connections;
+    std::deque<IdleConnection> idle;
+    std::unordered_set<Connection *> leased;
+    std::deque<Napi::FunctionReference> waiting;
+    std::unordered_map<uint32_t, Napi::FunctionReference> validating;
+    uint32_t nextLeaseId{};
+    uint32_t opening{};
+
+    Napi::FunctionReference openCallback;
+    Napi::ObjectReference openError;
+    uint32_t openPending{};
+
+    uv_timer_t *evictionTimer{};
+
+    uint64_t openedCount{};
+    uint64_t failedCount{};
+    uint64_t acquiredCount{};
+    uint64_t evictedCount{};
+    uint64_t discardedCount{};
+};
+
+#endif //SAPNWRFC_CONNECTIONPOOL_H
@@ -0,0 +1,86 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "ConnectionWorker.h"
+#include "Utils.h"
+
+ConnectionWorker::ConnectionWorker(Napi::Env env, const Napi::Value &callback, Connection *connection)
+    : ConnectionWorker{env, callback, connection, *connection->queue} {
+}
+
+ConnectionWorker::ConnectionWorker(Napi::Env env, const Napi::Value &callback, Connection *connection,
+                                   RfcQueue &queue)
+    : RfcWorker{env, callback.IsFunction() ? callback.As<Napi::Function>() : Napi::Function(), queue},
+      connection{connection}, hasCallback{callback.IsFunction()},
+      deferred{Napi::Promise::Deferred::New(env)} {
+  // The connection must be alive when the worker completes
+  connection->Reference::Ref();
+}
+
+ConnectionWorker::~ConnectionWorker() {
+  connection->Reference::Unref();
+}
+
+Napi::Value ConnectionWorker::Promise() {
+  if (hasCallback) {
+    return Env().Undefined();
+  }
+  return deferred.Promise();
+}
+
+void ConnectionWorker::OnOK() {
+  Napi::HandleScope scope{Env()};
+  connection->logDeferred(Env());
+
+  Napi::Value result;
+  try {
+    result = Result();
+  } catch (const Napi::Error &e) {
+    Reject(e.Value());
+    return;
+  }
+  Resolve(result);
+}
+
+void ConnectionWorker::OnError(const Napi::Error &e) {
+  Napi::HandleScope scope{Env()};
+  connection->logDeferred(Env());
+  Reject(RfcError(Env(), errorInfo).Value());
+}
+
+void ConnectionWorker::Resolve(Napi::Value result) {
+  if (hasCallback) {
+    Callback().Call({Env().Undefined(), result});
+  } else {
+    deferred.Resolve(result);
+  }
+}
+
+void ConnectionWorker::Reject(Napi::Value error) {
+  if (hasCallback) {
+    Callback().Call({error});
+  } else {
+    deferred.Reject(error);
+  }
+}
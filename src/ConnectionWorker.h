@@ -0,0 +1,74 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef SAPNWRFC_CONNECTIONWORKER_H
+#define SAPNWRFC_CONNECTIONWORKER_H
+
+#include <napi.h>
+#include "Connection.h"
+#include "RfcWorker.h"
+
+/*
+ * Base class of asynchronous connection operations. The result is either passed to a callback
+ * as callback(err, result) or, if no callback is given, used to settle a Promise.
+ */
+class ConnectionWorker : public RfcWorker {
+  public:
+    ConnectionWorker(Napi::Env env, const Napi::Value &callback, Connection *connection);
+
+    /*
+     * Runs on another queue than the connection's, for work which needs no connection.
+     */
+    ConnectionWorker(Napi::Env env, const Napi::Value &callback, Connection *connection, RfcQueue &queue);
+    ConnectionWorker(const ConnectionWorker &) = delete;
+    ConnectionWorker &operator=(const ConnectionWorker &) = delete;
+
+    ~ConnectionWorker() override;
+
+    /*
+     * @return Promise if no callback was given, else undefined
+     */
+    Napi::Value Promise();
+
+  protected:
+    void OnOK() override;
+    void OnError(const Napi::Error &e) override;
+
+    /*
+     * Creates the result on the main thread.
+     */
+    virtual Napi::Value Result() = 0;
+
+    void Resolve(Napi::Value result);
+    void Reject(Napi::Value error);
+
+    Connection *connection;
+    RFC_ERROR_INFO errorInfo{};
+
+  private:
+    bool hasCallback;
+    Napi::Promise::Deferred deferred;
+};
+
+#endif //SAPNWRFC_CONNECTIONWORKER_H
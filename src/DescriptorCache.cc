@@ -0,0 +1,741 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#include "DescriptorCache.h"
+#include "AddonData.h"
+#include "FileSystem.h"
+#include "Function.h"
+#include "Utils.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char Magic[8] = {'N', 'W', 'R', 'F', 'C', 'D', 'C', '1'};
+const uint32_t Version = 1;
+const uint32_t ByteOrderMark = 0x01020304;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint64_t timestamp;
+  uint64_t payloadLength;
+  uint64_t checksum;
+};
+
+uint64_t Fnv1a(const uint8_t *data, size_t size) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= data[i];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+/*
+ * Read-only mapping of a whole file, shared with every other process mapping it.
+ */
+class MappedFile {
+  public:
+    MappedFile() = default;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    ~MappedFile() {
+#ifdef _WIN32
+      if (data) {
+        UnmapViewOfFile(data);
+      }
+      if (mapping) {
+        CloseHandle(mapping);
+      }
+      if (file != INVALID_HANDLE_VALUE) {
+        CloseHandle(file);
+      }
+#else
+      if (data) {
+        munmap(const_cast<uint8_t *>(data), size);
+      }
+      if (fd >= 0) {
+        close(fd);
+      }
+#endif
+    }
+
+    // Returns false if the file does not exist or cannot be mapped
+    bool Open(const NativePath &path) {
+#ifdef _WIN32
+      file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                         FILE_ATTRIBUTE_NORMAL, nullptr);
+      if (file == INVALID_HANDLE_VALUE) {
+        return false;
+      }
+      LARGE_INTEGER fileSize;
+      if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        return false;
+      }
+      size = static_cast<size_t>(fileSize.QuadPart);
+      mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (!mapping) {
+        return false;
+      }
+      data = static_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+      return data != nullptr;
+#else
+      fd = open(path.c_str(), O_RDONLY);
+      if (fd < 0) {
+        return false;
+      }
+      struct stat st{};
+      if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        return false;
+      }
+      size = static_cast<size_t>(st.st_size);
+      auto address = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+      if (address == MAP_FAILED) {
+        return false;
+      }
+      data = static_cast<const uint8_t *>(address);
+      return true;
+#endif
+    }
+
+    const uint8_t *data{};
+    size_t size{};
+
+  private:
+#ifdef _WIN32
+    HANDLE file{INVALID_HANDLE_VALUE};
+    HANDLE mapping{};
+#else
+    int fd{-1};
+#endif
+};
+
+class Writer {
+  public:
+    void Put(uint32_t value) {
+      buffer.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    void Put(const std::u16string &value) {
+      Put(static_cast<uint32_t>(value.size()));
+      buffer.append(reinterpret_cast<const char *>(value.data()), value.size() * sizeof(char16_t));
+    }
+
+    std::string buffer;
+};
+
+/*
+ * Bounds checked reads from the mapped payload. Values are copied, the payload has no alignment guarantees.
+ */
+class Reader {
+  public:
+    Reader(const uint8_t *position, const uint8_t *end) : position{position}, end{end} {}
+
+    bool Get(uint32_t &value) {
+      if (static_cast<size_t>(end - position) < sizeof(value)) {
+        return false;
+      }
+      memcpy(&value, position, sizeof(value));
+      position += sizeof(value);
+      return true;
+    }
+
+    bool Get(std::u16string &value, size_t maxLength) {
+      uint32_t length;
+      if (!Get(length) || length > maxLength || static_cast<size_t>(end - position) / sizeof(char16_t) < length) {
+        return false;
+      }
+      value.resize(length);
+      memcpy(&value[0], position, length * sizeof(char16_t));
+      position += length * sizeof(char16_t);
+      return true;
+    }
+
+    bool AtEnd() const {
+      return position == end;
+    }
+
+  private:
+    const uint8_t *position;
+    const uint8_t *end;
+};
+
+const size_t MaxNameLength = 30;
+const size_t MaxDefaultLength = 30;
+const size_t MaxTextLength = 79;
+const size_t MaxSysIdLength = 8;
+const size_t MaxReleaseLength = 4;
+
+template<size_t N>
+std::u16string FromSAPUC(const SAP_UC (&value)[N]) {
+  auto units = reinterpret_cast<const char16_t *>(value);
+  size_t length = 0;
+  while (length < N && units[length] != 0) {
+    length++;
+  }
+  return std::u16string(units, length);
+}
+
+template<size_t N>
+void ToSAPUC(SAP_UC (&target)[N], const std::u16string &value) {
+  auto length = value.size() < N ? value.size() : N - 1;
+  memcpy(target, value.data(), length * sizeof(SAP_UC));
+  target[length] = 0;
+}
+
+bool IsStructured(uint32_t type) {
+  return type == RFCTYPE_STRUCTURE || type == RFCTYPE_TABLE;
+}
+
+}
+
+Napi::Object DescriptorCache::Init(Napi::Env env, Napi::Object exports) {
+  auto cache = Napi::Object::New(env);
+  cache.Set("Save", Napi::Function::New(env, &DescriptorCache::Save, "Save"));
+  cache.Set("Load", Napi::Function::New(env, &DescriptorCache::Load, "Load"));
+  cache.Set("Remove", Napi::Function::New(env, &DescriptorCache::Remove, "Remove"));
+
+  exports.Set("Descriptors", cache);
+  return exports;
+}
+
+uint32_t DescriptorCache::CollectType(Napi::Env env, RFC_TYPE_DESC_HANDLE typeHandle, Contents &contents,
+                                      std::unordered_map<std::u16string, uint32_t> &typeIndex) {
+  RFC_ERROR_INFO errorInfo{};
+  RFC_ABAP_NAME typeName{};
+  if (RfcGetTypeName(typeHandle, typeName, &errorInfo) != RFC_OK) {
+    throw RfcError(env, errorInfo);
+  }
+  auto name = FromSAPUC(typeName);
+  auto known = typeIndex.find(name);
+  if (known != typeIndex.end()) {
+    return known->second;
+  }
+
+  TypeRecord type;
+  type.name = name;
+  unsigned nucLength{}, ucLength{}, fieldCount{};
+  if (RfcGetTypeLength(typeHandle, &nucLength, &ucLength, &errorInfo) != RFC_OK ||
+      RfcGetFieldCount(typeHandle, &fieldCount, &errorInfo) != RFC_OK) {
+    throw RfcError(env, errorInfo);
+  }
+  type.nucLength = nucLength;
+  type.ucLength = ucLength;
+
+  for (unsigned i = 0; i < fieldCount; i++) {
+    RFC_FIELD_DESC fieldDesc{};
+    if (RfcGetFieldDescByIndex(typeHandle, i, &fieldDesc, &errorInfo) != RFC_OK) {
+      throw RfcError(env, errorInfo);
+    }
+    FieldRecord field;
+    field.name = FromSAPUC(fieldDesc.name);
+    field.type = fieldDesc.type;
+    field.nucLength = fieldDesc.nucLength;
+    field.nucOffset = fieldDesc.nucOffset;
+    field.ucLength = fieldDesc.ucLength;
+    field.ucOffset = fieldDesc.ucOffset;
+    field.decimals = fieldDesc.decimals;
+    if (IsStructured(field.type)) {
+      field.typeIndex = CollectType(env, fieldDesc.typeDescHandle, contents, typeIndex);
+    }
+    type.fields.push_back(std::move(field));
+  }
+
+  // Field types come first, so that they can be registered before the type itself
+  auto index = static_cast<uint32_t>(contents.types.size());
+  contents.types.push_back(std::move(type));
+  typeIndex[name] = index;
+  return index;
+}
+
+void DescriptorCache::CollectFunction(Napi::Env env, RFC_FUNCTION_DESC_HANDLE functionDescHandle, Contents &contents,
+                                      std::unordered_map<std::u16string, uint32_t> &typeIndex) {
+  RFC_ERROR_INFO errorInfo{};
+  RFC_ABAP_NAME functionName{};
+  unsigned parmCount{};
+  if (RfcGetFunctionName(functionDescHandle, functionName, &errorInfo) != RFC_OK ||
+      RfcGetParameterCount(functionDescHandle, &parmCount, &errorInfo) != RFC_OK) {
+    throw RfcError(env, errorInfo);
+  }
+
+  FunctionRecord function;
+  function.name = FromSAPUC(functionName);
+  for (const auto &known : contents.functions) {
+    if (known.name == function.name) {
+      return;
+    }
+  }
+
+  for (unsigned i = 0; i < parmCount; i++) {
+    RFC_PARAMETER_DESC parmDesc{};
+    if (RfcGetParameterDescByIndex(functionDescHandle, i, &parmDesc, &errorInfo) != RFC_OK) {
+      throw RfcError(env, errorInfo);
+    }
+    ParameterRecord parameter;
+    parameter.name = FromSAPUC(parmDesc.name);
+    parameter.type = parmDesc.type;
+    parameter.direction = parmDesc.direction;
+    parameter.nucLength = parmDesc.nucLength;
+    parameter.ucLength = parmDesc.ucLength;
+    parameter.decimals = parmDesc.decimals;
+    parameter.optional = parmDesc.optional;
+    parameter.defaultValue = FromSAPUC(parmDesc.defaultValue);
+    parameter.parameterText = FromSAPUC(parmDesc.parameterText);
+    if (IsStructured(parameter.type)) {
+      parameter.typeIndex = CollectType(env, parmDesc.typeDescHandle, contents, typeIndex);
+    }
+    function.parameters.push_back(std::move(parameter));
+  }
+  contents.functions.push_back(std::move(function));
+}
+
+std::string DescriptorCache::Serialize(const Contents &contents) {
+  Writer payload;
+  payload.Put(contents.sysId);
+  payload.Put(contents.release);
+
+  payload.Put(static_cast<uint32_t>(contents.types.size()));
+  for (const auto &type : contents.types) {
+    payload.Put(type.name);
+    payload.Put(type.nucLength);
+    payload.Put(type.ucLength);
+    payload.Put(static_cast<uint32_t>(type.fields.size()));
+    for (const auto &field : type.fields) {
+      payload.Put(field.name);
+      payload.Put(field.type);
+      payload.Put(field.nucLength);
+      payload.Put(field.nucOffset);
+      payload.Put(field.ucLength);
+      payload.Put(field.ucOffset);
+      payload.Put(field.decimals);
+      payload.Put(field.typeIndex);
+    }
+  }
+
+  payload.Put(static_cast<uint32_t>(contents.functions.size()));
+  for (const auto &function : contents.functions) {
+    payload.Put(function.name);
+    payload.Put(static_cast<uint32_t>(function.parameters.size()));
+    for (const auto &parameter : function.parameters) {
+      payload.Put(parameter.name);
+      payload.Put(parameter.type);
+      payload.Put(parameter.direction);
+      payload.Put(parameter.nucLength);
+      payload.Put(parameter.ucLength);
+      payload.Put(parameter.decimals);
+      payload.Put(parameter.typeIndex);
+      payload.Put(parameter.optional);
+      payload.Put(parameter.defaultValue);
+      payload.Put(parameter.parameterText);
+    }
+  }
+
+  Header header{};
+  memcpy(header.magic, Magic, sizeof(Magic));
+  header.version = Version;
+  header.byteOrder = ByteOrderMark;
+  header.timestamp = contents.timestamp;
+  header.payloadLength = payload.buffer.size();
+  header.checksum = Fnv1a(reinterpret_cast<const uint8_t *>(payload.buffer.data()), payload.buffer.size());
+
+  std::string file(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.append(payload.buffer);
+  return file;
+}
+
+const char *DescriptorCache::Deserialize(const uint8_t *data, size_t size, Contents &contents) {
+  Header header;
+  if (size < sizeof(header)) {
+    return "format";
+  }
+  memcpy(&header, data, sizeof(header));
+  if (memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version ||
+      header.byteOrder != ByteOrderMark || header.payloadLength != size - sizeof(header)) {
+    return "format";
+  }
+  auto payload = data + sizeof(header);
+  if (Fnv1a(payload, size - sizeof(header)) != header.checksum) {
+    return "checksum";
+  }
+
+  // The checksum does not protect against files written by a broken writer, so every read is still checked
+  Reader reader{payload, data + size};
+  contents.timestamp = header.timestamp;
+  uint32_t typeCount;
+  if (!reader.Get(contents.sysId, MaxSysIdLength) || !reader.Get(contents.release, MaxReleaseLength) ||
+      !reader.Get(typeCount)) {
+    return "format";
+  }
+
+  for (uint32_t i = 0; i < typeCount; i++) {
+    TypeRecord type;
+    uint32_t fieldCount;
+    if (!reader.Get(type.name, MaxNameLength) || !reader.Get(type.nucLength) || !reader.Get(type.ucLength) ||
+        !reader.Get(fieldCount)) {
+      return "format";
+    }
+    for (uint32_t j = 0; j < fieldCount; j++) {
+      FieldRecord field;
+      if (!reader.Get(field.name, MaxNameLength) || !reader.Get(field.type) || !reader.Get(field.nucLength) ||
+          !reader.Get(field.nucOffset) || !reader.Get(field.ucLength) || !reader.Get(field.ucOffset) ||
+          !reader.Get(field.decimals) || !reader.Get(field.typeIndex)) {
+        return "format";
+      }
+      // Field types have to precede the type
+      if (field.type >= _RFCTYPE_max_value ||
+          (IsStructured(field.type) ? field.typeIndex >= i : field.typeIndex != NoType)) {
+        return "format";
+      }
+      type.fields.push_back(std::move(field));
+    }
+    contents.types.push_back(std::move(type));
+  }
+
+  uint32_t functionCount;
+  if (!reader.Get(functionCount)) {
+    return "format";
+  }
+  for (uint32_t i = 0; i < functionCount; i++) {
+    FunctionRecord function;
+    uint32_t parmCount;
+    if (!reader.Get(function.name, MaxNameLength) || !reader.Get(parmCount)) {
+      return "format";
+    }
+    for (uint32_t j = 0; j < parmCount; j++) {
+      ParameterRecord parameter;
+      if (!reader.Get(parameter.name, MaxNameLength) || !reader.Get(parameter.type) ||
+          !reader.Get(parameter.direction) || !reader.Get(parameter.nucLength) || !reader.Get(parameter.ucLength) ||
+          !reader.Get(parameter.decimals) || !reader.Get(parameter.typeIndex) || !reader.Get(parameter.optional) ||
+          !reader.Get(parameter.defaultValue, MaxDefaultLength) ||
+          !reader.Get(parameter.parameterText, MaxTextLength)) {
+        return "format";
+      }
+      if (parameter.type >= _RFCTYPE_max_value ||
+          (IsStructured(parameter.type) ? parameter.typeIndex >= typeCount : parameter.typeIndex != NoType)) {
+        return "format";
+      }
+      function.parameters.push_back(std::move(parameter));
+    }
+    contents.functions.push_back(std::move(function));
+  }
+
+  return reader.AtEnd() ? nullptr : "format";
+}
+
+Napi::String DescriptorCache::FilePath(Napi::Env env, Napi::Value directory, const std::u16string &sysId) {
+  auto path = directory.ToString().Utf16Value();
+  if (!path.empty() && path.back() != u'/' && path.back() != u'\\') {
+    path += u'/';
+  }
+  path += sysId;
+  path += u".nwrfcdesc";
+  return Napi::String::New(env, path);
+}
+
+/**
+ * Save(directory, functions)
+ */
+Napi::Value DescriptorCache::Save(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+
+  if (info.Length() != 2) {
+    throw Napi::Error::New(env, "Function expects 2 arguments");
+  }
+  if (!info[0].IsString()) {
+    throw Napi::TypeError::New(env, "Argument 1 must be a directory");
+  }
+  if (!info[1].IsArray()) {
+    throw Napi::TypeError::New(env, "Argument 2 must be an array of functions");
+  }
+
+  auto functions = info[1].As<Napi::Array>();
+  auto &functionCtor = AddonData::Get(env).functionCtor;
+  Contents contents;
+  std::unordered_map<std::u16string, uint32_t> typeIndex;
+
+  for (uint32_t i = 0; i < functions.Length(); i++) {
+    auto value = functions.Get(i);
+    if (!value.IsObject() || !value.As<Napi::Object>().InstanceOf(functionCtor.Value())) {
+      throw Napi::TypeError::New(env, "Argument 2 must be an array of functions");
+    }
+    auto function = Napi::ObjectWrap<Function>::Unwrap(value.As<Napi::Object>());
+    if (!function->connection || !function->functionDescHandle) {
+      throw Napi::TypeError::New(env, "Argument 2 must contain looked up functions");
+    }
+
+    // Descriptors are cached per system, all functions have to belong to the same one
+    RFC_ERROR_INFO errorInfo{};
+    RFC_ATTRIBUTES attributes{};
+    RFC_RC rc;
+    {
+      Connection::HandleLock lock{env, function->connection};
+      rc = RfcGetConnectionAttributes(function->connection->connectionHandle, &attributes, &errorInfo);
+    }
+    if (rc != RFC_OK) {
+      throw RfcError(env, errorInfo);
+    }
+    auto sysId = FromSAPUC(attributes.sysId);
+    if (i == 0) {
+      contents.sysId = sysId;
+      contents.release = FromSAPUC(attributes.partnerRel);
+    } else if (sysId != contents.sysId) {
+      throw Napi::Error::New(env, "All functions must belong to the same system");
+    }
+
+    CollectFunction(env, function->functionDescHandle, contents, typeIndex);
+  }
+  if (contents.sysId.empty()) {
+    throw Napi::Error::New(env, "Argument 2 must contain at least one function");
+  }
+
+  contents.timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count());
+
+  auto path = FilePath(env, info[0], contents.sysId);
+  if (!WriteFileAtomically(ToNativePath(path), Serialize(contents))) {
+    throw Napi::Error::New(env, "Cannot write descriptor cache " + path.Utf8Value() + ": " + strerror(errno));
+  }
+
+  auto result = Napi::Object::New(env);
+  result.Set("path", path);
+  result.Set("sysId", Napi::String::New(env, contents.sysId));
+  result.Set("timestamp", Napi::Number::New(env, static_cast<double>(contents.timestamp)));
+  result.Set("functions", Napi::Number::New(env, contents.functions.size()));
+  result.Set("types", Napi::Number::New(env, contents.types.size()));
+  return scope.Escape(result);
+}
+
+/**
+ * Load(directory, sysId[, { maxAge, notBefore, release }])
+ */
+Napi::Value DescriptorCache::Load(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+
+  if (info.Length() < 2 || info.Length() > 3) {
+    throw Napi::Error::New(env, "Function expects 2 or 3 arguments");
+  }
+  if (!info[0].IsString()) {
+    throw Napi::TypeError::New(env, "Argument 1 must be a directory");
+  }
+  if (!info[1].IsString()) {
+    throw Napi::TypeError::New(env, "Argument 2 must be a system id");
+  }
+  if (info.Length() > 2 && !info[2].IsObject()) {
+    throw Napi::TypeError::New(env, "Argument 3 must be an object");
+  }
+
+  double maxAge{}, notBefore{};
+  std::u16string release;
+  if (info.Length() > 2) {
+    auto options = info[2].ToObject();
+    auto maxAgeValue = options.Get("maxAge");
+    if (!maxAgeValue.IsUndefined()) {
+      if (!maxAgeValue.IsNumber() || maxAgeValue.ToNumber().DoubleValue() <= 0) {
+        throw Napi::TypeError::New(env, "Option maxAge must be a positive number");
+      }
+      maxAge = maxAgeValue.ToNumber().DoubleValue();
+    }
+    auto notBeforeValue = options.Get("notBefore");
+    if (!notBeforeValue.IsUndefined()) {
+      // Dates convert to their milliseconds
+      if (!notBeforeValue.IsNumber() && !notBeforeValue.IsObject()) {
+        throw Napi::TypeError::New(env, "Option notBefore must be a Date or a number");
+      }
+      notBefore = notBeforeValue.ToNumber().DoubleValue();
+    }
+    auto releaseValue = options.Get("release");
+    if (!releaseValue.IsUndefined()) {
+      if (!releaseValue.IsString()) {
+        throw Napi::TypeError::New(env, "Option release must be a string");
+      }
+      release = releaseValue.ToString().Utf16Value();
+    }
+  }
+
+  auto sysId = info[1].ToString().Utf16Value();
+  auto path = FilePath(env, info[0], sysId);
+  auto result = Napi::Object::New(env);
+  result.Set("path", path);
+  result.Set("loaded", Napi::Boolean::New(env, false));
+
+  Contents contents;
+  const char *reason{};
+  {
+    MappedFile file;
+    if (!file.Open(ToNativePath(path))) {
+      reason = "missing";
+    } else {
+      reason = Deserialize(file.data, file.size, contents);
+    }
+  }
+  if (!reason) {
+    auto now = static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    auto timestamp = static_cast<double>(contents.timestamp);
+    if (contents.sysId != sysId || (!release.empty() && contents.release != release)) {
+      reason = "system";
+    } else if ((maxAge > 0 && now - timestamp > maxAge) || timestamp < notBefore) {
+      reason = "expired";
+    }
+  }
+  if (reason) {
+    result.Set("reason", Napi::String::New(env, reason));
+    return scope.Escape(result);
+  }
+
+  // Descriptors which are already cached stay untouched, functions may still be using them
+  RFC_ERROR_INFO errorInfo{};
+  auto system = reinterpret_cast<const SAP_UC *>(sysId.c_str());
+  std::vector<RFC_TYPE_DESC_HANDLE> typeHandles;
+  uint32_t types{}, functions{}, skipped{};
+
+  for (const auto &type : contents.types) {
+    auto typeHandle = RfcGetCachedTypeDesc(system, reinterpret_cast<const SAP_UC *>(type.name.c_str()), &errorInfo);
+    if (typeHandle) {
+      typeHandles.push_back(typeHandle);
+      skipped++;
+      continue;
+    }
+
+    typeHandle = RfcCreateTypeDesc(reinterpret_cast<const SAP_UC *>(type.name.c_str()), &errorInfo);
+    if (!typeHandle) {
+      throw RfcError(env, errorInfo);
+    }
+    errorInfo = RFC_ERROR_INFO{};
+    for (const auto &field : type.fields) {
+      RFC_FIELD_DESC fieldDesc{};
+      ToSAPUC(fieldDesc.name, field.name);
+      fieldDesc.type = static_cast<RFCTYPE>(field.type);
+      fieldDesc.nucLength = field.nucLength;
+      fieldDesc.nucOffset = field.nucOffset;
+      fieldDesc.ucLength = field.ucLength;
+      fieldDesc.ucOffset = field.ucOffset;
+      fieldDesc.decimals = field.decimals;
+      if (field.typeIndex != NoType) {
+        fieldDesc.typeDescHandle = typeHandles[field.typeIndex];
+      }
+      if (RfcAddTypeField(typeHandle, &fieldDesc, &errorInfo) != RFC_OK) {
+        break;
+      }
+    }
+    if (errorInfo.code != RFC_OK ||
+        RfcSetTypeLength(typeHandle, type.nucLength, type.ucLength, &errorInfo) != RFC_OK ||
+        RfcAddTypeDesc(system, typeHandle, &errorInfo) != RFC_OK) {
+      RFC_ERROR_INFO destroyErrorInfo{};
+      RfcDestroyTypeDesc(typeHandle, &destroyErrorInfo);
+      throw RfcError(env, errorInfo);
+    }
+    typeHandles.push_back(typeHandle);
+    types++;
+  }
+
+  for (const auto &function : contents.functions) {
+    auto name = reinterpret_cast<const SAP_UC *>(function.name.c_str());
+    if (RfcGetCachedFunctionDesc(system, name, &errorInfo)) {
+      skipped++;
+      continue;
+    }
+
+    auto functionDescHandle = RfcCreateFunctionDesc(name, &errorInfo);
+    if (!functionDescHandle) {
+      throw RfcError(env, errorInfo);
+    }
+    errorInfo = RFC_ERROR_INFO{};
+    for (const auto &parameter : function.parameters) {
+      RFC_PARAMETER_DESC parmDesc{};
+      ToSAPUC(parmDesc.name, parameter.name);
+      parmDesc.type = static_cast<RFCTYPE>(parameter.type);
+      parmDesc.direction = static_cast<RFC_DIRECTION>(parameter.direction);
+      parmDesc.nucLength = parameter.nucLength;
+      parmDesc.ucLength = parameter.ucLength;
+      parmDesc.decimals = parameter.decimals;
+      parmDesc.optional = static_cast<RFC_BYTE>(parameter.optional);
+      ToSAPUC(parmDesc.defaultValue, parameter.defaultValue);
+      ToSAPUC(parmDesc.parameterText, parameter.parameterText);
+      if (parameter.typeIndex != NoType) {
+        parmDesc.typeDescHandle = typeHandles[parameter.typeIndex];
+      }
+      if (RfcAddParameter(functionDescHandle, &parmDesc, &errorInfo) != RFC_OK) {
+        break;
+      }
+    }
+    if (errorInfo.code != RFC_OK || RfcAddFunctionDesc(system, functionDescHandle, &errorInfo) != RFC_OK) {
+      RFC_ERROR_INFO destroyErrorInfo{};
+      RfcDestroyFunctionDesc(functionDescHandle, &destroyErrorInfo);
+      throw RfcError(env, errorInfo);
+    }
+    functions++;
+  }
+
+  result.Set("loaded", Napi::Boolean::New(env, true));
+  result.Set("sysId", Napi::String::New(env, contents.sysId));
+  result.Set("release", Napi::String::New(env, contents.release));
+  result.Set("timestamp", Napi::Number::New(env, static_cast<double>(contents.timestamp)));
+  result.Set("functions", Napi::Number::New(env, functions));
+  result.Set("types", Napi::Number::New(env, types));
+  result.Set("skipped", Napi::Number::New(env, skipped));
+  return scope.Escape(result);
+}
+
+/**
+ * Remove(directory, sysId)
+ */
+Napi::Value DescriptorCache::Remove(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+
+  if (info.Length() != 2) {
+    throw Napi::Error::New(env, "Function expects 2 arguments");
+  }
+  if (!info[0].IsString()) {
+    throw Napi::TypeError::New(env, "Argument 1 must be a directory");
+  }
+  if (!info[1].IsString()) {
+    throw Napi::TypeError::New(env, "Argument 2 must be a system id");
+  }
+
+  // Processes which have mapped the file keep their pages, the next Load() finds it missing
+  auto path = FilePath(env, info[0], info[1].ToString().Utf16Value());
+  if (!RemoveFile(ToNativePath(path))) {
+    throw Napi::Error::New(env, "Cannot remove descriptor cache " + path.Utf8Value() + ": " + strerror(errno));
+  }
+  return scope.Escape(Napi::Boolean::New(env, true));
+}
@@ -0,0 +1,121 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#ifndef SAPNWRFC_DESCRIPTORCACHE_H
+#define SAPNWRFC_DESCRIPTORCACHE_H
+
+#include <napi.h>
+#include <sapnwrfc.h>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * On-disk cache of function and type descriptors, one file per system (<directory>/<sysId>.nwrfcdesc).
+ * Save() serializes the parameter, field and type tree of looked up functions. Load() maps the file read-only,
+ * so that all processes of a host share its pages, validates it and registers the descriptors in the SDK's
+ * repository cache of the system. Later lookups on that system are answered without a DDIC round-trip.
+ *
+ * The file starts with a fixed header (magic, format version, byte order mark, timestamp, payload length and an
+ * FNV-1a checksum of the payload). The payload holds the system id and release, the types ordered so that every
+ * type follows the types of its fields, and the functions with their parameters. Strings are stored as their
+ * number of UTF-16 units followed by the units, all integers as 32 bit values in native byte order.
+ */
+class DescriptorCache {
+  public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+
+    static const uint32_t NoType = 0xffffffff;
+
+    struct FieldRecord {
+      std::u16string name;
+      uint32_t type{};
+      uint32_t nucLength{};
+      uint32_t nucOffset{};
+      uint32_t ucLength{};
+      uint32_t ucOffset{};
+      uint32_t decimals{};
+      uint32_t typeIndex{NoType};
+    };
+
+    struct TypeRecord {
+      std::u16string name;
+      uint32_t nucLength{};
+      uint32_t ucLength{};
+      std::vector<FieldRecord> fields;
+    };
+
+    struct ParameterRecord {
+      std::u16string name;
+      uint32_t type{};
+      uint32_t direction{};
+      uint32_t nucLength{};
+      uint32_t ucLength{};
+      uint32_t decimals{};
+      uint32_t typeIndex{NoType};
+      uint32_t optional{};
+      std::u16string defaultValue;
+      std::u16string parameterText;
+    };
+
+    struct FunctionRecord {
+      std::u16string name;
+      std::vector<ParameterRecord> parameters;
+    };
+
+    struct Contents {
+      std::u16string sysId;
+      std::u16string release;
+      uint64_t timestamp{};
+      std::vector<TypeRecord> types;
+      std::vector<FunctionRecord> functions;
+    };
+
+  protected:
+    static Napi::Value Save(const Napi::CallbackInfo &info);
+    static Napi::Value Load(const Napi::CallbackInfo &info);
+    static Napi::Value Remove(const Napi::CallbackInfo &info);
+
+    /*
+     * Appends the type and the types of its fields to contents.types, unless they are already known.
+     * Returns the index of the type.
+     */
+    static uint32_t CollectType(Napi::Env env, RFC_TYPE_DESC_HANDLE typeHandle, Contents &contents,
+                                std::unordered_map<std::u16string, uint32_t> &typeIndex);
+    static void CollectFunction(Napi::Env env, RFC_FUNCTION_DESC_HANDLE functionDescHandle, Contents &contents,
+                                std::unordered_map<std::u16string, uint32_t> &typeIndex);
+
+    static std::string Serialize(const Contents &contents);
+
+    /*
+     * Returns nullptr if the file is valid, otherwise the reason why it was rejected.
+     */
+    static const char *Deserialize(const uint8_t *data, size_t size, Contents &contents);
+
+    static Napi::String FilePath(Napi::Env env, Napi::Value directory, const std::u16string &sysId);
+};
+
+#endif //SAPNWRFC_DESCRIPTORCACHE_H
@@ -0,0 +1,89 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#include "FileSystem.h"
+#include <cerrno>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+NativePath ToNativePath(Napi::String path) {
+  auto utf16 = path.Utf16Value();
+  return NativePath(utf16.begin(), utf16.end());
+}
+
+NativePath JoinPath(const NativePath &directory, const std::string &name) {
+  return directory + L"\\" + NativePath(name.begin(), name.end());
+}
+#else
+NativePath ToNativePath(Napi::String path) {
+  return path.Utf8Value();
+}
+
+NativePath JoinPath(const NativePath &directory, const std::string &name) {
+  return directory + "/" + name;
+}
+#endif
+
+bool WriteFileAtomically(const NativePath &path, const std::string &contents) {
+#ifdef _WIN32
+  auto temp = path + L"." + std::to_wstring(_getpid()) + L".tmp";
+  auto file = _wfopen(temp.c_str(), L"wb");
+#else
+  auto temp = path + "." + std::to_string(getpid()) + ".tmp";
+  auto file = fopen(temp.c_str(), "wb");
+#endif
+  if (!file) {
+    return false;
+  }
+  bool written = fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+  written = fclose(file) == 0 && written;
+#ifdef _WIN32
+  if (!written || !MoveFileExW(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+    _wremove(temp.c_str());
+    return false;
+  }
+#else
+  if (!written || rename(temp.c_str(), path.c_str()) != 0) {
+    remove(temp.c_str());
+    return false;
+  }
+#endif
+  return true;
+}
+
+bool RemoveFile(const NativePath &path) {
+#ifdef _WIN32
+  return _wremove(path.c_str()) == 0 || errno == ENOENT;
+#else
+  return remove(path.c_str()) == 0 || errno == ENOENT;
+#endif
+}
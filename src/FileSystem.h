@@ -0,0 +1,59 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#ifndef SAPNWRFC_FILESYSTEM_H
+#define SAPNWRFC_FILESYSTEM_H
+
+#include <napi.h>
+#include <string>
+
+/*
+ * File helpers shared by the descriptor cache and the TID store. Paths are converted on the main thread, the
+ * helpers themselves may run on executor threads.
+ */
+#ifdef _WIN32
+typedef std::wstring NativePath;
+#else
+typedef std::string NativePath;
+#endif
+
+NativePath ToNativePath(Napi::String path);
+
+/*
+ * Appends an ASCII file name to a directory.
+ */
+NativePath JoinPath(const NativePath &directory, const std::string &name);
+
+/*
+ * Writes the file next to its final path and renames it, so that readers never see a partially written file.
+ */
+bool WriteFileAtomically(const NativePath &path, const std::string &contents);
+
+/*
+ * @return true if the file has been removed or did not exist
+ */
+bool RemoveFile(const NativePath &path);
+
+#endif //SAPNWRFC_FILESYSTEM_H
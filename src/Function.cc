@@ -24,15 +24,17 @@ SOFTWARE.
 */
 
 #include "Function.h"
+#include "AddonData.h"
 #include "FunctionInvoke.h"
+#include "FunctionMetaData.h"
+#include "SchemaValidator.h"
+#include "FunctionSchema.h"
+#include "ResultCache.h"
 #include <cassert>
-#include <sstream>
 #include <limits>
 #include <cstdint>
 #include <memory>
 
-Napi::FunctionReference Function::ctor;
-
 Function::Function(const Napi::CallbackInfo &info)
     : Napi::ObjectWrap<Function>(info) {
   init(Value());
@@ -46,11 +48,13 @@ Function::~Function() {
 Napi::Object Function::Init(Napi::Env env, Napi::Object exports) {
   Napi::Function func = DefineClass(env, "Function", {
       InstanceMethod("Invoke", &Function::Invoke),
-      InstanceMethod("MetaData", &Function::MetaData)
+      InstanceMethod("Cancel", &Function::Cancel),
+      InstanceMethod("MetaData", &Function::MetaData),
+      InstanceMethod("MetaDataAsync", &Function::MetaDataAsync),
+      InstanceMethod("Validate", &Function::Validate)
   });
 
-  ctor = Napi::Persistent(func);
-  ctor.SuppressDestruct();
+  AddonData::Get(env).functionCtor = Napi::Persistent(func);
   exports.Set("Function", func);
   return exports;
 }
@@ -58,7 +62,7 @@ Napi::Object Function::Init(Napi::Env env, Napi::Object exports) {
 Napi::Value Function::NewInstance(Napi::Env env, Connection &connection) {
   Napi::EscapableHandleScope scope{env};
 
-  auto func = ctor.New({});
+  auto func = AddonData::Get(env).functionCtor.New({});
   Function *self = Napi::ObjectWrap<Function>::Unwrap(func);
 
   // Save connection
@@ -82,6 +86,7 @@ void Function::Lookup(Napi::Env env, std::u16string &functionName, bool refreshM
     LOG_API(env, this, "RfcGetConnectionAttributes");
     RfcRemoveFunctionDesc(connectionAttributes.sysId, (const SAP_UC *) functionName.c_str(), &errorInfo);
     LOG_API(env, this, "RfcRemoveFunctionDesc");
+    AddonData::Get(env).schemaCache.Invalidate();
   }
 
   // Lookup function interface
@@ -95,6 +100,16 @@ void Function::Lookup(Napi::Env env, std::u16string &functionName, bool refreshM
     throw RfcError(env, errorInfo);
   }
 
+  SetFunctionDesc(env, functionName, functionDescHandle);
+}
+
+void Function::SetFunctionDesc(Napi::Env env, const std::u16string &functionName,
+                               RFC_FUNCTION_DESC_HANDLE functionDescHandle) {
+  Napi::HandleScope scope{env};
+
+  this->functionName = functionName;
+  this->functionDescHandle = functionDescHandle;
+
   unsigned int parmCount{};
   CALL_API_THROW("Function::NewInstance: RfcGetParameterCount unsuccessful",
                  RfcGetParameterCount, functionDescHandle, &parmCount);
@@ -124,22 +139,155 @@ Napi::Value Function::Invoke(const Napi::CallbackInfo &info) {
   if (!info[1].IsFunction()) {
     throw Napi::TypeError::New(env, "Argument 2 must be a function");
   }
+  if (info.Length() > 2 && !info[2].IsUndefined() && !info[2].IsObject()) {
+    throw Napi::TypeError::New(env, "Argument 3 must be an object");
+  }
 
   auto callback = info[1].As<Napi::Function>();
+  auto options = info.Length() > 2 && info[2].IsObject() ? info[2].ToObject() : Napi::Object::New(env);
+
+  auto visitRows = options.Get("visitRows");
+  if (!visitRows.IsUndefined()) {
+    if (!visitRows.IsObject()) {
+      throw Napi::TypeError::New(env, "Option visitRows must be an object");
+    }
+    auto visitors = visitRows.ToObject();
+    auto tableNames = visitors.GetPropertyNames();
+    for (uint32_t i = 0; i < tableNames.Length(); i++) {
+      if (!visitors.Get(tableNames.Get(i)).IsFunction()) {
+        throw Napi::TypeError::New(env, "Row visitor must be a function: " + tableNames.Get(i).ToString().Utf8Value());
+      }
+    }
+  }
+
+  auto timeout = options.Get("timeout");
+  if (!timeout.IsUndefined() && (!timeout.IsNumber() || timeout.ToNumber().DoubleValue() < 0)) {
+    throw Napi::TypeError::New(env, "Option timeout must be a non-negative number");
+  }
+
+  auto inputParam = info[0].ToObject();
+
+  // Invalid input is rejected before anything is queued or allocated
+  if (options.Get("validate").ToBoolean()) {
+    auto entry = CachedSchema(env);
+    if (!entry) {
+      callback.Call({RfcError(env, errorInfo).Value(), env.Null()});
+      return env.Undefined();
+    }
+    SchemaValidator validator{env};
+    auto violations = validator.Validate(*entry->schema, inputParam);
+    if (violations.Length() > 0) {
+      log(env, Levels::DBG, "Function::Invoke: Input parameters are invalid");
+      callback.Call({SchemaValidator::ValidationError(env, violations).Value(), env.Null()});
+      return env.Undefined();
+    }
+  }
 
-  auto functionHandle = RfcCreateFunction(functionDescHandle, &errorInfo);
+  // Lazy results own their container, so they can neither be cached nor shared
+  bool lazy = options.Get("lazy").ToBoolean();
+  std::chrono::milliseconds cacheTtl{};
+  auto &cache = ResultCache::Instance(env);
+  auto cacheOption = options.Get("cache");
+  bool useCache = (cacheOption.IsUndefined() || cacheOption.ToBoolean()) && !lazy &&
+                  cache.IsEnabled(functionName, cacheTtl);
+  bool coalesce = options.Get("coalesce").ToBoolean() && !lazy;
+
+  RFC_FUNCTION_HANDLE functionHandle{};
+  auto prepared = PrepareInvocation(env, inputParam, functionHandle);
+  if (IsException(env, prepared)) {
+    log(env, Levels::SILLY, "Function::Invoke: About call callback with error.");
+    callback.Call({prepared, env.Null()});
+    return env.Undefined();
+  }
+
+  // Keys are built from the marshaled container, so that inputs setting the same values are identical
+  std::string callKey{};
+  if ((useCache || coalesce) && !BuildCallKey(functionHandle, callKey)) {
+    callKey.clear();
+  }
+
+  if (!callKey.empty()) {
+    // Results of read-only function modules may be served from the result cache
+    if (useCache) {
+      auto entry = cache.Find(callKey);
+      if (entry) {
+        log(env, Levels::SILLY, "Function::Invoke: Result cache hit");
+        RfcDestroyFunction(functionHandle, &errorInfo);
+        auto worker = new FunctionInvoke{callback, connection, this, entry, options};
+        worker->Queue();
+        Reference::Ref();
+        return env.Undefined();
+      }
+    }
+
+    // Identical invocations in flight share a single RfcInvoke
+    if (coalesce) {
+      auto inFlight = FunctionInvoke::FindInFlight(env, callKey);
+      if (inFlight) {
+        log(env, Levels::SILLY, "Function::Invoke: Joining identical invocation in flight");
+        inFlight->AddFollower(callback, this, functionHandle, options);
+        Reference::Ref();
+        return env.Undefined();
+      }
+    }
+  }
+
+  auto worker = new FunctionInvoke{callback, connection, this, functionHandle, options};
+  if (useCache && !callKey.empty()) {
+    worker->CacheResult(callKey, cacheTtl);
+  }
+  if (coalesce && !callKey.empty()) {
+    worker->Coalesce(callKey);
+  }
+  if (!timeout.IsUndefined()) {
+    worker->SetTimeout(timeout.ToNumber().Uint32Value());
+  }
+  auto id = worker->Id();
+  worker->Queue();
+
+  // This must be alive when the callback will be called.
+  Reference::Ref();
+
+  return scope.Escape(Napi::Number::New(env, id));
+}
+
+/*
+ * Creates a function container and sets the input parameters, shared by Invoke and batched invocations.
+ *
+ * @return undefined if successful, else the error. The container is only returned if successful.
+ */
+Napi::Value Function::PrepareInvocation(Napi::Env env, Napi::Object inputParam, RFC_FUNCTION_HANDLE &functionHandle) {
+  Napi::EscapableHandleScope scope{env};
+
+  auto container = RfcCreateFunction(functionDescHandle, &errorInfo);
   LOG_API(env, this, "RfcCreateFunction");
-  if (functionHandle == nullptr) {
-    log(env, Levels::DBG, "Function::Invoke: RfcCreateFunction finished with error");
-    return scope.Escape(RfcError(Env(), errorInfo).Value());
+  if (container == nullptr) {
+    log(env, Levels::DBG, "Function::PrepareInvocation: RfcCreateFunction finished with error");
+    return scope.Escape(RfcError(env, errorInfo).Value());
+  }
+
+  auto result = SetParameters(env, inputParam, container);
+  if (IsException(env, result)) {
+    RFC_ERROR_INFO destroyErrorInfo{};
+    RfcDestroyFunction(container, &destroyErrorInfo);
+    return scope.Escape(result);
   }
 
+  functionHandle = container;
+  return env.Undefined();
+}
+
+/*
+ * Writes the parameters of a call, or with response set the parameters a server function sends back.
+ */
+Napi::Value Function::SetParameters(Napi::Env env, Napi::Object inputParam, RFC_FUNCTION_HANDLE functionHandle,
+                                    bool response) {
+  Napi::EscapableHandleScope scope{env};
+
   unsigned int parmCount{};
   CALL_API("Function::Invoke: RfcGetParameterCount returned with error",
            RfcGetParameterCount, functionDescHandle, &parmCount);
 
-  auto inputParam = info[0].ToObject();
-
   for (unsigned int i = 0; i < parmCount; i++) {
     RFC_PARAMETER_DESC paramDesc;
 
@@ -152,34 +300,75 @@ Napi::Value Function::Invoke(const Napi::CallbackInfo &info) {
     if (inputParam.Has(parmName) && !inputParam.Get(parmName).IsNull()) {
       switch (paramDesc.direction) {
         case RFC_IMPORT:
+          if (response) {
+            break;
+          }
+          // fall through
         case RFC_CHANGING:
         case RFC_TABLES:
           result = SetValue(env, functionHandle, paramDesc.type, paramDesc.name, paramDesc.nucLength,
                             inputParam.Get(parmName));
           break;
         case RFC_EXPORT:
+          if (response) {
+            result = SetValue(env, functionHandle, paramDesc.type, paramDesc.name, paramDesc.nucLength,
+                              inputParam.Get(parmName));
+          }
+          break;
         default:
           break;
       }
 
       if (IsException(env, result)) {
-        log(env, Levels::SILLY, "Function::Invoke: About call callback with error.");
-        callback.Call({result, env.Null()});
-        return env.Undefined();
+        return scope.Escape(result);
       }
     }
 
+    // Only the client decides which parameters are exchanged
+    if (response) {
+      continue;
+    }
     CALL_API("Function::Invoke: RfcSetParameterActive returned error.",
              RfcSetParameterActive, functionHandle, paramDesc.name, true);
   }
 
-  auto worker = new FunctionInvoke{callback, connection, this, functionHandle};
-  worker->Queue();
+  return env.Undefined();
+}
 
-  // This must be alive when the callback will be called.
-  Reference::Ref();
+/**
+ * Cancel(id): cancels an invocation, id is the value returned by Invoke().
+ *
+ * @return true if the invocation was still waiting or running
+ */
+Napi::Value Function::Cancel(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+  log(env, Levels::SILLY, "Function::Cancel");
 
-  return env.Undefined();
+  if (info.Length() != 1 || !info[0].IsNumber()) {
+    throw Napi::TypeError::New(env, "Argument 1 must be an invocation id");
+  }
+
+  auto cancelled = connection->queue->Cancel(info[0].ToNumber().Uint32Value());
+  return scope.Escape(Napi::Boolean::New(env, cancelled));
+}
+
+/*
+ * Reads the options { refresh, format } of MetaData() and MetaDataAsync().
+ */
+static void ParseMetaDataOptions(Napi::Env env, Napi::Value options, bool &refresh, std::string &format) {
+  if (!options.IsObject()) {
+    return;
+  }
+  auto optionsObject = options.ToObject();
+  refresh = optionsObject.Get("refresh").ToBoolean();
+  auto formatValue = optionsObject.Get("format");
+  if (!formatValue.IsUndefined()) {
+    format = formatValue.IsString() ? formatValue.ToString().Utf8Value() : std::string{};
+    if (format != "object" && format != "frozen" && format != "json") {
+      throw Napi::TypeError::New(env, "Option format must be 'object', 'frozen' or 'json'");
+    }
+  }
 }
 
 Napi::Value Function::MetaData(const Napi::CallbackInfo &info) {
@@ -189,63 +378,130 @@ Napi::Value Function::MetaData(const Napi::CallbackInfo &info) {
   log(env, Levels::SILLY, "Function::MetaData");
 
   // get the options
-  bool refreshMeta = false;
+  bool refresh = false;
+  std::string format = "object";
   if (info.Length() > 0) {
-    auto optionsObject = info[0].ToObject();
-    refreshMeta = optionsObject.Get("refresh").ToBoolean();
+    ParseMetaDataOptions(env, info[0], refresh, format);
   }
 
-  unsigned int parmCount{};
-  CALL_API("Function::MetaData: RfcGetParameterCount returned with error",
-           RfcGetParameterCount, functionDescHandle, &parmCount);
-
-  auto metaObject = Napi::Object::New(env);
-  RFC_ABAP_NAME functionName{};
-  CALL_API("Function::MetaData: RfcGetFunctionName returned with error",
-           RfcGetFunctionName, functionDescHandle, functionName);
+  if (refresh) {
+    AddonData::Get(env).schemaCache.Invalidate();
+  }
 
-  RFC_FUNCTION_HANDLE functionHandle = RfcCreateFunction(functionDescHandle, &errorInfo);
-  LOG_API(env, this, "RfcCreateFunction");
-  if (functionHandle == nullptr) {
-    log(env, Levels::DBG, "Function::MetaData: RfcCreateFunction finished with error");
-    RfcDestroyFunction(functionHandle, &errorInfo);
-    LOG_API(env, this, "RfcDestroyFunction");
+  auto entry = CachedSchema(env);
+  if (!entry) {
+    log(env, Levels::DBG, "Function::MetaData: reading the function description finished with error");
     return scope.Escape(RfcError(env, errorInfo).Value());
   }
 
-  std::string title = "Signature of SAP RFC function " + convertToString(env, functionName);
+  return scope.Escape(SchemaCache::Format(env, *entry, format));
+}
 
-  metaObject.Set("title", Napi::String::New(env, title));
-  metaObject.Set("type", Napi::String::New(env, "object"));
+/*
+ * Returns the cached schema of the function, building it on a miss. Returns nullptr if the descriptor could
+ * not be read, errorInfo then holds the error.
+ */
+SchemaCache::Entry *Function::CachedSchema(Napi::Env env) {
+  auto &cache = AddonData::Get(env).schemaCache;
+  auto entry = cache.Find(functionDescHandle);
+  if (!entry) {
+    auto schema = FunctionSchema::Build(functionDescHandle, errorInfo);
+    if (!schema) {
+      return nullptr;
+    }
+    entry = cache.Insert(functionDescHandle, schema, cache.Generation());
+  }
+  return entry;
+}
 
-  auto properties = Napi::Object::New(env);
-  metaObject.Set("properties", properties);
+/*
+ * Validate(params) checks input parameters against the schema of the function without calling it.
+ *
+ * @return array of violations { path, message }, empty if the input is valid
+ */
+Napi::Value Function::Validate(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
 
-  // Dynamically add parameters to JS object
-  for (unsigned int i = 0; i < parmCount; i++) {
-    RFC_PARAMETER_DESC parmDesc{};
-    CALL_API("Function::MetaData: RfcGetParameterDescByIndex finished with error",
-             RfcGetParameterDescByIndex, functionDescHandle, i, &parmDesc);
+  log(env, Levels::SILLY, "Function::Validate");
 
-    if (!addMetaData(env, functionHandle, properties, parmDesc.name, parmDesc.type,
-                     parmDesc.nucLength, parmDesc.direction,
-                     parmDesc.parameterText, refreshMeta)) {
-      return scope.Escape(RfcError(env, errorInfo).Value());
+  if (info.Length() != 1) {
+    throw Napi::Error::New(env, "Function expects 1 argument");
+  }
+  if (!info[0].IsObject()) {
+    throw Napi::TypeError::New(env, "Argument 1 must be an object");
+  }
+
+  auto entry = CachedSchema(env);
+  if (!entry) {
+    throw RfcError(env, errorInfo);
+  }
+
+  SchemaValidator validator{env};
+  return scope.Escape(validator.Validate(*entry->schema, info[0].ToObject()));
+}
+
+/**
+ * MetaDataAsync([options][, callback]) builds the schema on an executor thread.
+ */
+Napi::Value Function::MetaDataAsync(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+
+  log(env, Levels::SILLY, "Function::MetaDataAsync");
+
+  if (info.Length() > 2) {
+    throw Napi::Error::New(env, "Function expects 0 to 2 arguments");
+  }
+
+  Napi::Value options = env.Undefined();
+  Napi::Value callback = env.Undefined();
+  if (info.Length() > 0 && info[0].IsFunction()) {
+    if (info.Length() > 1) {
+      throw Napi::Error::New(env, "Callback must be the last argument");
     }
+    callback = info[0];
+  } else {
+    options = info.Length() > 0 ? info[0] : env.Undefined();
+    callback = info.Length() > 1 ? info[1] : env.Undefined();
+  }
+  if (!options.IsUndefined() && !options.IsObject()) {
+    throw Napi::TypeError::New(env, "Argument 1 must be an object");
+  }
+  if (!callback.IsUndefined() && !callback.IsFunction()) {
+    throw Napi::TypeError::New(env, "Argument 2 must be a function");
   }
 
-  RfcDestroyFunction(functionHandle, &errorInfo);
-  LOG_API(env, this, "RfcDestroyFunction");
+  bool refresh = false;
+  std::string format = "object";
+  ParseMetaDataOptions(env, options, refresh, format);
+  if (refresh) {
+    AddonData::Get(env).schemaCache.Invalidate();
+  }
 
-  return scope.Escape(metaObject);
+  auto worker = new FunctionMetaData{env, callback, connection, functionDescHandle, format};
+  auto promise = worker->Promise();
+  worker->Queue();
+  return scope.Escape(promise);
 }
 
 
-Napi::Value Function::DoReceive(Napi::Env env, CHND container) {
+Napi::Value Function::DoReceive(Napi::Env env, CHND container, Napi::Object options) {
   Napi::EscapableHandleScope scope{env};
 
   auto result = Napi::Object::New(env);
 
+  // Tables with a row visitor are streamed to the callback instead of being materialized
+  Napi::Object visitors{};
+  bool reuseRow{};
+  if (!options.IsEmpty()) {
+    auto visitRows = options.Get("visitRows");
+    if (visitRows.IsObject()) {
+      visitors = visitRows.ToObject();
+    }
+    reuseRow = options.Get("reuseRow").ToBoolean();
+  }
+
   // Get resulting values for exporting/changing/table parameters
   unsigned int parmCount{};
   CALL_API(nullptr, RfcGetParameterCount, functionDescHandle, &parmCount);
@@ -260,11 +516,18 @@ Napi::Value Function::DoReceive(Napi::Env env, CHND container) {
       case RFC_CHANGING:
       case RFC_TABLES:
       case RFC_EXPORT: {
-        auto paramValue = GetValue(env, container, parmDesc.type, parmDesc.name, parmDesc.nucLength);
+        auto parmName = Napi::String::New(env, (const char16_t *) (parmDesc.name));
+        Napi::Value paramValue{};
+        if (parmDesc.type == RFCTYPE_TABLE && !visitors.IsEmpty() && visitors.Get(parmName).IsFunction()) {
+          paramValue = TableToInternal(env, container, parmDesc.name, visitors.Get(parmName).As<Napi::Function>(),
+                                       reuseRow);
+        } else {
+          paramValue = GetValue(env, container, parmDesc.type, parmDesc.name, parmDesc.nucLength);
+        }
         if (IsException(env, paramValue)) {
           return scope.Escape(paramValue);
         }
-        result.Set(Napi::String::New(env, (const char16_t *) (parmDesc.name)), paramValue);
+        result.Set(parmName, paramValue);
         break;
       }
       default:
@@ -519,7 +782,7 @@ Napi::Value Function::Int1ToExternal(Napi::Env env, CHND container, const SAP_UC
     return scope.Escape(Napi::TypeError::New(env, err).Value());
   }
   int32_t convertedValue = value.ToNumber().Int32Value();
-  if ((convertedValue < std::numeric_limits<int8_t>::min()) || (convertedValue > std::numeric_limits<int8_t>::max())) {
+  if ((convertedValue < std::numeric_limits<RFC_INT1>::min()) || (convertedValue > std::numeric_limits<RFC_INT1>::max())) {
     auto err = "Argument out of range: " + convertToString(env, name);
     return scope.Escape(Napi::TypeError::New(env, err).Value());
   }
@@ -684,6 +947,11 @@ Napi::Value Function::StructureToInternal(Napi::Env env, CHND container, const S
 
 Napi::Value Function::StructureToInternal(Napi::Env env, RFC_STRUCTURE_HANDLE structHandle) {
   Napi::EscapableHandleScope scope{env};
+  return scope.Escape(StructureToInternal(env, structHandle, Napi::Object::New(env)));
+}
+
+Napi::Value Function::StructureToInternal(Napi::Env env, RFC_STRUCTURE_HANDLE structHandle, Napi::Object target) {
+  Napi::EscapableHandleScope scope{env};
 
   auto typeHandle = RfcDescribeType(structHandle, &errorInfo);
   LOG_API(env, this, "RfcDescribeType");
@@ -695,8 +963,6 @@ Napi::Value Function::StructureToInternal(Napi::Env env, RFC_STRUCTURE_HANDLE st
   unsigned fieldCount{};
   CALL_API(nullptr, RfcGetFieldCount, typeHandle, &fieldCount);
 
-  auto obj = Napi::Object::New(env);
-
   for (unsigned int i = 0; i < fieldCount; i++) {
     RFC_FIELD_DESC fieldDesc{};
     CALL_API(nullptr, RfcGetFieldDescByIndex, typeHandle, i, &fieldDesc);
@@ -706,10 +972,10 @@ Napi::Value Function::StructureToInternal(Napi::Env env, RFC_STRUCTURE_HANDLE st
     if (IsException(env, value)) {
       return scope.Escape(value);
     }
-    obj.Set(Napi::String::New(env, (const char16_t *) (fieldDesc.name)), value);
+    target.Set(Napi::String::New(env, (const char16_t *) (fieldDesc.name)), value);
   }
 
-  return scope.Escape(obj);
+  return scope.Escape(target);
 }
 
 Napi::Value Function::TableToInternal(Napi::Env env, CHND container, const SAP_UC *name) {
@@ -741,6 +1007,48 @@ Napi::Value Function::TableToInternal(Napi::Env env, CHND container, const SAP_U
   return scope.Escape(obj);
 }
 
+/**
+ * Passes the rows of a table one by one to a visitor function instead of collecting them in an array.
+ *
+ * @return number of visited rows
+ */
+Napi::Value Function::TableToInternal(Napi::Env env, CHND container, const SAP_UC *name, Napi::Function visitor,
+                                      bool reuseRow) {
+  Napi::EscapableHandleScope scope{env};
+
+  RFC_TABLE_HANDLE tableHandle{};
+  CALL_API(nullptr, RfcGetTable, container, name, &tableHandle);
+
+  unsigned rowCount{};
+  CALL_API(nullptr, RfcGetRowCount, tableHandle, &rowCount);
+
+  // Only used when rows are reused, the visitor then always gets the same object with overwritten fields
+  auto sharedRow = Napi::Object::New(env);
+
+  for (unsigned int i = 0; i < rowCount; i++) {
+    Napi::HandleScope rowScope{env};
+
+    RfcMoveTo(tableHandle, i, &errorInfo);
+    LOG_API(env, this, "RfcMoveTo");
+    auto structHandle = RfcGetCurrentRow(tableHandle, &errorInfo);
+    LOG_API(env, this, "RfcGetCurrentRow");
+
+    auto line = StructureToInternal(env, structHandle, reuseRow ? sharedRow : Napi::Object::New(env));
+    // Bail out on exception
+    if (IsException(env, line)) {
+      return scope.Escape(line);
+    }
+
+    try {
+      visitor.Call({line, Napi::Number::New(env, i)});
+    } catch (const Napi::Error &e) {
+      return scope.Escape(e.Value());
+    }
+  }
+
+  return scope.Escape(Napi::Number::New(env, rowCount));
+}
+
 template<typename T>
 static std::unique_ptr<T[]> getZeroedBuffer(unsigned len) {
   auto buffer = std::unique_ptr<T[]>(new T[len]);
@@ -903,212 +1211,270 @@ Napi::Value Function::BCDToInternal(Napi::Env env, CHND container, const SAP_UC
   return env.Undefined();
 }
 
-std::string Function::mapExternalTypeToJavaScriptType(RFCTYPE sapType) {
-  switch (sapType) {
-    case RFCTYPE_CHAR:
-    case RFCTYPE_DATE:
-    case RFCTYPE_TIME:
-    case RFCTYPE_BYTE:
-    case RFCTYPE_NUM:
-    case RFCTYPE_STRING:
-    case RFCTYPE_XSTRING:
-      return "string";
-    case RFCTYPE_TABLE:
-      return "array";
-    case RFCTYPE_ABAPOBJECT:
-    case RFCTYPE_STRUCTURE:
-      return "object";
-    case RFCTYPE_BCD:
-    case RFCTYPE_FLOAT:
-    case RFCTYPE_DECF16:
-    case RFCTYPE_DECF34:
-      return "number";
-    case RFCTYPE_INT:
-    case RFCTYPE_INT2:
-    case RFCTYPE_INT1:
-    case RFCTYPE_INT8:
-    case RFCTYPE_UTCLONG:
-    case RFCTYPE_UTCSECOND:
-    case RFCTYPE_UTCMINUTE:
-    case RFCTYPE_DTDAY:
-    case RFCTYPE_DTWEEK:
-    case RFCTYPE_DTMONTH:
-    case RFCTYPE_TSECOND:
-    case RFCTYPE_TMINUTE:
-    case RFCTYPE_CDAY:
-      return "integer";
-    default:
-      return "undefined";
-  }
-
+static void appendKeyLength(std::string &key, uint32_t length) {
+  key.append(reinterpret_cast<const char *>(&length), sizeof(length));
 }
 
-bool Function::addMetaData(Napi::Env env, CHND container, Napi::Object parent,
-                           const RFC_ABAP_NAME name, RFCTYPE type, unsigned int length,
-                           RFC_DIRECTION direction, RFC_PARAMETER_TEXT paramText,
-                           bool refresh) {
-  Napi::HandleScope scope{env};
-
-  log(env, Levels::SILLY, "Function::addMetaData");
-
-  auto actualType = Napi::Object::New(env);
-  parent.Set(Napi::String::New(env, (const char16_t *) name), actualType);
-
-  actualType.Set("type", Napi::String::New(env, mapExternalTypeToJavaScriptType(type)));
-
-  std::stringstream lengthString;
-  lengthString << length;
-  actualType.Set("length", Napi::String::New(env, lengthString.str()));
-
-  actualType.Set("sapType", Napi::String::New(env, (char16_t *) RfcGetTypeAsString(type)));
+static void appendKeyString(std::string &key, const char16_t *str, size_t length) {
+  appendKeyLength(key, static_cast<uint32_t>(length));
+  key.append(reinterpret_cast<const char *>(str), length * sizeof(char16_t));
+}
 
-  if (paramText != nullptr) {
-    actualType.Set("description", Napi::String::New(env, (char16_t *) paramText));
+/**
+ * Serializes the logon attributes of the connection and the values of the input parameters as set in the container,
+ * in the order of the function descriptor. Parameters which were not passed are keyed with their initial values.
+ *
+ * @return false if no key could be built
+ */
+bool Function::BuildCallKey(RFC_FUNCTION_HANDLE functionHandle, std::string &key) {
+  // Read once when the connection was opened
+  if (connection->logonKey.empty()) {
+    return false;
   }
 
-  if (direction != 0) {
-    actualType.Set("sapDirection", Napi::String::New(env, (char16_t *) RfcGetDirectionAsString(direction)));
-  }
+  key = ResultCache::KeyPrefix(functionName);
+  key.append(connection->logonKey);
 
-  if (type == RFCTYPE_STRUCTURE) {
-    RFC_STRUCTURE_HANDLE structHandle;
+  unsigned int parmCount{};
+  if (RfcGetParameterCount(functionDescHandle, &parmCount, &errorInfo) != RFC_OK) {
+    return false;
+  }
 
-    RfcGetStructure(container, name, &structHandle, &errorInfo);
-    LOG_API(env, this, "RfcGetStructure");
-    if (errorInfo.code != RFC_OK) {
+  for (unsigned int i = 0; i < parmCount; i++) {
+    RFC_PARAMETER_DESC parmDesc{};
+    if (RfcGetParameterDescByIndex(functionDescHandle, i, &parmDesc, &errorInfo) != RFC_OK) {
       return false;
     }
-
-    auto typeHandle = RfcDescribeType(structHandle, &errorInfo);
-    LOG_API(env, this, "RfcDescribeType");
-    assert(typeHandle);
-    if (typeHandle == nullptr) {
-      return false;
+    if (parmDesc.direction == RFC_EXPORT) {
+      continue;
     }
 
-    RFC_ABAP_NAME typeName;
-    RfcGetTypeName(typeHandle, typeName, &errorInfo);
-    LOG_API(env, this, "RfcGetTypeName");
-    if (errorInfo.code != RFC_OK) {
+    appendKeyLength(key, i);
+    if (!AppendValueKey(functionHandle, parmDesc.type, parmDesc.name, parmDesc.nucLength, parmDesc.typeDescHandle,
+                        key)) {
       return false;
     }
+  }
 
-    actualType.Set("sapTypeName", Napi::String::New(env, (char16_t *) typeName));
-
-    if (refresh) {
-      RFC_ATTRIBUTES connectionAttributes;
-      RfcGetConnectionAttributes(connection->connectionHandle, &connectionAttributes, &errorInfo);
-      LOG_API(env, this, "RfcGetConnectionAttributes");
-      RfcRemoveTypeDesc(connectionAttributes.sysId, typeName, &errorInfo);
-      LOG_API(env, this, "RfcRemoveTypeDesc");
-      typeHandle = RfcDescribeType(structHandle, &errorInfo);
-      LOG_API(env, this, "RfcDescribeType");
-      assert(typeHandle);
-      if (typeHandle == nullptr) {
+  return true;
+}
+
+bool Function::AppendValueKey(CHND container, RFCTYPE type, const SAP_UC *name, unsigned len,
+                              RFC_TYPE_DESC_HANDLE typeHandle, std::string &key) {
+  switch (type) {
+    case RFCTYPE_CHAR:
+    case RFCTYPE_NUM:
+    case RFCTYPE_DATE:
+    case RFCTYPE_TIME: {
+      // Fixed length values are padded in the container
+      auto buffer = getZeroedBuffer<RFC_CHAR>(len + 1);
+      if (RfcGetChars(container, name, buffer.get(), len, &errorInfo) != RFC_OK) {
         return false;
       }
+      appendKeyString(key, (const char16_t *) buffer.get(), len);
+      return true;
     }
-
-    unsigned fieldCount;
-    RfcGetFieldCount(typeHandle, &fieldCount, &errorInfo);
-    LOG_API(env, this, "RfcGetFieldCount");
-    if (errorInfo.code != RFC_OK) {
-      return false;
+    case RFCTYPE_BCD:
+    case RFCTYPE_STRING: {
+      unsigned strLen{};
+      if (type == RFCTYPE_STRING) {
+        if (RfcGetStringLength(container, name, &strLen, &errorInfo) != RFC_OK) {
+          return false;
+        }
+      } else {
+        // Digits, sign and decimal separator
+        strLen = 2 * len + 2;
+      }
+      auto buffer = getZeroedBuffer<SAP_UC>(strLen + 1);
+      unsigned retStrLen{};
+      if (RfcGetString(container, name, buffer.get(), strLen + 1, &retStrLen, &errorInfo) != RFC_OK) {
+        return false;
+      }
+      appendKeyString(key, (const char16_t *) buffer.get(), retStrLen);
+      return true;
     }
-
-    auto properties = Napi::Object::New(env);
-    actualType.Set("properties", properties);
-
-    for (unsigned int i = 0; i < fieldCount; i++) {
-      RFC_FIELD_DESC fieldDesc;
-      RfcGetFieldDescByIndex(typeHandle, i, &fieldDesc, &errorInfo);
-      LOG_API(env, this, "RfcGetFieldDescByIndex");
-      if (errorInfo.code != RFC_OK) {
+    case RFCTYPE_INT: {
+      RFC_INT value{};
+      if (RfcGetInt(container, name, &value, &errorInfo) != RFC_OK) {
         return false;
       }
-
-      if (!addMetaData(env, structHandle, properties, fieldDesc.name, fieldDesc.type,
-                       fieldDesc.nucLength, RFC_DIRECTION(0), nullptr, refresh)) {
+      key.append(reinterpret_cast<const char *>(&value), sizeof(value));
+      return true;
+    }
+    case RFCTYPE_INT1: {
+      RFC_INT1 value{};
+      if (RfcGetInt1(container, name, &value, &errorInfo) != RFC_OK) {
         return false;
       }
+      key.append(reinterpret_cast<const char *>(&value), sizeof(value));
+      return true;
     }
-  } else if (type == RFCTYPE_TABLE) {
-    RFC_TABLE_HANDLE tableHandle;
-    RFC_TYPE_DESC_HANDLE typeHandle;
-    RFC_FIELD_DESC fieldDesc;
-    unsigned fieldCount;
-    RFC_ABAP_NAME typeName;
-
-    RfcGetTable(container, name, &tableHandle, &errorInfo);
-    LOG_API(env, this, "RfcGetTable");
-    if (errorInfo.code != RFC_OK) {
-      return false;
+    case RFCTYPE_INT2: {
+      RFC_INT2 value{};
+      if (RfcGetInt2(container, name, &value, &errorInfo) != RFC_OK) {
+        return false;
+      }
+      key.append(reinterpret_cast<const char *>(&value), sizeof(value));
+      return true;
     }
-
-    typeHandle = RfcDescribeType(tableHandle, &errorInfo);
-    LOG_API(env, this, "RfcDescribeType");
-    assert(typeHandle);
-    if (typeHandle == nullptr) {
-      return false;
+    case RFCTYPE_FLOAT: {
+      RFC_FLOAT value{};
+      if (RfcGetFloat(container, name, &value, &errorInfo) != RFC_OK) {
+        return false;
+      }
+      key.append(reinterpret_cast<const char *>(&value), sizeof(value));
+      return true;
     }
-
-    RfcGetTypeName(typeHandle, typeName, &errorInfo);
-    LOG_API(env, this, "RfcGetTypeName");
-    if (errorInfo.code != RFC_OK) {
-      return false;
+    case RFCTYPE_BYTE: {
+      auto buffer = getZeroedBuffer<RFC_BYTE>(len);
+      if (RfcGetBytes(container, name, buffer.get(), len, &errorInfo) != RFC_OK) {
+        return false;
+      }
+      key.append(reinterpret_cast<const char *>(buffer.get()), len);
+      return true;
     }
-
-    if (refresh) {
-      RFC_ATTRIBUTES connectionAttributes;
-      RfcGetConnectionAttributes(connection->connectionHandle, &connectionAttributes, &errorInfo);
-      LOG_API(env, this, "RfcGetConnectionAttributes");
-      RfcRemoveTypeDesc(connectionAttributes.sysId, typeName, &errorInfo);
-      LOG_API(env, this, "RfcRemoveTypeDesc");
-      typeHandle = RfcDescribeType(tableHandle, &errorInfo);
-      LOG_API(env, this, "RfcDescribeType");
-      assert(typeHandle);
-      if (typeHandle == nullptr) {
+    case RFCTYPE_XSTRING: {
+      unsigned strLen{};
+      if (RfcGetStringLength(container, name, &strLen, &errorInfo) != RFC_OK) {
+        return false;
+      }
+      auto buffer = getZeroedBuffer<SAP_RAW>(strLen + 1);
+      unsigned retStrLen{};
+      if (RfcGetXString(container, name, buffer.get(), strLen, &retStrLen, &errorInfo) != RFC_OK) {
+        return false;
+      }
+      appendKeyLength(key, retStrLen);
+      key.append(reinterpret_cast<const char *>(buffer.get()), retStrLen);
+      return true;
+    }
+    case RFCTYPE_STRUCTURE: {
+      RFC_STRUCTURE_HANDLE structHandle{};
+      return RfcGetStructure(container, name, &structHandle, &errorInfo) == RFC_OK &&
+             AppendStructureKey(structHandle, typeHandle, key);
+    }
+    case RFCTYPE_TABLE: {
+      RFC_TABLE_HANDLE tableHandle{};
+      unsigned rowCount{};
+      if (RfcGetTable(container, name, &tableHandle, &errorInfo) != RFC_OK ||
+          RfcGetRowCount(tableHandle, &rowCount, &errorInfo) != RFC_OK) {
         return false;
       }
+      appendKeyLength(key, rowCount);
+      for (unsigned i = 0; i < rowCount; i++) {
+        if (RfcMoveTo(tableHandle, i, &errorInfo) != RFC_OK) {
+          return false;
+        }
+        auto structHandle = RfcGetCurrentRow(tableHandle, &errorInfo);
+        if (structHandle == nullptr || !AppendStructureKey(structHandle, typeHandle, key)) {
+          return false;
+        }
+      }
+      return true;
     }
+    default:
+      return false;
+  }
+}
+
+bool Function::AppendStructureKey(RFC_STRUCTURE_HANDLE structHandle, RFC_TYPE_DESC_HANDLE typeHandle,
+                                  std::string &key) {
+  unsigned fieldCount{};
+  if (RfcGetFieldCount(typeHandle, &fieldCount, &errorInfo) != RFC_OK) {
+    return false;
+  }
 
-    RfcGetFieldCount(typeHandle, &fieldCount, &errorInfo);
-    LOG_API(env, this, "RfcGetFieldCount");
-    if (errorInfo.code != RFC_OK) {
+  for (unsigned int i = 0; i < fieldCount; i++) {
+    RFC_FIELD_DESC fieldDesc{};
+    if (RfcGetFieldDescByIndex(typeHandle, i, &fieldDesc, &errorInfo) != RFC_OK ||
+        !AppendValueKey(structHandle, fieldDesc.type, fieldDesc.name, fieldDesc.nucLength, fieldDesc.typeDescHandle,
+                        key)) {
       return false;
     }
+  }
+  return true;
+}
 
-    auto items = Napi::Object::New(env);
-    actualType.Set("items", items);
-    items.Set("sapTypeName", Napi::String::New(env, (char16_t *) typeName));
-
-    items.Set("type", Napi::String::New(env, "object"));
+/**
+ * Approximates the memory held by a function container. Strings nested in structures and tables are not counted.
+ */
+size_t Function::ContainerSize(RFC_FUNCTION_HANDLE functionHandle) {
+  size_t size{};
 
-    auto properties = Napi::Object::New(env);
-    items.Set("properties", properties);
+  unsigned int parmCount{};
+  RfcGetParameterCount(functionDescHandle, &parmCount, &errorInfo);
 
-    RFC_STRUCTURE_HANDLE rowHandle = RfcAppendNewRow(tableHandle, &errorInfo);
-    LOG_API(env, this, "RfcAppendNewRow");
-    if (errorInfo.code != RFC_OK) {
-      return false;
+  for (unsigned int i = 0; i < parmCount; i++) {
+    RFC_PARAMETER_DESC parmDesc{};
+    if (RfcGetParameterDescByIndex(functionDescHandle, i, &parmDesc, &errorInfo) != RFC_OK) {
+      continue;
     }
 
-    for (unsigned int i = 0; i < fieldCount; i++) {
-      RfcGetFieldDescByIndex(typeHandle, i, &fieldDesc, &errorInfo);
-      LOG_API(env, this, "RfcGetFieldDescByIndex");
-      if (errorInfo.code != RFC_OK) {
-        return false;
+    switch (parmDesc.type) {
+      case RFCTYPE_TABLE: {
+        RFC_TABLE_HANDLE tableHandle{};
+        unsigned rowCount{}, nucLength{}, ucLength{};
+        if (RfcGetTable(functionHandle, parmDesc.name, &tableHandle, &errorInfo) == RFC_OK &&
+            RfcGetRowCount(tableHandle, &rowCount, &errorInfo) == RFC_OK &&
+            RfcGetTypeLength(parmDesc.typeDescHandle, &nucLength, &ucLength, &errorInfo) == RFC_OK) {
+          size += static_cast<size_t>(rowCount) * ucLength;
+        }
+        break;
       }
-
-      log(env, Levels::SILLY, "Function::addMetaData recurse");
-      if (!addMetaData(env, rowHandle, properties, fieldDesc.name, fieldDesc.type,
-                       fieldDesc.nucLength, RFC_DIRECTION(0), nullptr, refresh)) {
-        return false;
+      case RFCTYPE_STRING:
+      case RFCTYPE_XSTRING: {
+        unsigned strLen{};
+        if (RfcGetStringLength(functionHandle, parmDesc.name, &strLen, &errorInfo) == RFC_OK) {
+          size += strLen * sizeof(SAP_UC);
+        }
+        break;
       }
+      default:
+        size += parmDesc.ucLength;
+        break;
     }
   }
 
-  return true;
+  return size;
+}
+
+std::string Function::mapExternalTypeToJavaScriptType(RFCTYPE sapType) {
+  switch (sapType) {
+    case RFCTYPE_CHAR:
+    case RFCTYPE_DATE:
+    case RFCTYPE_TIME:
+    case RFCTYPE_BYTE:
+    case RFCTYPE_NUM:
+    case RFCTYPE_STRING:
+    case RFCTYPE_XSTRING:
+      return "string";
+    case RFCTYPE_TABLE:
+      return "array";
+    case RFCTYPE_ABAPOBJECT:
+    case RFCTYPE_STRUCTURE:
+      return "object";
+    case RFCTYPE_BCD:
+    case RFCTYPE_FLOAT:
+    case RFCTYPE_DECF16:
+    case RFCTYPE_DECF34:
+      return "number";
+    case RFCTYPE_INT:
+    case RFCTYPE_INT2:
+    case RFCTYPE_INT1:
+    case RFCTYPE_INT8:
+    case RFCTYPE_UTCLONG:
+    case RFCTYPE_UTCSECOND:
+    case RFCTYPE_UTCMINUTE:
+    case RFCTYPE_DTDAY:
+    case RFCTYPE_DTWEEK:
+    case RFCTYPE_DTMONTH:
+    case RFCTYPE_TSECOND:
+    case RFCTYPE_TMINUTE:
+    case RFCTYPE_CDAY:
+      return "integer";
+    default:
+      return "undefined";
+  }
+
 }
 
 void Function::addObjectInfoToLogMeta(Napi::Object meta) {
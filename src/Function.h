@@ -30,9 +30,19 @@ SOFTWARE.
 #include "Loggable.h"
 #include <sapnwrfc.h>
 #include "Connection.h"
+#include "FunctionSchema.h"
 
 class Function : public Loggable, public Napi::ObjectWrap<Function> {
+    friend class Connection;
     friend class FunctionInvoke;
+    friend class ConnectionBatch;
+    friend class PoolFanOut;
+    friend class LazyResult;
+    friend class DescriptorCache;
+    friend class FunctionSchema;
+    friend class Server;
+    friend class Transaction;
+    friend class Unit;
 
   public:
     static Napi::Object Init(Napi::Env env, Napi::Object exports);
@@ -42,14 +52,21 @@ class Function : public Loggable, public Napi::ObjectWrap<Function> {
     ~Function();
 
     void Lookup(Napi::Env env, std::u16string &functionName, bool refreshMeta);
+    void SetFunctionDesc(Napi::Env env, const std::u16string &functionName, RFC_FUNCTION_DESC_HANDLE functionDescHandle);
 
     RFC_ERROR_INFO errorInfo{};
 
   protected:
 
     Napi::Value Invoke(const Napi::CallbackInfo &info);
+    Napi::Value Cancel(const Napi::CallbackInfo &info);
     Napi::Value MetaData(const Napi::CallbackInfo &info);
-    Napi::Value DoReceive(Napi::Env env, CHND container);
+    Napi::Value MetaDataAsync(const Napi::CallbackInfo &info);
+    Napi::Value Validate(const Napi::CallbackInfo &info);
+    Napi::Value PrepareInvocation(Napi::Env env, Napi::Object inputParam, RFC_FUNCTION_HANDLE &functionHandle);
+    Napi::Value SetParameters(Napi::Env env, Napi::Object inputParam, RFC_FUNCTION_HANDLE functionHandle,
+                              bool response = false);
+    Napi::Value DoReceive(Napi::Env env, CHND container, Napi::Object options = Napi::Object());
 
     Napi::Value SetValue(Napi::Env env, CHND container, RFCTYPE type, const SAP_UC *name, unsigned len, Napi::Value value);
     Napi::Value StructureToExternal(Napi::Env env, CHND container, const SAP_UC *name, Napi::Value value);
@@ -71,7 +88,10 @@ class Function : public Loggable, public Napi::ObjectWrap<Function> {
     Napi::Value GetValue(Napi::Env env, CHND container, RFCTYPE type, const SAP_UC *name, unsigned len);
     Napi::Value StructureToInternal(Napi::Env env, CHND container, const SAP_UC *name);
     Napi::Value StructureToInternal(Napi::Env env, RFC_STRUCTURE_HANDLE structHandle);
+    Napi::Value StructureToInternal(Napi::Env env, RFC_STRUCTURE_HANDLE structHandle, Napi::Object target);
     Napi::Value TableToInternal(Napi::Env env, CHND container, const SAP_UC *name);
+    Napi::Value TableToInternal(Napi::Env env, CHND container, const SAP_UC *name, Napi::Function visitor,
+                                bool reuseRow);
     Napi::Value StringToInternal(Napi::Env env, CHND container, const SAP_UC *name);
     Napi::Value XStringToInternal(Napi::Env env, CHND container, const SAP_UC *name);
     Napi::Value NumToInternal(Napi::Env env, CHND container, const SAP_UC *name, unsigned len);
@@ -85,19 +105,21 @@ class Function : public Loggable, public Napi::ObjectWrap<Function> {
     Napi::Value TimeToInternal(Napi::Env env, CHND container, const SAP_UC *name);
     Napi::Value BCDToInternal(Napi::Env env, CHND container, const SAP_UC *name);
 
-    static std::string mapExternalTypeToJavaScriptType(RFCTYPE sapType);
+    bool BuildCallKey(RFC_FUNCTION_HANDLE functionHandle, std::string &key);
+    bool AppendValueKey(CHND container, RFCTYPE type, const SAP_UC *name, unsigned len,
+                        RFC_TYPE_DESC_HANDLE typeHandle, std::string &key);
+    bool AppendStructureKey(RFC_STRUCTURE_HANDLE structHandle, RFC_TYPE_DESC_HANDLE typeHandle, std::string &key);
+    size_t ContainerSize(RFC_FUNCTION_HANDLE functionHandle);
+    SchemaCache::Entry *CachedSchema(Napi::Env env);
 
-    bool addMetaData(Napi::Env env, CHND container, Napi::Object parent,
-                     const RFC_ABAP_NAME name, RFCTYPE type, unsigned int length,
-                     RFC_DIRECTION direction, RFC_PARAMETER_TEXT paramText = nullptr,
-                     bool refresh = false);
+    static std::string mapExternalTypeToJavaScriptType(RFCTYPE sapType);
 
     void addObjectInfoToLogMeta(Napi::Object meta) override;
 
-    static Napi::FunctionReference ctor;
 
     Connection *connection{};
     RFC_FUNCTION_DESC_HANDLE functionDescHandle{};
+    std::u16string functionName{};
 };
 
 #endif /* FUNCTION_H_ */
@@ -0,0 +1,355 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#include "FunctionDescriptor.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const char16_t *AsChar16(const SAP_UC *value) {
+  return reinterpret_cast<const char16_t *>(value);
+}
+
+unsigned Align(unsigned offset, unsigned alignment) {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+bool CopyName(RFC_ABAP_NAME target, const std::u16string &name) {
+  if (name.empty() || name.size() >= sizeof(RFC_ABAP_NAME) / sizeof(SAP_UC)) {
+    return false;
+  }
+  memcpy(target, name.c_str(), (name.size() + 1) * sizeof(SAP_UC));
+  return true;
+}
+
+template<size_t N>
+void CopyText(SAP_UC (&target)[N], const std::u16string &text) {
+  auto length = text.size() < N ? text.size() : N - 1;
+  memcpy(target, text.data(), length * sizeof(SAP_UC));
+  target[length] = 0;
+}
+
+}
+
+FunctionDescriptor::FunctionDescriptor(Napi::Env env, const SAP_UC *repository, bool refresh)
+    : env{env}, repository{repository}, refresh{refresh} {}
+
+Napi::Error FunctionDescriptor::SchemaError(const std::u16string &name, const std::string &message) {
+  return Napi::TypeError::New(env, "Invalid schema of " + Napi::String::New(env, name).Utf8Value() + ": " + message);
+}
+
+RFCTYPE FunctionDescriptor::ParseType(Napi::Object element, const std::u16string &name) {
+  auto value = element.Get("sapType");
+  if (!value.IsString()) {
+    throw SchemaError(name, "sapType must be a string");
+  }
+  auto sapType = value.ToString().Utf16Value();
+  for (int type = 0; type < _RFCTYPE_max_value; type++) {
+    auto typeName = RfcGetTypeAsString(static_cast<RFCTYPE>(type));
+    if (typeName && sapType == AsChar16(typeName)) {
+      return static_cast<RFCTYPE>(type);
+    }
+  }
+  throw SchemaError(name, "unknown sapType");
+}
+
+RFC_DIRECTION FunctionDescriptor::ParseDirection(Napi::Object element, const std::u16string &name) {
+  auto value = element.Get("sapDirection");
+  if (!value.IsString()) {
+    throw SchemaError(name, "sapDirection must be a string");
+  }
+  auto sapDirection = value.ToString().Utf16Value();
+  for (auto direction : {RFC_IMPORT, RFC_EXPORT, RFC_CHANGING, RFC_TABLES}) {
+    if (sapDirection == AsChar16(RfcGetDirectionAsString(direction))) {
+      return direction;
+    }
+  }
+  throw SchemaError(name, "unknown sapDirection");
+}
+
+unsigned FunctionDescriptor::ParseUnsigned(Napi::Object element, const char *property, const std::u16string &name) {
+  auto value = element.Get(property);
+  if (value.IsUndefined()) {
+    return 0;
+  }
+  // MetaData() returns lengths as strings
+  auto number = value.IsString() || value.IsNumber() ? value.ToNumber().DoubleValue() : NAN;
+  if (!(number >= 0 && number <= UINT32_MAX) || std::floor(number) != number) {
+    throw SchemaError(name, std::string(property) + " must be a positive integer");
+  }
+  return static_cast<unsigned>(number);
+}
+
+/*
+ * Lengths and alignments of elementary types in non-Unicode and Unicode layouts. Deep types (strings and tables
+ * within structures) are references.
+ */
+FunctionDescriptor::Layout FunctionDescriptor::ElementLayout(RFCTYPE type, Napi::Object element,
+                                                             const std::u16string &name, bool deep) {
+  Layout layout;
+  auto fixed = [&layout](unsigned length, unsigned alignment) {
+    layout.nucLength = layout.ucLength = length;
+    layout.nucAlignment = layout.ucAlignment = alignment;
+  };
+
+  switch (type) {
+    case RFCTYPE_CHAR:
+    case RFCTYPE_NUM:
+    case RFCTYPE_DATE:
+    case RFCTYPE_TIME:
+      if (type == RFCTYPE_DATE || type == RFCTYPE_TIME) {
+        layout.nucLength = type == RFCTYPE_DATE ? 8 : 6;
+      } else {
+        layout.nucLength = ParseUnsigned(element, "length", name);
+      }
+      layout.ucLength = layout.nucLength * sizeof(SAP_UC);
+      layout.ucAlignment = sizeof(SAP_UC);
+      break;
+    case RFCTYPE_BYTE:
+    case RFCTYPE_BCD:
+      fixed(ParseUnsigned(element, "length", name), 1);
+      break;
+    case RFCTYPE_INT1:
+      fixed(1, 1);
+      break;
+    case RFCTYPE_INT2:
+      fixed(2, 2);
+      break;
+    case RFCTYPE_INT:
+    case RFCTYPE_DTDAY:
+    case RFCTYPE_DTWEEK:
+    case RFCTYPE_DTMONTH:
+    case RFCTYPE_TSECOND:
+    case RFCTYPE_TMINUTE:
+    case RFCTYPE_CDAY:
+      fixed(4, 4);
+      break;
+    case RFCTYPE_FLOAT:
+    case RFCTYPE_INT8:
+    case RFCTYPE_DECF16:
+    case RFCTYPE_UTCLONG:
+    case RFCTYPE_UTCSECOND:
+    case RFCTYPE_UTCMINUTE:
+      fixed(8, 8);
+      break;
+    case RFCTYPE_DECF34:
+      fixed(16, 8);
+      break;
+    case RFCTYPE_STRING:
+    case RFCTYPE_XSTRING:
+      fixed(deep ? 8 : 0, 8);
+      break;
+    default:
+      throw SchemaError(name, "sapType is not supported");
+  }
+  return layout;
+}
+
+const FunctionDescriptor::Type &FunctionDescriptor::DefineType(Napi::Object element, const std::u16string &name) {
+  auto typeNameValue = element.Get("sapTypeName");
+  auto properties = element.Get("properties");
+  if (!typeNameValue.IsString() || !properties.IsObject()) {
+    throw SchemaError(name, "structures need sapTypeName and properties");
+  }
+  auto typeName = typeNameValue.ToString().Utf16Value();
+  auto known = types.find(typeName);
+  if (known != types.end()) {
+    return known->second;
+  }
+
+  // The layout is needed for the parameters and enclosing types even if the type itself is cached
+  Type type;
+  std::vector<RFC_FIELD_DESC> fields;
+  auto fieldNames = properties.ToObject().GetPropertyNames();
+  unsigned nucOffset{}, ucOffset{};
+  for (uint32_t i = 0; i < fieldNames.Length(); i++) {
+    auto fieldName = fieldNames.Get(i).ToString().Utf16Value();
+    auto fieldValue = properties.ToObject().Get(fieldNames.Get(i));
+    if (!fieldValue.IsObject()) {
+      throw SchemaError(fieldName, "must be an object");
+    }
+    auto fieldElement = fieldValue.ToObject();
+
+    RFC_FIELD_DESC fieldDesc{};
+    if (!CopyName(fieldDesc.name, fieldName)) {
+      throw SchemaError(fieldName, "invalid field name");
+    }
+    fieldDesc.type = ParseType(fieldElement, fieldName);
+    fieldDesc.decimals = ParseUnsigned(fieldElement, "decimals", fieldName);
+
+    Layout fieldLayout;
+    if (fieldDesc.type == RFCTYPE_STRUCTURE) {
+      auto &fieldType = DefineType(fieldElement, fieldName);
+      fieldDesc.typeDescHandle = fieldType.handle;
+      fieldLayout = fieldType.layout;
+    } else if (fieldDesc.type == RFCTYPE_TABLE) {
+      auto items = fieldElement.Get("items");
+      if (!items.IsObject()) {
+        throw SchemaError(fieldName, "tables need items");
+      }
+      fieldDesc.typeDescHandle = DefineType(items.ToObject(), fieldName).handle;
+      fieldLayout.nucLength = fieldLayout.ucLength = 8;
+      fieldLayout.nucAlignment = fieldLayout.ucAlignment = 8;
+    } else {
+      fieldLayout = ElementLayout(fieldDesc.type, fieldElement, fieldName, true);
+    }
+
+    nucOffset = Align(nucOffset, fieldLayout.nucAlignment);
+    ucOffset = Align(ucOffset, fieldLayout.ucAlignment);
+    fieldDesc.nucOffset = nucOffset;
+    fieldDesc.ucOffset = ucOffset;
+    fieldDesc.nucLength = fieldLayout.nucLength;
+    fieldDesc.ucLength = fieldLayout.ucLength;
+    nucOffset += fieldLayout.nucLength;
+    ucOffset += fieldLayout.ucLength;
+    type.layout.nucAlignment = std::max(type.layout.nucAlignment, fieldLayout.nucAlignment);
+    type.layout.ucAlignment = std::max(type.layout.ucAlignment, fieldLayout.ucAlignment);
+    fields.push_back(fieldDesc);
+  }
+  type.layout.nucLength = Align(nucOffset, type.layout.nucAlignment);
+  type.layout.ucLength = Align(ucOffset, type.layout.ucAlignment);
+
+  auto sapTypeName = reinterpret_cast<const SAP_UC *>(typeName.c_str());
+  if (refresh) {
+    RfcRemoveTypeDesc(repository, sapTypeName, &errorInfo);
+  } else {
+    type.handle = RfcGetCachedTypeDesc(repository, sapTypeName, &errorInfo);
+  }
+
+  if (!type.handle) {
+    type.handle = RfcCreateTypeDesc(sapTypeName, &errorInfo);
+    if (!type.handle) {
+      throw RfcError(env, errorInfo);
+    }
+    errorInfo = RFC_ERROR_INFO{};
+    for (const auto &fieldDesc : fields) {
+      if (RfcAddTypeField(type.handle, &fieldDesc, &errorInfo) != RFC_OK) {
+        break;
+      }
+    }
+    if (errorInfo.code != RFC_OK ||
+        RfcSetTypeLength(type.handle, type.layout.nucLength, type.layout.ucLength, &errorInfo) != RFC_OK ||
+        RfcAddTypeDesc(repository, type.handle, &errorInfo) != RFC_OK) {
+      RFC_ERROR_INFO destroyErrorInfo{};
+      RfcDestroyTypeDesc(type.handle, &destroyErrorInfo);
+      throw RfcError(env, errorInfo);
+    }
+  }
+
+  return types.emplace(typeName, type).first->second;
+}
+
+RFC_FUNCTION_DESC_HANDLE FunctionDescriptor::Define(const std::u16string &functionName, Napi::Object schema) {
+  Napi::HandleScope scope{env};
+
+  RFC_ABAP_NAME name{};
+  if (!CopyName(name, functionName)) {
+    throw SchemaError(functionName, "invalid function name");
+  }
+  auto properties = schema.Get("properties");
+  if (!properties.IsObject()) {
+    throw SchemaError(functionName, "properties must be an object");
+  }
+
+  if (refresh) {
+    RfcRemoveFunctionDesc(repository, name, &errorInfo);
+  } else {
+    auto cached = RfcGetCachedFunctionDesc(repository, name, &errorInfo);
+    if (cached) {
+      return cached;
+    }
+  }
+
+  // Types are defined before the function descriptor, so that a schema error leaves nothing to clean up
+  std::vector<RFC_PARAMETER_DESC> parameters;
+  auto parameterNames = properties.ToObject().GetPropertyNames();
+  for (uint32_t i = 0; i < parameterNames.Length(); i++) {
+    auto parameterName = parameterNames.Get(i).ToString().Utf16Value();
+    auto parameterValue = properties.ToObject().Get(parameterNames.Get(i));
+    if (!parameterValue.IsObject()) {
+      throw SchemaError(parameterName, "must be an object");
+    }
+    auto element = parameterValue.ToObject();
+
+    RFC_PARAMETER_DESC parmDesc{};
+    if (!CopyName(parmDesc.name, parameterName)) {
+      throw SchemaError(parameterName, "invalid parameter name");
+    }
+    parmDesc.type = ParseType(element, parameterName);
+    parmDesc.direction = ParseDirection(element, parameterName);
+    parmDesc.decimals = ParseUnsigned(element, "decimals", parameterName);
+    parmDesc.optional = element.Get("optional").ToBoolean() ? 1 : 0;
+    auto description = element.Get("description");
+    if (description.IsString()) {
+      CopyText(parmDesc.parameterText, description.ToString().Utf16Value());
+    }
+    auto defaultValue = element.Get("defaultValue");
+    if (defaultValue.IsString()) {
+      CopyText(parmDesc.defaultValue, defaultValue.ToString().Utf16Value());
+    }
+
+    Layout layout;
+    if (parmDesc.type == RFCTYPE_STRUCTURE) {
+      auto &type = DefineType(element, parameterName);
+      parmDesc.typeDescHandle = type.handle;
+      layout = type.layout;
+    } else if (parmDesc.type == RFCTYPE_TABLE) {
+      auto items = element.Get("items");
+      if (!items.IsObject()) {
+        throw SchemaError(parameterName, "tables need items");
+      }
+      auto &type = DefineType(items.ToObject(), parameterName);
+      parmDesc.typeDescHandle = type.handle;
+      layout = type.layout;
+    } else {
+      layout = ElementLayout(parmDesc.type, element, parameterName, false);
+    }
+    parmDesc.nucLength = layout.nucLength;
+    parmDesc.ucLength = layout.ucLength;
+    parameters.push_back(parmDesc);
+  }
+
+  auto functionDescHandle = RfcCreateFunctionDesc(name, &errorInfo);
+  if (!functionDescHandle) {
+    throw RfcError(env, errorInfo);
+  }
+  errorInfo = RFC_ERROR_INFO{};
+  for (const auto &parmDesc : parameters) {
+    if (RfcAddParameter(functionDescHandle, &parmDesc, &errorInfo) != RFC_OK) {
+      break;
+    }
+  }
+  if (errorInfo.code != RFC_OK || RfcAddFunctionDesc(repository, functionDescHandle, &errorInfo) != RFC_OK) {
+    RFC_ERROR_INFO destroyErrorInfo{};
+    RfcDestroyFunctionDesc(functionDescHandle, &destroyErrorInfo);
+    throw RfcError(env, errorInfo);
+  }
+  return functionDescHandle;
+}
@@ -0,0 +1,83 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#ifndef SAPNWRFC_FUNCTIONDESCRIPTOR_H
+#define SAPNWRFC_FUNCTIONDESCRIPTOR_H
+
+#include <napi.h>
+#include <sapnwrfc.h>
+#include <string>
+#include <unordered_map>
+
+/*
+ * Builds function and type descriptors from a schema in the shape returned by Function.MetaData(), without a
+ * DDIC round-trip. The schema has no offsets, so the layout of structures is derived from the ABAP alignment
+ * rules of the field types.
+ *
+ * The descriptors are added to the SDK's cache of a repository, which keeps them alive for all containers
+ * created from them. Descriptors which are already cached are reused unless refresh is set.
+ */
+class FunctionDescriptor {
+  public:
+    /*
+     * repository is a system id, or nullptr for the SDK's default repository used for all systems.
+     */
+    FunctionDescriptor(Napi::Env env, const SAP_UC *repository, bool refresh);
+
+    RFC_FUNCTION_DESC_HANDLE Define(const std::u16string &functionName, Napi::Object schema);
+
+  protected:
+    struct Layout {
+      unsigned nucLength{};
+      unsigned ucLength{};
+      unsigned nucAlignment{1};
+      unsigned ucAlignment{1};
+    };
+
+    struct Type {
+      RFC_TYPE_DESC_HANDLE handle{};
+      Layout layout;
+    };
+
+    RFCTYPE ParseType(Napi::Object element, const std::u16string &name);
+    RFC_DIRECTION ParseDirection(Napi::Object element, const std::u16string &name);
+    unsigned ParseUnsigned(Napi::Object element, const char *property, const std::u16string &name);
+
+    /*
+     * Defines the structure type of a schema element with properties, or returns the type already defined.
+     */
+    const Type &DefineType(Napi::Object element, const std::u16string &name);
+    Layout ElementLayout(RFCTYPE type, Napi::Object element, const std::u16string &name, bool deep);
+
+    Napi::Error SchemaError(const std::u16string &name, const std::string &message);
+
+    Napi::Env env;
+    const SAP_UC *repository;
+    bool refresh;
+    RFC_ERROR_INFO errorInfo{};
+    std::unordered_map<std::u16string, Type> types;
+};
+
+#endif //SAPNWRFC_FUNCTIONDESCRIPTOR_H
@@ -24,24 +24,150 @@ SOFTWARE.
 */
 
 #include "FunctionInvoke.h"
+#include "AddonData.h"
+#include "LazyResult.h"
 #include <cassert>
 
 FunctionInvoke::FunctionInvoke(const Napi::Function &callback, Connection *connection, Function *function,
-                               RFC_DATA_CONTAINER *functionHandle)
-    : AsyncWorker(callback), connection(connection), function(function), functionHandle(functionHandle) {}
+                               RFC_DATA_CONTAINER *functionHandle, const Napi::Object &options)
+    : RfcWorker(callback.Env(), callback, *connection->queue), connection(connection), function(function),
+      functionHandle(functionHandle),
+      options(Napi::Persistent(options)), idempotent(options.Get("idempotent").ToBoolean()) {}
 
+FunctionInvoke::FunctionInvoke(const Napi::Function &callback, Connection *connection, Function *function,
+                               std::shared_ptr<ResultCache::Entry> cacheEntry, const Napi::Object &options)
+    : RfcWorker(callback.Env(), callback, *connection->queue), connection(connection), function(function),
+      functionHandle(nullptr),
+      options(Napi::Persistent(options)), cacheEntry(std::move(cacheEntry)) {}
+
+void FunctionInvoke::CacheResult(const std::string &key, std::chrono::milliseconds ttl) {
+  cacheKey = key;
+  cacheTtl = ttl;
+}
+
+void FunctionInvoke::Coalesce(const std::string &key) {
+  coalesceKey = key;
+  AddonData::Get(Env()).inFlight[key] = this;
+}
+
+void FunctionInvoke::AddFollower(const Napi::Function &callback, Function *function,
+                                 RFC_FUNCTION_HANDLE functionHandle, const Napi::Object &options) {
+  followers.push_back(Follower{Napi::Persistent(callback), function, Napi::Persistent(options), functionHandle});
+}
+
+FunctionInvoke *FunctionInvoke::FindInFlight(Napi::Env env, const std::string &key) {
+  auto &inFlight = AddonData::Get(env).inFlight;
+  auto it = inFlight.find(key);
+  return it != inFlight.end() ? it->second : nullptr;
+}
+
+void FunctionInvoke::StopCoalescing() {
+  if (coalesceKey.empty()) {
+    return;
+  }
+  auto &inFlight = AddonData::Get(Env()).inFlight;
+  auto it = inFlight.find(coalesceKey);
+  if (it != inFlight.end() && it->second == this) {
+    inFlight.erase(it);
+  }
+  coalesceKey.clear();
+}
+
+void FunctionInvoke::PromoteFollower() {
+  auto env = Env();
+  Napi::HandleScope scope{env};
+
+  auto &leader = followers.front();
+  auto options = leader.options.Value();
+  auto worker = new FunctionInvoke{leader.callback.Value(), connection, leader.function, leader.functionHandle, options};
+  if (!cacheKey.empty()) {
+    worker->CacheResult(cacheKey, cacheTtl);
+  }
+  worker->Coalesce(coalesceKey);
+  auto timeout = options.Get("timeout");
+  if (timeout.IsNumber()) {
+    worker->SetTimeout(timeout.ToNumber().Uint32Value());
+  }
+
+  // The new worker takes over the references to the functions of its followers
+  for (size_t i = 1; i < followers.size(); i++) {
+    worker->followers.push_back(std::move(followers[i]));
+  }
+  followers.clear();
+
+  function->log(env, Loggable::Levels::DBG, "Function::Invoke: Coalesced invocation continues without its leader");
+  worker->Queue();
+}
+
+bool FunctionInvoke::UsesConnection() {
+  // Cached results do not wait for the connection
+  return !cacheEntry;
+}
+
+void FunctionInvoke::Cancel() {
+  RfcWorker::Cancel();
+
+  // Outside of RfcInvoke, e.g. during a retry backoff or a reopen, Execute() sees the flag instead
+  std::lock_guard<std::mutex> lock{invokingMutex};
+  if (!invoking) {
+    return;
+  }
+
+  // RfcInvoke returns with RFC_CANCELED, the SDK closes the connection
+  RFC_ERROR_INFO errorInfo{};
+  RfcCancel(connection->connectionHandle, &errorInfo);
+  connection->deferLogAPICall("RfcCancel", __FILE__, BOOST_CURRENT_FUNCTION, __LINE__, errorInfo);
+}
 
 void FunctionInvoke::Execute() {
+  // Cached results are only decoded
+  if (cacheEntry) {
+    return;
+  }
+
   assert(functionHandle != nullptr);
   assert(connection != nullptr);
   assert(function != nullptr);
 
+  if (IsCancelled()) {
+    SetError("Call cancelled");
+    return;
+  }
+
   connection->LockMutex();
 
+  // A closed or broken connection is opened again before anything is sent, so every call may wait for it
+  if (connection->reconnect.enabled && !connection->IsHandleValid()) {
+    if (!connection->Reopen(function->errorInfo)) {
+      connection->UnlockMutex();
+      if (attempts < connection->reconnect.retries) {
+        RetryAfter(connection->Backoff(++attempts));
+      } else {
+        SetError("Error reopening connection");
+      }
+      return;
+    }
+  }
+
+  // Cancelled meanwhile, the flag is checked under the lock Cancel() takes before interrupting
+  {
+    std::lock_guard<std::mutex> lock{invokingMutex};
+    invoking = !IsCancelled();
+  }
+  if (!invoking) {
+    connection->UnlockMutex();
+    SetError("Call cancelled");
+    return;
+  }
+
   // Invocation
   RfcInvoke(connection->GetConnectionHandle(), functionHandle, &function->errorInfo);
   DEFER_LOG_API(function, "RfcInvoke");
 
+  std::unique_lock<std::mutex> invokingLock{invokingMutex};
+  invoking = false;
+  invokingLock.unlock();
+
   // If handle is invalid, fetch a better error message
   if (function->errorInfo.code == RFC_INVALID_HANDLE) {
     int isValid{};
@@ -49,28 +175,132 @@ void FunctionInvoke::Execute() {
     DEFER_LOG_API(function, "RfcIsConnectionHandleValid");
   }
 
+  // A cancelled connection has been closed by RfcCancel
+  if (function->errorInfo.code == RFC_CANCELED) {
+    connection->connectionHandle = nullptr;
+  }
+
   connection->UnlockMutex();
 
+  // The call may have been executed before the connection broke, then only idempotent calls are repeated
+  auto code = function->errorInfo.code;
+  if ((code == RFC_INVALID_HANDLE || (code == RFC_COMMUNICATION_FAILURE && idempotent)) &&
+      connection->reconnect.enabled && !IsCancelled() && attempts < connection->reconnect.retries) {
+    connection->retriedCalls++;
+    RetryAfter(connection->Backoff(++attempts));
+    return;
+  }
+
   if (function->errorInfo.code != RFC_OK) {
     SetError("Error invoking function");
   }
 }
 
 void FunctionInvoke::OnOK() {
-  Napi::HandleScope scope{Env()};
-  auto result = function->DoReceive(Env(), functionHandle);
-  if (IsException(Env(), result)) {
-    Callback().Call({result, Env().Undefined()});
-  } else {
-    Callback().Call({Env().Undefined(), result});
+  auto env = Env();
+  Napi::HandleScope scope{env};
+
+  // Later invocations must not attach to a finished call
+  StopCoalescing();
+
+  if (options.Value().Get("lazy").ToBoolean()) {
+    // The result takes over the container and decodes it on demand
+    auto result = LazyResult::NewInstance(env, *function, functionHandle);
+    functionHandle = nullptr;
+    Callback().Call({env.Undefined(), result});
+    return;
+  }
+
+  if (!cacheKey.empty()) {
+    auto size = function->ContainerSize(functionHandle);
+    cacheEntry = ResultCache::Instance(env).Insert(cacheKey, functionHandle, size, cacheTtl);
+    functionHandle = nullptr;
+  }
+
+  // A throwing callback must not keep the other callers waiting, the first exception is rethrown at the end
+  Napi::Value exception;
+  auto notify = [&exception](Napi::FunctionReference &callback, Napi::Env env, Napi::Value result) {
+    try {
+      if (IsException(env, result)) {
+        callback.Call({result, env.Undefined()});
+      } else {
+        callback.Call({env.Undefined(), result});
+      }
+    } catch (const Napi::Error &e) {
+      if (exception.IsEmpty()) {
+        exception = e.Value();
+      }
+    }
+  };
+
+  auto container = cacheEntry ? cacheEntry->functionHandle : functionHandle;
+  notify(Callback(), env, function->DoReceive(env, container, options.Value()));
+
+  // Every coalesced caller decodes its own result from the shared container
+  for (auto &follower : followers) {
+    Napi::HandleScope followerScope{env};
+    notify(follower.callback, env, follower.function->DoReceive(env, container, follower.options.Value()));
+  }
+
+  if (!exception.IsEmpty()) {
+    throw Napi::Error(env, exception);
   }
 }
 
 void FunctionInvoke::OnError(const Napi::Error &e) {
-  Callback().Call({RfcError(Env(), function->errorInfo).Value()});
+  auto env = Env();
+  Napi::HandleScope scope{env};
+
+  // Only the leader asked for its cancellation or timeout, its followers are invoked without it
+  if ((IsCancelled() || IsTimedOut()) && !followers.empty()) {
+    PromoteFollower();
+  }
+  StopCoalescing();
+
+  Napi::Value exception;
+  try {
+    Callback().Call({IsCancelled() ? e.Value() : RfcError(env, function->errorInfo).Value()});
+  } catch (const Napi::Error &callbackError) {
+    exception = callbackError.Value();
+  }
+
+  for (auto &follower : followers) {
+    Napi::HandleScope followerScope{env};
+    try {
+      follower.callback.Call({RfcError(env, function->errorInfo).Value()});
+    } catch (const Napi::Error &callbackError) {
+      if (exception.IsEmpty()) {
+        exception = callbackError.Value();
+      }
+    }
+  }
+
+  if (!exception.IsEmpty()) {
+    throw Napi::Error(env, exception);
+  }
+}
+
+void FunctionInvoke::OnTimeout() {
+  Napi::HandleScope scope{Env()};
+
+  // Name the function module and the system, so that slow ABAP code can be found
+  auto error = TimeoutError(Env(), Timeout());
+  error.Set("functionName", Napi::String::New(Env(), function->functionName));
+  error.Set("connection", connection->LogonInfo(Env()));
+  function->log(Env(), Loggable::Levels::WARN, "Function::Invoke: Call timed out", error.Value());
+
+  OnError(error);
 }
 
 FunctionInvoke::~FunctionInvoke() {
+  StopCoalescing();
+  for (auto &follower : followers) {
+    if (follower.functionHandle) {
+      RfcDestroyFunction(follower.functionHandle, &follower.function->errorInfo);
+    }
+    follower.function->Reference::Unref();
+  }
+
   if (functionHandle) {
     RfcDestroyFunction(functionHandle, &function->errorInfo);
     LOG_API(Env(), function, "RfcDestroyFunction");
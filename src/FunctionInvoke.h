@@ -28,28 +28,82 @@ SOFTWARE.
 #include <napi.h>
 #include "Connection.h"
 #include "Function.h"
+#include "ResultCache.h"
+#include "RfcWorker.h"
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
-class FunctionInvoke : public Napi::AsyncWorker {
+class FunctionInvoke : public RfcWorker {
   public:
     FunctionInvoke(const Napi::Function &callback, Connection *connection, Function *function,
-                   RFC_DATA_CONTAINER *functionHandle);
+                   RFC_DATA_CONTAINER *functionHandle, const Napi::Object &options);
+    FunctionInvoke(const Napi::Function &callback, Connection *connection, Function *function,
+                   std::shared_ptr<ResultCache::Entry> cacheEntry, const Napi::Object &options);
     FunctionInvoke(const FunctionInvoke &) = delete;
     FunctionInvoke &operator=(const FunctionInvoke &) = delete;
-    FunctionInvoke(FunctionInvoke &&) = default;
-    FunctionInvoke &operator=(FunctionInvoke &&) = default;
 
     virtual ~FunctionInvoke();
 
-  protected:
+    /*
+     * Stores the function container in the result cache after a successful invocation.
+     */
+    void CacheResult(const std::string &key, std::chrono::milliseconds ttl);
+
+    /*
+     * Registers the invocation as in flight, so that identical invocations can share its result.
+     */
+    void Coalesce(const std::string &key);
+    /*
+     * Joins an identical invocation, which takes over the follower's own container. It is invoked in place of the
+     * leader if the leader is cancelled or times out.
+     */
+    void AddFollower(const Napi::Function &callback, Function *function, RFC_FUNCTION_HANDLE functionHandle,
+                     const Napi::Object &options);
+
+    static FunctionInvoke *FindInFlight(Napi::Env env, const std::string &key);
+
+    bool UsesConnection() override;
+    void Cancel() override;
     void Execute() override;
+
+  protected:
     void OnOK() override;
     void OnError(const Napi::Error &e) override;
+    void OnTimeout() override;
 
 
   private:
+    struct Follower {
+      Napi::FunctionReference callback;
+      Function *function;
+      Napi::ObjectReference options;
+      RFC_FUNCTION_HANDLE functionHandle;
+    };
+
+    void StopCoalescing();
+
+    /*
+     * Queues the first follower as new leader of the others, so that they do not fail with the leader's
+     * cancellation or timeout.
+     */
+    void PromoteFollower();
+
     Connection *connection;
     Function *function;
     RFC_FUNCTION_HANDLE functionHandle;
+    Napi::ObjectReference options;
+    std::shared_ptr<ResultCache::Entry> cacheEntry;
+    std::string cacheKey;
+    std::chrono::milliseconds cacheTtl{};
+    std::string coalesceKey;
+    std::vector<Follower> followers;
+    bool idempotent{};
+    uint32_t attempts{};
+
+    // Set while RfcInvoke() runs, only then Cancel() interrupts the connection
+    std::mutex invokingMutex;
+    bool invoking{};
 };
 
 
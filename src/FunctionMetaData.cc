@@ -0,0 +1,69 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#include "FunctionMetaData.h"
+#include "AddonData.h"
+
+FunctionMetaData::FunctionMetaData(Napi::Env env, const Napi::Value &callback, Connection *connection,
+                                   RFC_FUNCTION_DESC_HANDLE functionDescHandle, std::string format)
+    : ConnectionWorker{env, callback, connection, *AddonData::Get(env).localQueue},
+      functionDescHandle{functionDescHandle}, format{std::move(format)} {
+  auto &cache = AddonData::Get(env).schemaCache;
+  generation = cache.Generation();
+  // Keep the cached schema, the cache may be invalidated before the completion
+  auto entry = cache.Find(functionDescHandle);
+  if (entry) {
+    schema = entry->schema;
+  }
+}
+
+bool FunctionMetaData::UsesConnection() {
+  return !schema;
+}
+
+void FunctionMetaData::Execute() {
+  schema = FunctionSchema::Build(functionDescHandle, errorInfo);
+  if (!schema) {
+    SetError("Function::MetaDataAsync: reading the function description failed");
+  }
+}
+
+Napi::Value FunctionMetaData::Result() {
+  auto env = Env();
+  Napi::EscapableHandleScope scope{env};
+
+  auto &cache = AddonData::Get(env).schemaCache;
+  auto entry = cache.Find(functionDescHandle);
+  if (!entry) {
+    entry = cache.Insert(functionDescHandle, schema, generation);
+  }
+  if (!entry || entry->schema != schema) {
+    // Metadata was refreshed meanwhile, the schema is handed out once but not cached
+    SchemaCache::Entry uncached;
+    uncached.schema = schema;
+    return scope.Escape(SchemaCache::Format(env, uncached, format));
+  }
+  return scope.Escape(SchemaCache::Format(env, *entry, format));
+}
@@ -0,0 +1,55 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#ifndef SAPNWRFC_FUNCTIONMETADATA_H
+#define SAPNWRFC_FUNCTIONMETADATA_H
+
+#include <memory>
+#include <string>
+#include "ConnectionWorker.h"
+#include "FunctionSchema.h"
+
+/*
+ * Builds the schema of a function descriptor for MetaDataAsync(). It runs on the environment's local queue
+ * instead of the connection's, so it never waits for invocations. Cached schemas are returned without a thread hop.
+ */
+class FunctionMetaData : public ConnectionWorker {
+  public:
+    FunctionMetaData(Napi::Env env, const Napi::Value &callback, Connection *connection,
+                     RFC_FUNCTION_DESC_HANDLE functionDescHandle, std::string format);
+
+  protected:
+    bool UsesConnection() override;
+    void Execute() override;
+    Napi::Value Result() override;
+
+  private:
+    RFC_FUNCTION_DESC_HANDLE functionDescHandle;
+    std::string format;
+    uint64_t generation;
+    std::shared_ptr<const FunctionSchema> schema;
+};
+
+#endif //SAPNWRFC_FUNCTIONMETADATA_H
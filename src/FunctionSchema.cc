@@ -0,0 +1,373 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#include "FunctionSchema.h"
+#include "Function.h"
+#include <cstdio>
+
+namespace {
+
+const char16_t *AsChar16(const SAP_UC *value) {
+  return reinterpret_cast<const char16_t *>(value);
+}
+
+std::u16string FromSAPUC(const SAP_UC *value, size_t capacity) {
+  auto units = AsChar16(value);
+  size_t length = 0;
+  while (length < capacity && units[length] != 0) {
+    length++;
+  }
+  return std::u16string(units, length);
+}
+
+/*
+ * Appends a JSON string literal, converting UTF-16 to UTF-8.
+ */
+void AppendJsonString(const std::u16string &value, std::string &json) {
+  json += '"';
+  for (size_t i = 0; i < value.size(); i++) {
+    uint32_t c = value[i];
+    if (c >= 0xd800 && c < 0xdc00 && i + 1 < value.size() && value[i + 1] >= 0xdc00 && value[i + 1] < 0xe000) {
+      c = 0x10000 + ((c - 0xd800) << 10) + (value[++i] - 0xdc00);
+    }
+    if (c == '"' || c == '\\') {
+      json += '\\';
+      json += static_cast<char>(c);
+    } else if (c < 0x20) {
+      char escaped[7];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      json += escaped;
+    } else if (c < 0x80) {
+      json += static_cast<char>(c);
+    } else if (c < 0x800) {
+      json += static_cast<char>(0xc0 | (c >> 6));
+      json += static_cast<char>(0x80 | (c & 0x3f));
+    } else if (c < 0x10000) {
+      json += static_cast<char>(0xe0 | (c >> 12));
+      json += static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+      json += static_cast<char>(0x80 | (c & 0x3f));
+    } else {
+      json += static_cast<char>(0xf0 | (c >> 18));
+      json += static_cast<char>(0x80 | ((c >> 12) & 0x3f));
+      json += static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+      json += static_cast<char>(0x80 | (c & 0x3f));
+    }
+  }
+  json += '"';
+}
+
+void AppendJsonString(const std::string &ascii, std::string &json) {
+  AppendJsonString(std::u16string(ascii.begin(), ascii.end()), json);
+}
+
+void AppendJsonKey(const char *key, std::string &json) {
+  json += '"';
+  json += key;
+  json += "\":";
+}
+
+const std::u16string TitlePrefix = u"Signature of SAP RFC function ";
+
+}
+
+std::shared_ptr<const TypeSchema> FunctionSchema::BuildType(RFC_TYPE_DESC_HANDLE typeHandle,
+    RFC_ERROR_INFO &errorInfo, std::unordered_map<std::u16string, std::shared_ptr<const TypeSchema> > &types) {
+  RFC_ABAP_NAME typeName{};
+  if (RfcGetTypeName(typeHandle, typeName, &errorInfo) != RFC_OK) {
+    return nullptr;
+  }
+  auto name = FromSAPUC(typeName, sizeof(typeName) / sizeof(SAP_UC));
+  auto known = types.find(name);
+  if (known != types.end()) {
+    return known->second;
+  }
+
+  auto type = std::make_shared<TypeSchema>();
+  type->name = name;
+  unsigned fieldCount{};
+  if (RfcGetFieldCount(typeHandle, &fieldCount, &errorInfo) != RFC_OK) {
+    return nullptr;
+  }
+  type->fields.reserve(fieldCount);
+  for (unsigned i = 0; i < fieldCount; i++) {
+    RFC_FIELD_DESC fieldDesc{};
+    if (RfcGetFieldDescByIndex(typeHandle, i, &fieldDesc, &errorInfo) != RFC_OK) {
+      return nullptr;
+    }
+    ElementSchema field;
+    field.name = FromSAPUC(fieldDesc.name, sizeof(fieldDesc.name) / sizeof(SAP_UC));
+    field.type = fieldDesc.type;
+    field.nucLength = fieldDesc.nucLength;
+    field.ucLength = fieldDesc.ucLength;
+    field.decimals = fieldDesc.decimals;
+    if (field.type == RFCTYPE_STRUCTURE || field.type == RFCTYPE_TABLE) {
+      field.rowType = BuildType(fieldDesc.typeDescHandle, errorInfo, types);
+      if (!field.rowType) {
+        return nullptr;
+      }
+    }
+    type->index[field.name] = type->fields.size();
+    type->fields.push_back(std::move(field));
+  }
+
+  types[name] = type;
+  return type;
+}
+
+std::shared_ptr<const FunctionSchema> FunctionSchema::Build(RFC_FUNCTION_DESC_HANDLE functionDescHandle,
+                                                            RFC_ERROR_INFO &errorInfo) {
+  auto schema = std::make_shared<FunctionSchema>();
+
+  RFC_ABAP_NAME functionName{};
+  unsigned parmCount{};
+  if (RfcGetFunctionName(functionDescHandle, functionName, &errorInfo) != RFC_OK ||
+      RfcGetParameterCount(functionDescHandle, &parmCount, &errorInfo) != RFC_OK) {
+    return nullptr;
+  }
+  schema->functionName = FromSAPUC(functionName, sizeof(functionName) / sizeof(SAP_UC));
+
+  // Types used by several parameters are shared
+  std::unordered_map<std::u16string, std::shared_ptr<const TypeSchema> > types;
+  schema->parameters.reserve(parmCount);
+  for (unsigned i = 0; i < parmCount; i++) {
+    RFC_PARAMETER_DESC parmDesc{};
+    if (RfcGetParameterDescByIndex(functionDescHandle, i, &parmDesc, &errorInfo) != RFC_OK) {
+      return nullptr;
+    }
+    ElementSchema parameter;
+    parameter.name = FromSAPUC(parmDesc.name, sizeof(parmDesc.name) / sizeof(SAP_UC));
+    parameter.type = parmDesc.type;
+    parameter.nucLength = parmDesc.nucLength;
+    parameter.ucLength = parmDesc.ucLength;
+    parameter.decimals = parmDesc.decimals;
+    parameter.isParameter = true;
+    parameter.direction = parmDesc.direction;
+    parameter.optional = parmDesc.optional != 0;
+    parameter.description = FromSAPUC(parmDesc.parameterText, sizeof(parmDesc.parameterText) / sizeof(SAP_UC));
+    if (parameter.type == RFCTYPE_STRUCTURE || parameter.type == RFCTYPE_TABLE) {
+      parameter.rowType = BuildType(parmDesc.typeDescHandle, errorInfo, types);
+      if (!parameter.rowType) {
+        return nullptr;
+      }
+    }
+    schema->index[parameter.name] = schema->parameters.size();
+    schema->parameters.push_back(std::move(parameter));
+  }
+
+  auto &json = schema->json;
+  json += '{';
+  AppendJsonKey("title", json);
+  AppendJsonString(TitlePrefix + schema->functionName, json);
+  json += ',';
+  AppendJsonKey("type", json);
+  json += "\"object\",";
+  AppendJsonKey("properties", json);
+  json += '{';
+  for (size_t i = 0; i < schema->parameters.size(); i++) {
+    if (i > 0) {
+      json += ',';
+    }
+    ElementToJson(schema->parameters[i], json);
+  }
+  json += "}}";
+
+  return schema;
+}
+
+// Scale of packed and decimal floating point numbers, which Define() needs to rebuild the element
+bool FunctionSchema::HasDecimals(RFCTYPE type) {
+  return type == RFCTYPE_BCD || type == RFCTYPE_DECF16 || type == RFCTYPE_DECF34;
+}
+
+void FunctionSchema::ElementToJson(const ElementSchema &element, std::string &json) {
+  AppendJsonString(element.name, json);
+  json += ":{";
+  AppendJsonKey("type", json);
+  AppendJsonString(Function::mapExternalTypeToJavaScriptType(element.type), json);
+  json += ',';
+  AppendJsonKey("length", json);
+  AppendJsonString(std::to_string(element.nucLength), json);
+  json += ',';
+  AppendJsonKey("sapType", json);
+  AppendJsonString(AsChar16(RfcGetTypeAsString(element.type)), json);
+  if (HasDecimals(element.type)) {
+    json += ',';
+    AppendJsonKey("decimals", json);
+    AppendJsonString(std::to_string(element.decimals), json);
+  }
+  if (element.isParameter) {
+    json += ',';
+    AppendJsonKey("description", json);
+    AppendJsonString(element.description, json);
+    json += ',';
+    AppendJsonKey("sapDirection", json);
+    AppendJsonString(AsChar16(RfcGetDirectionAsString(element.direction)), json);
+    json += ',';
+    AppendJsonKey("optional", json);
+    json += element.optional ? "true" : "false";
+  }
+  if (element.type == RFCTYPE_STRUCTURE) {
+    json += ',';
+    TypeToJson(*element.rowType, json);
+  } else if (element.type == RFCTYPE_TABLE) {
+    json += ',';
+    AppendJsonKey("items", json);
+    json += '{';
+    TypeToJson(*element.rowType, json);
+    json += '}';
+  }
+  json += '}';
+}
+
+void FunctionSchema::TypeToJson(const TypeSchema &type, std::string &json) {
+  AppendJsonKey("sapTypeName", json);
+  AppendJsonString(type.name, json);
+  json += ',';
+  AppendJsonKey("type", json);
+  json += "\"object\",";
+  AppendJsonKey("properties", json);
+  json += '{';
+  for (size_t i = 0; i < type.fields.size(); i++) {
+    if (i > 0) {
+      json += ',';
+    }
+    ElementToJson(type.fields[i], json);
+  }
+  json += '}';
+}
+
+Napi::Object FunctionSchema::ToObject(Napi::Env env, bool freeze) const {
+  Napi::EscapableHandleScope scope{env};
+
+  Napi::Function freezeFunction;
+  if (freeze) {
+    freezeFunction = env.Global().Get("Object").As<Napi::Object>().Get("freeze").As<Napi::Function>();
+  }
+
+  auto metaObject = Napi::Object::New(env);
+  metaObject.Set("title", Napi::String::New(env, TitlePrefix + functionName));
+  metaObject.Set("type", Napi::String::New(env, "object"));
+  auto properties = Napi::Object::New(env);
+  for (const auto &parameter : parameters) {
+    properties.Set(Napi::String::New(env, parameter.name), ElementToObject(env, parameter, freezeFunction));
+  }
+  metaObject.Set("properties", properties);
+
+  if (freeze) {
+    freezeFunction.Call({properties});
+    freezeFunction.Call({metaObject});
+  }
+  return scope.Escape(metaObject).As<Napi::Object>();
+}
+
+Napi::Object FunctionSchema::ElementToObject(Napi::Env env, const ElementSchema &element, Napi::Function freeze) {
+  Napi::EscapableHandleScope scope{env};
+
+  auto object = Napi::Object::New(env);
+  object.Set("type", Napi::String::New(env, Function::mapExternalTypeToJavaScriptType(element.type)));
+  object.Set("length", Napi::String::New(env, std::to_string(element.nucLength)));
+  object.Set("sapType", Napi::String::New(env, AsChar16(RfcGetTypeAsString(element.type))));
+  if (HasDecimals(element.type)) {
+    object.Set("decimals", Napi::String::New(env, std::to_string(element.decimals)));
+  }
+  if (element.isParameter) {
+    object.Set("description", Napi::String::New(env, element.description));
+    object.Set("sapDirection", Napi::String::New(env, AsChar16(RfcGetDirectionAsString(element.direction))));
+    object.Set("optional", Napi::Boolean::New(env, element.optional));
+  }
+
+  if (element.type == RFCTYPE_STRUCTURE) {
+    auto type = TypeToObject(env, *element.rowType, freeze);
+    object.Set("sapTypeName", type.Get("sapTypeName"));
+    object.Set("properties", type.Get("properties"));
+  } else if (element.type == RFCTYPE_TABLE) {
+    object.Set("items", TypeToObject(env, *element.rowType, freeze));
+  }
+
+  if (!freeze.IsEmpty()) {
+    freeze.Call({object});
+  }
+  return scope.Escape(object).As<Napi::Object>();
+}
+
+Napi::Object FunctionSchema::TypeToObject(Napi::Env env, const TypeSchema &type, Napi::Function freeze) {
+  Napi::EscapableHandleScope scope{env};
+
+  auto object = Napi::Object::New(env);
+  object.Set("sapTypeName", Napi::String::New(env, type.name));
+  object.Set("type", Napi::String::New(env, "object"));
+  auto properties = Napi::Object::New(env);
+  for (const auto &field : type.fields) {
+    properties.Set(Napi::String::New(env, field.name), ElementToObject(env, field, freeze));
+  }
+  object.Set("properties", properties);
+
+  if (!freeze.IsEmpty()) {
+    freeze.Call({properties});
+    freeze.Call({object});
+  }
+  return scope.Escape(object).As<Napi::Object>();
+}
+
+SchemaCache::Entry *SchemaCache::Find(RFC_FUNCTION_DESC_HANDLE functionDescHandle) {
+  auto it = entries.find(functionDescHandle);
+  return it != entries.end() ? &it->second : nullptr;
+}
+
+SchemaCache::Entry *SchemaCache::Insert(RFC_FUNCTION_DESC_HANDLE functionDescHandle,
+                                        std::shared_ptr<const FunctionSchema> schema, uint64_t generation) {
+  if (generation != this->generation) {
+    return nullptr;
+  }
+  auto &entry = entries[functionDescHandle];
+  entry.schema = std::move(schema);
+  entry.frozen.Reset();
+  return &entry;
+}
+
+void SchemaCache::Invalidate() {
+  entries.clear();
+  generation++;
+}
+
+uint64_t SchemaCache::Generation() const {
+  return generation;
+}
+
+Napi::Value SchemaCache::Format(Napi::Env env, Entry &entry, const std::string &format) {
+  Napi::EscapableHandleScope scope{env};
+
+  if (format == "json") {
+    return scope.Escape(Napi::Buffer<char>::Copy(env, entry.schema->json.data(), entry.schema->json.size()));
+  }
+  if (format == "frozen") {
+    // The frozen objects are shared by all callers
+    if (entry.frozen.IsEmpty()) {
+      entry.frozen = Napi::Persistent(entry.schema->ToObject(env, true));
+    }
+    return scope.Escape(entry.frozen.Value());
+  }
+  return scope.Escape(entry.schema->ToObject(env, false));
+}
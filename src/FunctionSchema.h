@@ -0,0 +1,126 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#ifndef SAPNWRFC_FUNCTIONSCHEMA_H
+#define SAPNWRFC_FUNCTIONSCHEMA_H
+
+#include <napi.h>
+#include <sapnwrfc.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct TypeSchema;
+
+/*
+ * Parameter of a function or field of a structure, as described by the SDK.
+ */
+struct ElementSchema {
+  std::u16string name;
+  RFCTYPE type{};
+  unsigned nucLength{};
+  unsigned ucLength{};
+  unsigned decimals{};
+
+  // Parameters only
+  bool isParameter{};
+  RFC_DIRECTION direction{};
+  bool optional{};
+  std::u16string description;
+
+  // Line type of structures and tables
+  std::shared_ptr<const TypeSchema> rowType;
+};
+
+struct TypeSchema {
+  std::u16string name;
+  std::vector<ElementSchema> fields;
+  std::unordered_map<std::u16string, size_t> index;
+};
+
+/*
+ * Signature of a function module, read from its descriptor without creating a function container. Building it
+ * only reads descriptors, so it may run on an executor thread. The JSON Schema returned by Function.MetaData()
+ * is derived from it, either as objects or as the JSON text serialized along with the tree.
+ */
+class FunctionSchema {
+  public:
+    /*
+     * @return nullptr if the descriptor could not be read, errorInfo then holds the error
+     */
+    static std::shared_ptr<const FunctionSchema> Build(RFC_FUNCTION_DESC_HANDLE functionDescHandle,
+                                                       RFC_ERROR_INFO &errorInfo);
+
+    /*
+     * Creates the objects returned by MetaData(), frozen if requested.
+     */
+    Napi::Object ToObject(Napi::Env env, bool freeze) const;
+
+    std::u16string functionName;
+    std::vector<ElementSchema> parameters;
+    std::unordered_map<std::u16string, size_t> index;
+    std::string json;
+
+  protected:
+    static std::shared_ptr<const TypeSchema> BuildType(RFC_TYPE_DESC_HANDLE typeHandle, RFC_ERROR_INFO &errorInfo,
+        std::unordered_map<std::u16string, std::shared_ptr<const TypeSchema> > &types);
+    static Napi::Object ElementToObject(Napi::Env env, const ElementSchema &element, Napi::Function freeze);
+    static Napi::Object TypeToObject(Napi::Env env, const TypeSchema &type, Napi::Function freeze);
+    static void ElementToJson(const ElementSchema &element, std::string &json);
+    static void TypeToJson(const TypeSchema &type, std::string &json);
+    static bool HasDecimals(RFCTYPE type);
+};
+
+/*
+ * Schemas by function descriptor, one cache per environment (see AddonData). Descriptors are owned by the SDK's
+ * cache and may be replaced when metadata is refreshed, so every refresh clears the whole cache. Schemas built
+ * concurrently with a refresh are not inserted, see Generation().
+ */
+class SchemaCache {
+  public:
+    struct Entry {
+      std::shared_ptr<const FunctionSchema> schema;
+      Napi::ObjectReference frozen;
+    };
+
+    Entry *Find(RFC_FUNCTION_DESC_HANDLE functionDescHandle);
+    Entry *Insert(RFC_FUNCTION_DESC_HANDLE functionDescHandle, std::shared_ptr<const FunctionSchema> schema,
+                  uint64_t generation);
+    void Invalidate();
+    uint64_t Generation() const;
+
+    /*
+     * Returns the result of MetaData() in the requested format: "object", "frozen" or "json".
+     */
+    static Napi::Value Format(Napi::Env env, Entry &entry, const std::string &format);
+
+  private:
+    std::unordered_map<RFC_FUNCTION_DESC_HANDLE, Entry> entries;
+    uint64_t generation{};
+};
+
+#endif //SAPNWRFC_FUNCTIONSCHEMA_H
@@ -0,0 +1,474 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "LazyResult.h"
+#include "AddonData.h"
+#include <cassert>
+#include <cstring>
+
+LazyResult::LazyResult(const Napi::CallbackInfo &info)
+    : Napi::ObjectWrap<LazyResult>(info) {
+  init(Value());
+  log(info.Env(), Levels::SILLY, "LazyResult::LazyResult");
+}
+
+LazyResult::~LazyResult() {
+  deferLog(Levels::SILLY, "LazyResult::~LazyResult");
+  DestroyFunctionHandle();
+}
+
+Napi::Object LazyResult::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "LazyResult", {
+      InstanceMethod("Parameters", &LazyResult::Parameters),
+      InstanceMethod("Get", &LazyResult::Get),
+      InstanceMethod("RowCount", &LazyResult::RowCount),
+      InstanceMethod("Row", &LazyResult::Row),
+      InstanceMethod("Columnar", &LazyResult::Columnar),
+      InstanceMethod("Dispose", &LazyResult::Dispose)
+  });
+
+  AddonData::Get(env).lazyResultCtor = Napi::Persistent(func);
+  exports.Set("LazyResult", func);
+  return exports;
+}
+
+Napi::Value LazyResult::NewInstance(Napi::Env env, Function &function, RFC_FUNCTION_HANDLE functionHandle) {
+  Napi::EscapableHandleScope scope{env};
+
+  auto obj = AddonData::Get(env).lazyResultCtor.New({});
+  LazyResult *self = Napi::ObjectWrap<LazyResult>::Unwrap(obj);
+  assert(self != nullptr);
+
+  // The function descriptor and the converters must stay alive as long as the container
+  self->function = &function;
+  self->functionRef = Napi::Persistent(function.Value());
+  self->functionHandle = functionHandle;
+
+  self->log(env, Levels::SILLY, "LazyResult::NewInstance");
+  return scope.Escape(obj);
+}
+
+/**
+ * @return Object mapping parameter names to their SAP type
+ */
+Napi::Value LazyResult::Parameters(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+
+  CheckNotDisposed(env);
+
+  unsigned int parmCount{};
+  CALL_API_THROW("LazyResult::Parameters: RfcGetParameterCount unsuccessful",
+                 RfcGetParameterCount, function->functionDescHandle, &parmCount);
+
+  auto result = Napi::Object::New(env);
+  for (unsigned int i = 0; i < parmCount; i++) {
+    RFC_PARAMETER_DESC parmDesc{};
+    CALL_API_THROW("LazyResult::Parameters: RfcGetParameterDescByIndex unsuccessful",
+                   RfcGetParameterDescByIndex, function->functionDescHandle, i, &parmDesc);
+    result.Set(Napi::String::New(env, (const char16_t *) (parmDesc.name)),
+               Napi::String::New(env, (const char16_t *) RfcGetTypeAsString(parmDesc.type)));
+  }
+
+  return scope.Escape(result);
+}
+
+/**
+ * @return decoded value of a single parameter
+ */
+Napi::Value LazyResult::Get(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+
+  if (info.Length() != 1) {
+    throw Napi::Error::New(env, "Function expects 1 argument");
+  }
+
+  CheckNotDisposed(env);
+  auto parmDesc = GetParameterDesc(env, info[0]);
+
+  auto value = function->GetValue(env, functionHandle, parmDesc.type, parmDesc.name, parmDesc.nucLength);
+  if (IsException(env, value)) {
+    throw Napi::Error(env, value);
+  }
+
+  return scope.Escape(value);
+}
+
+Napi::Value LazyResult::RowCount(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+
+  if (info.Length() != 1) {
+    throw Napi::Error::New(env, "Function expects 1 argument");
+  }
+
+  CheckNotDisposed(env);
+  auto tableHandle = GetTable(env, info[0]);
+
+  unsigned rowCount{};
+  CALL_API_THROW(nullptr, RfcGetRowCount, tableHandle, &rowCount);
+
+  return scope.Escape(Napi::Number::New(env, rowCount));
+}
+
+/**
+ * @return decoded row of a table parameter
+ */
+Napi::Value LazyResult::Row(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+
+  if (info.Length() != 2) {
+    throw Napi::Error::New(env, "Function expects 2 arguments");
+  }
+  if (!info[1].IsNumber()) {
+    throw Napi::TypeError::New(env, "Argument 2 must be a row index");
+  }
+
+  CheckNotDisposed(env);
+  auto tableHandle = GetTable(env, info[0]);
+
+  unsigned rowCount{};
+  CALL_API_THROW(nullptr, RfcGetRowCount, tableHandle, &rowCount);
+
+  auto index = info[1].ToNumber().Int64Value();
+  if (index < 0 || index >= rowCount) {
+    throw Napi::RangeError::New(env, "Row index out of range");
+  }
+
+  CALL_API_THROW(nullptr, RfcMoveTo, tableHandle, static_cast<unsigned>(index));
+  auto structHandle = RfcGetCurrentRow(tableHandle, &errorInfo);
+  LOG_API(env, this, "RfcGetCurrentRow");
+
+  auto row = function->StructureToInternal(env, structHandle);
+  if (IsException(env, row)) {
+    throw Napi::Error(env, row);
+  }
+
+  return scope.Escape(row);
+}
+
+static size_t align8(size_t size) {
+  return (size + 7) & ~static_cast<size_t>(7);
+}
+
+/**
+ * Columnar(name, allocate): allocate(byteLength) must return a Uint8Array of at least byteLength
+ * bytes starting at the beginning of its buffer, into which the table is written.
+ *
+ * @return layout of the written table: {rows, byteLength, heapOffset, heapLength, columns}
+ */
+Napi::Value LazyResult::Columnar(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+
+  if (info.Length() != 2) {
+    throw Napi::Error::New(env, "Function expects 2 arguments");
+  }
+  if (!info[1].IsFunction()) {
+    throw Napi::TypeError::New(env, "Argument 2 must be a function");
+  }
+
+  CheckNotDisposed(env);
+  auto parmDesc = GetParameterDesc(env, info[0]);
+  auto tableHandle = GetTable(env, info[0]);
+
+  unsigned rowCount{};
+  CALL_API_THROW(nullptr, RfcGetRowCount, tableHandle, &rowCount);
+
+  // Every column area starts at a multiple of 8, so that typed arrays can be laid over it
+  auto columns = DescribeColumns(env, parmDesc.typeDescHandle);
+  size_t byteLength{};
+  for (auto &column : columns) {
+    column.offset = byteLength;
+    byteLength = align8(byteLength + column.width * rowCount);
+  }
+  auto heapOffset = byteLength;
+  auto heapLength = MeasureHeap(env, tableHandle, rowCount, columns);
+  byteLength += heapLength;
+
+  auto allocated = info[1].As<Napi::Function>().Call({Napi::Number::New(env, byteLength)});
+  if (!allocated.IsTypedArray() || allocated.As<Napi::TypedArray>().TypedArrayType() != napi_uint8_array) {
+    throw Napi::TypeError::New(env, "allocate must return a Uint8Array");
+  }
+  auto array = allocated.As<Napi::Uint8Array>();
+  if (array.ByteOffset() != 0 || array.ByteLength() < byteLength) {
+    throw Napi::RangeError::New(env, "allocate must return a Uint8Array of at least " +
+                                     std::to_string(byteLength) + " bytes at offset 0");
+  }
+
+  auto data = array.Data();
+  size_t heapUsed{};
+  for (unsigned i = 0; i < rowCount; i++) {
+    CALL_API_THROW(nullptr, RfcMoveTo, tableHandle, i);
+    auto row = RfcGetCurrentRow(tableHandle, &errorInfo);
+    LOG_API(env, this, "RfcGetCurrentRow");
+    for (auto &column : columns) {
+      WriteCell(env, row, column, data + column.offset + column.width * i, data + heapOffset, heapUsed);
+    }
+  }
+
+  auto layout = Napi::Object::New(env);
+  layout.Set("rows", Napi::Number::New(env, rowCount));
+  layout.Set("byteLength", Napi::Number::New(env, byteLength));
+  layout.Set("heapOffset", Napi::Number::New(env, heapOffset));
+  layout.Set("heapLength", Napi::Number::New(env, heapLength));
+  auto columnInfo = Napi::Array::New(env, columns.size());
+  for (uint32_t i = 0; i < columns.size(); i++) {
+    auto &column = columns[i];
+    auto entry = Napi::Object::New(env);
+    entry.Set("name", Napi::String::New(env, (const char16_t *) (column.field.name)));
+    entry.Set("type", Napi::String::New(env, (const char16_t *) RfcGetTypeAsString(column.field.type)));
+    entry.Set("kind", Napi::String::New(env, column.kind));
+    entry.Set("offset", Napi::Number::New(env, column.offset));
+    entry.Set("width", Napi::Number::New(env, column.width));
+    columnInfo.Set(i, entry);
+  }
+  layout.Set("columns", columnInfo);
+
+  return scope.Escape(layout);
+}
+
+std::vector<LazyResult::Column> LazyResult::DescribeColumns(Napi::Env env, RFC_TYPE_DESC_HANDLE typeHandle) {
+  unsigned fieldCount{};
+  CALL_API_THROW(nullptr, RfcGetFieldCount, typeHandle, &fieldCount);
+
+  std::vector<Column> columns;
+  for (unsigned i = 0; i < fieldCount; i++) {
+    Column column{};
+    CALL_API_THROW(nullptr, RfcGetFieldDescByIndex, typeHandle, i, &column.field);
+
+    // nucLength is the number of characters of character-like fields and the number of bytes of the others
+    auto length = column.field.nucLength;
+    switch (column.field.type) {
+      case RFCTYPE_INT:
+        column.kind = "int32";
+        column.width = sizeof(RFC_INT);
+        break;
+      case RFCTYPE_INT1:
+        column.kind = "uint8";
+        column.width = sizeof(RFC_INT1);
+        break;
+      case RFCTYPE_INT2:
+        column.kind = "int16";
+        column.width = sizeof(RFC_INT2);
+        break;
+      case RFCTYPE_FLOAT:
+        column.kind = "float64";
+        column.width = sizeof(RFC_FLOAT);
+        break;
+      case RFCTYPE_CHAR:
+      case RFCTYPE_NUM:
+      case RFCTYPE_DATE:
+      case RFCTYPE_TIME:
+        column.kind = "char";
+        column.width = length * sizeof(RFC_CHAR);
+        break;
+      case RFCTYPE_BCD:
+        // Digits, sign and decimal point, padded with NUL
+        column.kind = "char";
+        column.width = (2 * length + 2) * sizeof(RFC_CHAR);
+        break;
+      case RFCTYPE_BYTE:
+        column.kind = "bytes";
+        column.width = length;
+        break;
+      case RFCTYPE_STRING:
+        column.kind = "string";
+        column.width = 2 * sizeof(uint32_t);
+        break;
+      case RFCTYPE_XSTRING:
+        column.kind = "xstring";
+        column.width = 2 * sizeof(uint32_t);
+        break;
+      default:
+        throw Napi::TypeError::New(env, "Field " + convertToString(env, column.field.name) + " of type " +
+                                        convertToString(env, RfcGetTypeAsString(column.field.type)) +
+                                        " cannot be stored in columns");
+    }
+    columns.push_back(column);
+  }
+  return columns;
+}
+
+size_t LazyResult::MeasureHeap(Napi::Env env, RFC_TABLE_HANDLE tableHandle, unsigned rowCount,
+                               const std::vector<Column> &columns) {
+  size_t heapLength{};
+  for (auto &column : columns) {
+    if (column.field.type != RFCTYPE_STRING && column.field.type != RFCTYPE_XSTRING) {
+      continue;
+    }
+    for (unsigned i = 0; i < rowCount; i++) {
+      CALL_API_THROW(nullptr, RfcMoveTo, tableHandle, i);
+      auto row = RfcGetCurrentRow(tableHandle, &errorInfo);
+      LOG_API(env, this, "RfcGetCurrentRow");
+
+      unsigned length{};
+      CALL_API_THROW(nullptr, RfcGetStringLength, row, column.field.name, &length);
+      // Strings start at even offsets
+      heapLength += column.field.type == RFCTYPE_STRING ? length * sizeof(RFC_CHAR) : (length + 1) & ~1u;
+    }
+  }
+  return heapLength;
+}
+
+void LazyResult::WriteCell(Napi::Env env, RFC_STRUCTURE_HANDLE row, const Column &column, uint8_t *cell,
+                           uint8_t *heap, size_t &heapUsed) {
+  auto name = column.field.name;
+  auto length = column.field.nucLength;
+
+  switch (column.field.type) {
+    case RFCTYPE_INT: {
+      RFC_INT value{};
+      CALL_API_THROW(nullptr, RfcGetInt, row, name, &value);
+      memcpy(cell, &value, sizeof(value));
+      break;
+    }
+    case RFCTYPE_INT1: {
+      RFC_INT1 value{};
+      CALL_API_THROW(nullptr, RfcGetInt1, row, name, &value);
+      memcpy(cell, &value, sizeof(value));
+      break;
+    }
+    case RFCTYPE_INT2: {
+      RFC_INT2 value{};
+      CALL_API_THROW(nullptr, RfcGetInt2, row, name, &value);
+      memcpy(cell, &value, sizeof(value));
+      break;
+    }
+    case RFCTYPE_FLOAT: {
+      RFC_FLOAT value{};
+      CALL_API_THROW(nullptr, RfcGetFloat, row, name, &value);
+      memcpy(cell, &value, sizeof(value));
+      break;
+    }
+    case RFCTYPE_CHAR:
+      CALL_API_THROW(nullptr, RfcGetChars, row, name, reinterpret_cast<RFC_CHAR *>(cell), length);
+      break;
+    case RFCTYPE_NUM:
+      CALL_API_THROW(nullptr, RfcGetNum, row, name, reinterpret_cast<RFC_NUM *>(cell), length);
+      break;
+    case RFCTYPE_DATE:
+      CALL_API_THROW(nullptr, RfcGetDate, row, name, reinterpret_cast<RFC_CHAR *>(cell));
+      break;
+    case RFCTYPE_TIME:
+      CALL_API_THROW(nullptr, RfcGetTime, row, name, reinterpret_cast<RFC_CHAR *>(cell));
+      break;
+    case RFCTYPE_BYTE:
+      CALL_API_THROW(nullptr, RfcGetBytes, row, name, reinterpret_cast<RFC_BYTE *>(cell), length);
+      break;
+    case RFCTYPE_BCD: {
+      auto units = column.width / sizeof(RFC_CHAR);
+      std::vector<SAP_UC> buffer(units + 1);
+      unsigned written{};
+      CALL_API_THROW(nullptr, RfcGetString, row, name, buffer.data(), static_cast<unsigned>(units + 1), &written);
+      memcpy(cell, buffer.data(), written * sizeof(SAP_UC));
+      break;
+    }
+    case RFCTYPE_STRING:
+    case RFCTYPE_XSTRING: {
+      unsigned stringLength{};
+      CALL_API_THROW(nullptr, RfcGetStringLength, row, name, &stringLength);
+      uint32_t reference[2] = {static_cast<uint32_t>(heapUsed), 0};
+      if (column.field.type == RFCTYPE_STRING) {
+        std::vector<SAP_UC> buffer(stringLength + 1);
+        unsigned written{};
+        CALL_API_THROW(nullptr, RfcGetString, row, name, buffer.data(), stringLength + 1, &written);
+        reference[1] = static_cast<uint32_t>(written * sizeof(SAP_UC));
+        memcpy(heap + heapUsed, buffer.data(), reference[1]);
+        heapUsed += reference[1];
+      } else {
+        unsigned written{};
+        CALL_API_THROW(nullptr, RfcGetXString, row, name, reinterpret_cast<SAP_RAW *>(heap + heapUsed), stringLength,
+                       &written);
+        reference[1] = written;
+        heapUsed += (written + 1) & ~1u;
+      }
+      memcpy(cell, reference, sizeof(reference));
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+Napi::Value LazyResult::Dispose(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+
+  log(env, Levels::SILLY, "LazyResult::Dispose");
+  DestroyFunctionHandle();
+  logDeferred(env);
+
+  return scope.Escape(Napi::Boolean::New(env, true));
+}
+
+void LazyResult::CheckNotDisposed(Napi::Env env) {
+  if (functionHandle == nullptr) {
+    throw Napi::Error::New(env, "Result has already been disposed");
+  }
+}
+
+RFC_PARAMETER_DESC LazyResult::GetParameterDesc(Napi::Env env, Napi::Value name) {
+  if (!name.IsString()) {
+    throw Napi::TypeError::New(env, "Argument 1 must be a parameter name");
+  }
+
+  auto parmName = name.ToString().Utf16Value();
+  RFC_PARAMETER_DESC parmDesc{};
+  CALL_API_THROW("LazyResult::GetParameterDesc: RfcGetParameterDescByName unsuccessful",
+                 RfcGetParameterDescByName, function->functionDescHandle, (const SAP_UC *) parmName.c_str(),
+                 &parmDesc);
+  return parmDesc;
+}
+
+RFC_TABLE_HANDLE LazyResult::GetTable(Napi::Env env, Napi::Value name) {
+  auto parmDesc = GetParameterDesc(env, name);
+  if (parmDesc.type != RFCTYPE_TABLE) {
+    throw Napi::TypeError::New(env, "Not a table parameter: " + convertToString(env, parmDesc.name));
+  }
+
+  RFC_TABLE_HANDLE tableHandle{};
+  CALL_API_THROW(nullptr, RfcGetTable, functionHandle, parmDesc.name, &tableHandle);
+  return tableHandle;
+}
+
+void LazyResult::DestroyFunctionHandle() {
+  if (functionHandle != nullptr) {
+    RfcDestroyFunction(functionHandle, &errorInfo);
+    DEFER_LOG_API(this, "RfcDestroyFunction");
+    functionHandle = nullptr;
+  }
+  functionRef.Reset();
+}
+
+void LazyResult::addObjectInfoToLogMeta(Napi::Object meta) {
+  if (function) {
+    function->addObjectInfoToLogMeta(meta);
+  }
+  char ptr[2 + sizeof(void *) * 2 + 1];
+  snprintf(ptr, 2 + sizeof(void *) * 2 + 1, "%p", this);
+  meta.Set("nativeLazyResult", ptr);
+}
@@ -0,0 +1,87 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef SAPNWRFC_LAZYRESULT_H
+#define SAPNWRFC_LAZYRESULT_H
+
+#include "Utils.h"
+#include "Loggable.h"
+#include <sapnwrfc.h>
+#include "Function.h"
+#include <vector>
+
+/*
+ * Owns the function container of a finished invocation and decodes parameters and table rows
+ * only when they are requested. The container is destroyed on Dispose() or when the object is collected.
+ *
+ * Columnar() writes a whole table into a caller provided buffer, usually backed by a SharedArrayBuffer:
+ * one area per column with fixed-width values, followed by a heap for STRING and XSTRING values which
+ * are referenced by (byte offset, byte length) pairs. Characters are stored as UTF-16 code units.
+ * See columnar.js for the accessor.
+ */
+class LazyResult : public Loggable, public Napi::ObjectWrap<LazyResult> {
+  public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    static Napi::Value NewInstance(Napi::Env env, Function &function, RFC_FUNCTION_HANDLE functionHandle);
+
+    explicit LazyResult(const Napi::CallbackInfo &info);
+    ~LazyResult();
+
+    RFC_ERROR_INFO errorInfo{};
+
+  protected:
+    Napi::Value Parameters(const Napi::CallbackInfo &info);
+    Napi::Value Get(const Napi::CallbackInfo &info);
+    Napi::Value RowCount(const Napi::CallbackInfo &info);
+    Napi::Value Row(const Napi::CallbackInfo &info);
+    Napi::Value Columnar(const Napi::CallbackInfo &info);
+    Napi::Value Dispose(const Napi::CallbackInfo &info);
+
+    void CheckNotDisposed(Napi::Env env);
+    RFC_PARAMETER_DESC GetParameterDesc(Napi::Env env, Napi::Value name);
+    RFC_TABLE_HANDLE GetTable(Napi::Env env, Napi::Value name);
+    void DestroyFunctionHandle();
+
+    struct Column {
+      RFC_FIELD_DESC field;
+      const char *kind;
+      size_t width; // bytes per row
+      size_t offset;
+    };
+
+    std::vector<Column> DescribeColumns(Napi::Env env, RFC_TYPE_DESC_HANDLE typeHandle);
+    size_t MeasureHeap(Napi::Env env, RFC_TABLE_HANDLE tableHandle, unsigned rowCount,
+                       const std::vector<Column> &columns);
+    void WriteCell(Napi::Env env, RFC_STRUCTURE_HANDLE row, const Column &column, uint8_t *cell, uint8_t *heap,
+                   size_t &heapUsed);
+
+    void addObjectInfoToLogMeta(Napi::Object meta) override;
+
+
+    Function *function{};
+    Napi::ObjectReference functionRef;
+    RFC_FUNCTION_HANDLE functionHandle{};
+};
+
+#endif //SAPNWRFC_LAZYRESULT_H
@@ -122,6 +122,7 @@ void Loggable::deferLog(const std::string &level, const std::string &message, co
   entry.level = level;
   entry.message = message;
   entry.meta = meta;
+  std::lock_guard<std::mutex> lock{deferredLogsMutex};
   deferredLogs.push_back(entry);
 }
 
@@ -161,14 +162,19 @@ void Loggable::deferLogAPICall(const std::string &call, const std::string &file,
                                unsigned long line, RFC_ERROR_INFO &errorInfo, const Loggable::LogEntry::Meta &meta) {
   LogEntry logEntry;
   createAPILogEntry_(logEntry, call, file, function, line, errorInfo, meta);
+  std::lock_guard<std::mutex> lock{deferredLogsMutex};
   deferredLogs.push_back(logEntry);
 }
 
 void Loggable::logDeferred(Napi::Env env) {
-  for (const auto &entry : deferredLogs) {
+  LogEntries entries;
+  {
+    std::lock_guard<std::mutex> lock{deferredLogsMutex};
+    entries.swap(deferredLogs);
+  }
+  for (const auto &entry : entries) {
     log(env, entry);
   }
-  deferredLogs.clear();
 }
 
 void Loggable::resetLogFunction() {
@@ -29,6 +29,7 @@ SOFTWARE.
 #include <napi.h>
 #include <string>
 #include <vector>
+#include <mutex>
 #include <utility>
 #include "current_function.hpp"
 
@@ -98,6 +99,8 @@ class Loggable {
 
     typedef std::vector<LogEntry> LogEntries;
     LogEntries deferredLogs;
+    // Deferred logs are written by worker threads
+    std::mutex deferredLogsMutex;
 
     void createAPILogEntry_(Loggable::LogEntry &logEntry, const std::string &call,
                             const std::string &file, const std::string &function,
@@ -0,0 +1,281 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#include "PoolFanOut.h"
+#include "ConnectionLookup.h"
+#include "FunctionInvoke.h"
+#include "Utils.h"
+#include <algorithm>
+
+PoolFanOut::PoolFanOut(Napi::Env env, ConnectionPool *pool, const std::u16string &functionName, Napi::Object params,
+                       const std::string &table, uint32_t chunkSize, uint32_t parallel, Napi::Object options,
+                       Napi::Function callback)
+    : env{env}, pool{pool}, functionName{functionName}, table{table}, chunkSize{chunkSize}, parallel{parallel} {
+  auto tableRows = params.Get(table).As<Napi::Array>();
+  this->rows = Napi::Persistent(tableRows);
+  this->params = Napi::Persistent(params);
+  this->callback = Napi::Persistent(callback);
+
+  auto progressOption = options.Get("progress");
+  if (progressOption.IsFunction()) {
+    progress = Napi::Persistent(progressOption.As<Napi::Function>());
+  }
+  auto timeoutOption = options.Get("timeout");
+  if (timeoutOption.IsNumber()) {
+    timeoutMillis = timeoutOption.ToNumber().Uint32Value();
+  }
+
+  auto invoke = Napi::Object::New(env);
+  invoke.Set("idempotent", options.Get("idempotent").ToBoolean());
+  invokeOptions = Napi::Persistent(invoke);
+
+  totalRows = tableRows.Length();
+  chunks = (totalRows + chunkSize - 1) / chunkSize;
+  results.resize(chunks);
+
+  // The pool must be alive until the last chunk has been released
+  pool->Reference::Ref();
+}
+
+PoolFanOut::~PoolFanOut() {
+  pool->Reference::Unref();
+}
+
+void PoolFanOut::Start() {
+  if (chunks == 0) {
+    Done();
+    return;
+  }
+  // Counted in advance, a chunk failing right away must not finish the fan-out
+  auto slots = std::min(parallel, chunks);
+  running = slots;
+  for (uint32_t i = 0; i < slots; i++) {
+    Acquire();
+  }
+}
+
+/*
+ * Leases a connection for the next chunk, like ConnectionPool::Acquire(). The caller has counted it as running.
+ */
+void PoolFanOut::Acquire() {
+  auto chunk = nextChunk++;
+
+  auto done = Napi::Function::New(env, [this, chunk](const Napi::CallbackInfo &info) {
+    OnAcquired(chunk, info.Length() > 0 ? info[0] : info.Env().Undefined(),
+               info.Length() > 1 ? info[1] : info.Env().Undefined());
+  });
+  if (!pool->isOpen) {
+    OnAcquired(chunk, pool->ClosedError(env), env.Undefined());
+    return;
+  }
+  pool->waiting.emplace_back(Napi::Persistent(done));
+  pool->Dispatch(env);
+}
+
+void PoolFanOut::OnAcquired(uint32_t chunk, Napi::Value error, Napi::Value connectionValue) {
+  Napi::HandleScope scope{env};
+
+  if (!error.IsUndefined() && !error.IsNull()) {
+    Fail(chunk, error);
+    return;
+  }
+
+  auto connection = Napi::ObjectWrap<Connection>::Unwrap(connectionValue.ToObject());
+  if (!this->error.IsEmpty()) {
+    // Another chunk failed meanwhile
+    pool->ReleaseConnection(env, connection, false);
+    running--;
+    Done();
+    return;
+  }
+
+  auto it = functions.find(connection);
+  if (it != functions.end()) {
+    Invoke(chunk, connection, Napi::ObjectWrap<Function>::Unwrap(it->second.Value()));
+    return;
+  }
+
+  auto done = Napi::Function::New(env, [this, chunk, connection](const Napi::CallbackInfo &info) {
+    auto error = info.Length() > 0 ? info[0] : info.Env().Undefined();
+    if (!error.IsUndefined() && !error.IsNull()) {
+      pool->ReleaseConnection(env, connection, false);
+      Fail(chunk, error);
+      return;
+    }
+    auto function = info[1].ToObject();
+    functions[connection] = Napi::Persistent(function);
+    Invoke(chunk, connection, Napi::ObjectWrap<Function>::Unwrap(function));
+  });
+  (new ConnectionLookup{env, done, connection, functionName, false})->Queue();
+}
+
+void PoolFanOut::Invoke(uint32_t chunk, Connection *connection, Function *function) {
+  Napi::HandleScope scope{env};
+
+  // The other parameters are shared by all chunks
+  auto input = Napi::Object::New(env);
+  auto names = params.Value().GetPropertyNames();
+  for (uint32_t i = 0; i < names.Length(); i++) {
+    input.Set(names.Get(i), params.Value().Get(names.Get(i)));
+  }
+  auto all = rows.Value().As<Napi::Array>();
+  auto begin = chunk * chunkSize;
+  auto end = std::min(begin + chunkSize, totalRows);
+  auto part = Napi::Array::New(env, end - begin);
+  for (uint32_t i = begin; i < end; i++) {
+    part.Set(i - begin, all.Get(i));
+  }
+  input.Set(table, part);
+
+  RFC_FUNCTION_HANDLE functionHandle{};
+  auto prepared = function->PrepareInvocation(env, input, functionHandle);
+  if (IsException(env, prepared)) {
+    pool->ReleaseConnection(env, connection, false);
+    Fail(chunk, prepared);
+    return;
+  }
+
+  auto done = Napi::Function::New(env, [this, chunk, connection](const Napi::CallbackInfo &info) {
+    OnInvoked(chunk, connection, info.Length() > 0 ? info[0] : info.Env().Undefined(),
+              info.Length() > 1 ? info[1] : info.Env().Undefined());
+  });
+  auto worker = new FunctionInvoke{done, connection, function, functionHandle, invokeOptions.Value()};
+  if (timeoutMillis > 0) {
+    worker->SetTimeout(timeoutMillis);
+  }
+  worker->Queue();
+  // Released by the worker
+  function->Reference::Ref();
+}
+
+void PoolFanOut::OnInvoked(uint32_t chunk, Connection *connection, Napi::Value error, Napi::Value result) {
+  Napi::HandleScope scope{env};
+
+  bool failed = !error.IsUndefined() && !error.IsNull();
+  // A cancelled or timed out call has closed its connection
+  bool closed = failed && error.IsObject() && (error.ToObject().Get("key").ToString().Utf8Value() == "RFC_CANCELED" ||
+                                               error.ToObject().Get("key").ToString().Utf8Value() == "RFC_TIMEOUT");
+  if (closed) {
+    functions.erase(connection);
+  }
+  pool->ReleaseConnection(env, connection, closed);
+
+  if (failed) {
+    Fail(chunk, error);
+    return;
+  }
+
+  results[chunk] = Napi::Persistent(result.ToObject());
+  finished++;
+  finishedRows += std::min(chunkSize, totalRows - chunk * chunkSize);
+
+  if (!progress.IsEmpty()) {
+    auto event = Napi::Object::New(env);
+    event.Set("chunk", Napi::Number::New(env, chunk));
+    event.Set("chunks", Napi::Number::New(env, chunks));
+    event.Set("finished", Napi::Number::New(env, finished));
+    event.Set("rows", Napi::Number::New(env, finishedRows));
+    event.Set("totalRows", Napi::Number::New(env, totalRows));
+    progress.Call({event});
+  }
+
+  if (this->error.IsEmpty() && nextChunk < chunks) {
+    Acquire();
+  } else {
+    running--;
+    Done();
+  }
+}
+
+/*
+ * The first error ends the fan-out, chunks in flight still complete.
+ */
+void PoolFanOut::Fail(uint32_t chunk, Napi::Value error) {
+  if (this->error.IsEmpty()) {
+    auto errorObject = error.ToObject();
+    errorObject.Set("chunk", Napi::Number::New(env, chunk));
+    this->error = Napi::Persistent(errorObject);
+  }
+  running--;
+  Done();
+}
+
+void PoolFanOut::Done() {
+  if (running > 0 || (error.IsEmpty() && nextChunk < chunks)) {
+    return;
+  }
+
+  Napi::HandleScope scope{env};
+  auto err = error.IsEmpty() ? env.Undefined() : error.Value();
+  auto merged = Merge();
+
+  auto chunkResults = Napi::Array::New(env, chunks);
+  for (uint32_t i = 0; i < chunks; i++) {
+    chunkResults.Set(i, results[i].IsEmpty() ? env.Undefined() : results[i].Value());
+  }
+
+  auto cb = std::move(callback);
+  delete this;
+  cb.Call({err, merged, chunkResults});
+}
+
+/*
+ * Tables of all chunks are concatenated in chunk order, other parameters are those of the last chunk.
+ */
+Napi::Value PoolFanOut::Merge() {
+  Napi::EscapableHandleScope scope{env};
+
+  auto merged = Napi::Object::New(env);
+  for (auto &result : results) {
+    if (result.IsEmpty()) {
+      continue;
+    }
+    auto names = result.Value().GetPropertyNames();
+    for (uint32_t i = 0; i < names.Length(); i++) {
+      auto name = names.Get(i);
+      auto value = result.Value().Get(name);
+      auto previous = merged.Get(name);
+      if (value.IsArray() && previous.IsArray()) {
+        auto target = previous.As<Napi::Array>();
+        auto source = value.As<Napi::Array>();
+        auto length = target.Length();
+        for (uint32_t j = 0; j < source.Length(); j++) {
+          target.Set(length + j, source.Get(j));
+        }
+      } else if (value.IsArray()) {
+        // Copied, so that the result of a chunk is not modified
+        auto source = value.As<Napi::Array>();
+        auto target = Napi::Array::New(env, source.Length());
+        for (uint32_t j = 0; j < source.Length(); j++) {
+          target.Set(j, source.Get(j));
+        }
+        merged.Set(name, target);
+      } else {
+        merged.Set(name, value);
+      }
+    }
+  }
+  return scope.Escape(merged);
+}
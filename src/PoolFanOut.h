@@ -0,0 +1,88 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#ifndef SAPNWRFC_POOLFANOUT_H
+#define SAPNWRFC_POOLFANOUT_H
+
+#include <napi.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ConnectionPool.h"
+#include "Function.h"
+
+/*
+ * Calls a function module once per chunk of rows of one TABLES parameter, with at most parallel
+ * chunks in flight on connections leased from the pool. Chunks are marshalled on the main thread
+ * just before they are sent, so only the chunks in flight are held in SDK containers. Runs on the
+ * main thread only and deletes itself after the callback has been called.
+ */
+class PoolFanOut {
+  public:
+    PoolFanOut(Napi::Env env, ConnectionPool *pool, const std::u16string &functionName, Napi::Object params,
+               const std::string &table, uint32_t chunkSize, uint32_t parallel, Napi::Object options,
+               Napi::Function callback);
+    PoolFanOut(const PoolFanOut &) = delete;
+    PoolFanOut &operator=(const PoolFanOut &) = delete;
+    ~PoolFanOut();
+
+    void Start();
+
+  private:
+    void Acquire();
+    void OnAcquired(uint32_t chunk, Napi::Value error, Napi::Value connection);
+    void Invoke(uint32_t chunk, Connection *connection, Function *function);
+    void OnInvoked(uint32_t chunk, Connection *connection, Napi::Value error, Napi::Value result);
+    void Fail(uint32_t chunk, Napi::Value error);
+    void Done();
+    Napi::Value Merge();
+
+    Napi::Env env;
+    ConnectionPool *pool;
+    std::u16string functionName;
+    std::string table;
+    Napi::ObjectReference params;
+    Napi::ObjectReference rows;
+    Napi::ObjectReference invokeOptions;
+    Napi::FunctionReference progress;
+    Napi::FunctionReference callback;
+    uint32_t timeoutMillis{};
+
+    uint32_t chunkSize;
+    uint32_t parallel;
+    uint32_t totalRows;
+    uint32_t chunks;
+    uint32_t nextChunk{};
+    uint32_t running{};
+    uint32_t finished{};
+    uint32_t finishedRows{};
+
+    // One Function per connection, its descriptor comes from the SDK's repository cache
+    std::unordered_map<Connection *, Napi::ObjectReference> functions;
+    std::vector<Napi::ObjectReference> results;
+    Napi::ObjectReference error;
+};
+
+#endif //SAPNWRFC_POOLFANOUT_H
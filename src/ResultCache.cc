@@ -0,0 +1,265 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "ResultCache.h"
+#include "AddonData.h"
+#include "Utils.h"
+
+ResultCache::Entry::Entry(RFC_FUNCTION_HANDLE functionHandle, size_t size, Clock::time_point expires)
+    : functionHandle(functionHandle), size(size), expires(expires) {}
+
+ResultCache::Entry::~Entry() {
+  RFC_ERROR_INFO errorInfo{};
+  RfcDestroyFunction(functionHandle, &errorInfo);
+}
+
+Napi::Object ResultCache::Init(Napi::Env env, Napi::Object exports) {
+  auto cache = Napi::Object::New(env);
+  cache.Set("Configure", Napi::Function::New(env, &ResultCache::Configure, "Configure"));
+  cache.Set("Enable", Napi::Function::New(env, &ResultCache::Enable, "Enable"));
+  cache.Set("Disable", Napi::Function::New(env, &ResultCache::Disable, "Disable"));
+  cache.Set("Clear", Napi::Function::New(env, &ResultCache::Clear, "Clear"));
+  cache.Set("Stats", Napi::Function::New(env, &ResultCache::GetStats, "Stats"));
+
+  exports.Set("Cache", cache);
+  return exports;
+}
+
+ResultCache &ResultCache::Instance(Napi::Env env) {
+  return AddonData::Get(env).resultCache;
+}
+
+// Function module names are case-insensitive, the SDK looks them up in upper case
+static std::u16string upperCase(std::u16string name) {
+  for (auto &c : name) {
+    if (c >= u'a' && c <= u'z') {
+      c = static_cast<char16_t>(c - u'a' + u'A');
+    }
+  }
+  return name;
+}
+
+std::string ResultCache::KeyPrefix(const std::u16string &functionName) {
+  auto name = upperCase(functionName);
+  std::string prefix(reinterpret_cast<const char *>(name.data()), name.size() * sizeof(char16_t));
+  prefix.append(sizeof(char16_t), '\0');
+  return prefix;
+}
+
+std::string ResultCache::LogonKey(const RFC_ATTRIBUTES &attributes) {
+  std::string key;
+  for (const SAP_UC *attribute : {attributes.sysId, attributes.client, attributes.user, attributes.language}) {
+    auto length = static_cast<uint32_t>(std::char_traits<char16_t>::length(reinterpret_cast<const char16_t *>(attribute)));
+    key.append(reinterpret_cast<const char *>(&length), sizeof(length));
+    key.append(reinterpret_cast<const char *>(attribute), length * sizeof(char16_t));
+  }
+  return key;
+}
+
+bool ResultCache::IsEnabled(const std::u16string &functionName, std::chrono::milliseconds &ttl) const {
+  auto it = functions.find(upperCase(functionName));
+  if (it == functions.end() || maxBytes == 0) {
+    return false;
+  }
+  ttl = it->second.count() > 0 ? it->second : defaultTtl;
+  return true;
+}
+
+std::shared_ptr<ResultCache::Entry> ResultCache::Find(const std::string &key) {
+  auto it = index.find(key);
+  if (it == index.end()) {
+    stats.misses++;
+    return nullptr;
+  }
+
+  auto entry = it->second->second;
+  if (entry->expires <= Clock::now()) {
+    bytes -= entry->size;
+    entries.erase(it->second);
+    index.erase(it);
+    stats.expirations++;
+    stats.misses++;
+    return nullptr;
+  }
+
+  // Move to the front of the LRU list
+  entries.splice(entries.begin(), entries, it->second);
+  stats.hits++;
+  return entry;
+}
+
+std::shared_ptr<ResultCache::Entry> ResultCache::Insert(const std::string &key, RFC_FUNCTION_HANDLE functionHandle,
+                                                        size_t size, std::chrono::milliseconds ttl) {
+  auto entry = std::make_shared<Entry>(functionHandle, size, Clock::now() + ttl);
+  if (size > maxBytes) {
+    return entry;
+  }
+
+  auto it = index.find(key);
+  if (it != index.end()) {
+    bytes -= it->second->second->size;
+    entries.erase(it->second);
+    index.erase(it);
+  }
+
+  EvictUntil(maxBytes - size);
+
+  entries.emplace_front(key, entry);
+  index[key] = entries.begin();
+  bytes += size;
+  return entry;
+}
+
+void ResultCache::Remove(const std::u16string &functionName) {
+  auto prefix = KeyPrefix(functionName);
+  for (auto it = entries.begin(); it != entries.end();) {
+    if (it->first.compare(0, prefix.size(), prefix) == 0) {
+      bytes -= it->second->size;
+      index.erase(it->first);
+      it = entries.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void ResultCache::EvictUntil(size_t maxSize) {
+  while (bytes > maxSize && !entries.empty()) {
+    auto &last = entries.back();
+    bytes -= last.second->size;
+    index.erase(last.first);
+    entries.pop_back();
+    stats.evictions++;
+  }
+}
+
+/**
+ * Configure({ maxBytes, ttl })
+ */
+Napi::Value ResultCache::Configure(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+
+  if (info.Length() != 1 || !info[0].IsObject()) {
+    throw Napi::TypeError::New(env, "Argument 1 must be an object");
+  }
+
+  auto &cache = Instance(info.Env());
+  auto options = info[0].ToObject();
+  auto maxBytes = options.Get("maxBytes");
+  if (!maxBytes.IsUndefined()) {
+    if (!maxBytes.IsNumber() || maxBytes.ToNumber().Int64Value() < 0) {
+      throw Napi::TypeError::New(env, "Option maxBytes must be a positive number");
+    }
+    cache.maxBytes = static_cast<size_t>(maxBytes.ToNumber().Int64Value());
+    cache.EvictUntil(cache.maxBytes);
+  }
+  auto ttl = options.Get("ttl");
+  if (!ttl.IsUndefined()) {
+    if (!ttl.IsNumber() || ttl.ToNumber().Int64Value() <= 0) {
+      throw Napi::TypeError::New(env, "Option ttl must be a positive number");
+    }
+    cache.defaultTtl = std::chrono::milliseconds(ttl.ToNumber().Int64Value());
+  }
+
+  return scope.Escape(Napi::Boolean::New(env, true));
+}
+
+/**
+ * Enable(functionName[, { ttl }])
+ */
+Napi::Value ResultCache::Enable(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+
+  if (info.Length() < 1 || info.Length() > 2) {
+    throw Napi::Error::New(env, "Function expects 1 or 2 arguments");
+  }
+  if (!info[0].IsString()) {
+    throw Napi::TypeError::New(env, "Argument 1 must be function module name");
+  }
+  if (info.Length() > 1 && !info[1].IsObject()) {
+    throw Napi::TypeError::New(env, "Argument 2 must be an object");
+  }
+
+  // A ttl of 0 falls back to the configured default
+  std::chrono::milliseconds ttl{0};
+  if (info.Length() > 1) {
+    auto ttlValue = info[1].ToObject().Get("ttl");
+    if (!ttlValue.IsUndefined()) {
+      if (!ttlValue.IsNumber() || ttlValue.ToNumber().Int64Value() <= 0) {
+        throw Napi::TypeError::New(env, "Option ttl must be a positive number");
+      }
+      ttl = std::chrono::milliseconds(ttlValue.ToNumber().Int64Value());
+    }
+  }
+
+  Instance(env).functions[upperCase(info[0].ToString().Utf16Value())] = ttl;
+  return scope.Escape(Napi::Boolean::New(env, true));
+}
+
+/**
+ * Disable(functionName), also drops the cached results of the function
+ */
+Napi::Value ResultCache::Disable(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+
+  if (info.Length() != 1 || !info[0].IsString()) {
+    throw Napi::TypeError::New(env, "Argument 1 must be function module name");
+  }
+
+  auto functionName = info[0].ToString().Utf16Value();
+  auto &cache = Instance(info.Env());
+  cache.functions.erase(upperCase(functionName));
+  cache.Remove(functionName);
+  return scope.Escape(Napi::Boolean::New(env, true));
+}
+
+Napi::Value ResultCache::Clear(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+
+  auto &cache = Instance(info.Env());
+  cache.entries.clear();
+  cache.index.clear();
+  cache.bytes = 0;
+  return scope.Escape(Napi::Boolean::New(env, true));
+}
+
+Napi::Value ResultCache::GetStats(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+
+  auto &cache = Instance(info.Env());
+  auto stats = Napi::Object::New(env);
+  stats.Set("hits", Napi::Number::New(env, cache.stats.hits));
+  stats.Set("misses", Napi::Number::New(env, cache.stats.misses));
+  stats.Set("evictions", Napi::Number::New(env, cache.stats.evictions));
+  stats.Set("expirations", Napi::Number::New(env, cache.stats.expirations));
+  stats.Set("entries", Napi::Number::New(env, cache.entries.size()));
+  stats.Set("bytes", Napi::Number::New(env, cache.bytes));
+  stats.Set("maxBytes", Napi::Number::New(env, cache.maxBytes));
+  return scope.Escape(stats);
+}
@@ -0,0 +1,116 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef SAPNWRFC_RESULTCACHE_H
+#define SAPNWRFC_RESULTCACHE_H
+
+#include <napi.h>
+#include <sapnwrfc.h>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+/*
+ * Cache of function containers of read-only function modules, one per environment (see AddonData). Entries are
+ * keyed by the function name, the logon attributes of the connection and the serialized input parameters
+ * (see Function::BuildCallKey).
+ * A cache hit decodes the stored container again, so every caller gets its own result objects.
+ *
+ * Caching is opt-in per function module, the cache is bounded by the approximated size of the stored containers
+ * and evicts the least recently used entries first.
+ */
+class ResultCache {
+  public:
+    typedef std::chrono::steady_clock Clock;
+
+    class Entry {
+      public:
+        Entry(RFC_FUNCTION_HANDLE functionHandle, size_t size, Clock::time_point expires);
+        Entry(const Entry &) = delete;
+        Entry &operator=(const Entry &) = delete;
+        ~Entry();
+
+        RFC_FUNCTION_HANDLE functionHandle;
+        size_t size;
+        Clock::time_point expires;
+    };
+
+    struct Stats {
+      uint64_t hits{};
+      uint64_t misses{};
+      uint64_t evictions{};
+      uint64_t expirations{};
+    };
+
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    static ResultCache &Instance(Napi::Env env);
+
+    /*
+     * Every key starts with the upper case name of the function, so that entries of a function can be dropped.
+     */
+    static std::string KeyPrefix(const std::u16string &functionName);
+
+    /*
+     * Serializes the system, client, user and language of a connection, read once when it is opened.
+     */
+    static std::string LogonKey(const RFC_ATTRIBUTES &attributes);
+
+    /*
+     * Returns true if results of the function are cached and sets ttl to its time to live.
+     */
+    bool IsEnabled(const std::u16string &functionName, std::chrono::milliseconds &ttl) const;
+
+    std::shared_ptr<Entry> Find(const std::string &key);
+
+    /*
+     * Takes over the function handle. The returned entry stays valid even if it is evicted right away.
+     */
+    std::shared_ptr<Entry> Insert(const std::string &key, RFC_FUNCTION_HANDLE functionHandle, size_t size,
+                                  std::chrono::milliseconds ttl);
+
+  protected:
+    static Napi::Value Configure(const Napi::CallbackInfo &info);
+    static Napi::Value Enable(const Napi::CallbackInfo &info);
+    static Napi::Value Disable(const Napi::CallbackInfo &info);
+    static Napi::Value Clear(const Napi::CallbackInfo &info);
+    static Napi::Value GetStats(const Napi::CallbackInfo &info);
+
+    void Remove(const std::u16string &functionName);
+    void EvictUntil(size_t maxSize);
+
+    typedef std::list<std::pair<std::string, std::shared_ptr<Entry> > > EntryList;
+
+    size_t maxBytes{64 * 1024 * 1024};
+    std::chrono::milliseconds defaultTtl{60 * 1000};
+    std::unordered_map<std::u16string, std::chrono::milliseconds> functions; // by upper case name
+
+    EntryList entries; // most recently used first
+    std::unordered_map<std::string, EntryList::iterator> index;
+    size_t bytes{};
+    Stats stats;
+};
+
+#endif //SAPNWRFC_RESULTCACHE_H
@@ -0,0 +1,143 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "RfcExecutor.h"
+#include "RfcQueue.h"
+#include <thread>
+
+Napi::Object RfcExecutor::Init(Napi::Env env, Napi::Object exports) {
+  auto executor = Napi::Object::New(env);
+  executor.Set("Configure", Napi::Function::New(env, &RfcExecutor::Configure, "Configure"));
+  executor.Set("Stats", Napi::Function::New(env, &RfcExecutor::GetStats, "Stats"));
+
+  exports.Set("Executor", executor);
+  return exports;
+}
+
+RfcExecutor &RfcExecutor::Instance() {
+  // Never destroyed, its detached threads may still wait for work when the process exits
+  static auto instance = new RfcExecutor;
+  return *instance;
+}
+
+void RfcExecutor::Schedule(std::shared_ptr<RfcQueue> queue) {
+  std::lock_guard<std::mutex> lock{mutex};
+  queues.push_back(std::move(queue));
+  if (queues.size() > idleThreads && threads < maxThreads) {
+    StartThread();
+  } else {
+    available.notify_one();
+  }
+}
+
+void RfcExecutor::ScheduleAfter(std::shared_ptr<RfcQueue> queue, std::chrono::milliseconds delay) {
+  std::lock_guard<std::mutex> lock{mutex};
+  delayed.emplace(Clock::now() + delay, std::move(queue));
+  // Some thread has to wait for the delay
+  if (threads == 0) {
+    StartThread();
+  } else {
+    available.notify_one();
+  }
+}
+
+void RfcExecutor::StartThread() {
+  threads++;
+  std::thread{&RfcExecutor::Run, this}.detach();
+}
+
+void RfcExecutor::Run() {
+  std::unique_lock<std::mutex> lock{mutex};
+  while (true) {
+    // Delayed queues are due
+    auto now = Clock::now();
+    while (!delayed.empty() && delayed.begin()->first <= now) {
+      queues.push_back(std::move(delayed.begin()->second));
+      delayed.erase(delayed.begin());
+    }
+
+    if (queues.empty()) {
+      idleThreads++;
+      if (delayed.empty()) {
+        available.wait(lock);
+      } else {
+        available.wait_until(lock, delayed.begin()->first);
+      }
+      idleThreads--;
+      continue;
+    }
+
+    auto queue = std::move(queues.front());
+    queues.pop_front();
+    executed++;
+    lock.unlock();
+
+    // Runs a single worker, a queue with more work is scheduled again behind the others
+    queue->RunNext();
+    queue.reset();
+
+    lock.lock();
+  }
+}
+
+/**
+ * Configure({ threads })
+ */
+Napi::Value RfcExecutor::Configure(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+
+  if (info.Length() != 1 || !info[0].IsObject()) {
+    throw Napi::TypeError::New(env, "Argument 1 must be an object");
+  }
+
+  auto threads = info[0].ToObject().Get("threads");
+  if (!threads.IsUndefined()) {
+    if (!threads.IsNumber() || threads.ToNumber().Int64Value() < 1) {
+      throw Napi::TypeError::New(env, "Option threads must be a positive number");
+    }
+    // Already started threads are kept, a smaller value only limits further growth
+    auto &executor = Instance();
+    std::lock_guard<std::mutex> lock{executor.mutex};
+    executor.maxThreads = threads.ToNumber().Uint32Value();
+  }
+
+  return scope.Escape(Napi::Boolean::New(env, true));
+}
+
+Napi::Value RfcExecutor::GetStats(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+
+  auto &executor = Instance();
+  std::lock_guard<std::mutex> lock{executor.mutex};
+  auto stats = Napi::Object::New(env);
+  stats.Set("maxThreads", Napi::Number::New(env, executor.maxThreads));
+  stats.Set("threads", Napi::Number::New(env, executor.threads));
+  stats.Set("busy", Napi::Number::New(env, executor.threads - executor.idleThreads));
+  stats.Set("queued", Napi::Number::New(env, executor.queues.size()));
+  stats.Set("delayed", Napi::Number::New(env, executor.delayed.size()));
+  stats.Set("executed", Napi::Number::New(env, executor.executed));
+  return scope.Escape(stats);
+}
@@ -0,0 +1,84 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef SAPNWRFC_RFCEXECUTOR_H
+#define SAPNWRFC_RFCEXECUTOR_H
+
+#include <napi.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+
+class RfcQueue;
+
+/*
+ * Thread pool running all blocking SDK work, independent of the libuv threadpool and its
+ * UV_THREADPOOL_SIZE. Connections schedule their queues (see RfcQueue) here, a queue is served
+ * by at most one thread at a time so that the work of a connection stays in order.
+ *
+ * Threads are started on demand up to the configured number and never leave before the process.
+ */
+class RfcExecutor {
+  public:
+    static const uint32_t DEFAULT_THREADS = 8;
+
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    static RfcExecutor &Instance();
+
+    /*
+     * Appends a queue with pending work, called while the queue's mutex is held.
+     */
+    void Schedule(std::shared_ptr<RfcQueue> queue);
+
+    /*
+     * Schedules a queue after a delay, used to back off before a worker is retried.
+     */
+    void ScheduleAfter(std::shared_ptr<RfcQueue> queue, std::chrono::milliseconds delay);
+
+  private:
+    RfcExecutor() = default;
+
+    typedef std::chrono::steady_clock Clock;
+
+    void Run();
+    void StartThread();
+
+    static Napi::Value Configure(const Napi::CallbackInfo &info);
+    static Napi::Value GetStats(const Napi::CallbackInfo &info);
+
+    std::mutex mutex;
+    std::condition_variable available;
+    std::deque<std::shared_ptr<RfcQueue>> queues;
+    std::multimap<Clock::time_point, std::shared_ptr<RfcQueue>> delayed;
+    uint32_t maxThreads{DEFAULT_THREADS};
+    uint32_t threads{};
+    uint32_t idleThreads{};
+    uint64_t executed{};
+};
+
+#endif //SAPNWRFC_RFCEXECUTOR_H
@@ -0,0 +1,144 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "RfcQueue.h"
+#include "RfcExecutor.h"
+#include "RfcWorker.h"
+#include <exception>
+
+void RfcQueue::Push(RfcWorker *worker) {
+  std::lock_guard<std::mutex> lock{mutex};
+  workers.push_back(worker);
+  if (!scheduled) {
+    scheduled = true;
+    RfcExecutor::Instance().Schedule(shared_from_this());
+  }
+}
+
+size_t RfcQueue::Size() {
+  std::lock_guard<std::mutex> lock{mutex};
+  return workers.size() + (current != nullptr ? 1 : 0);
+}
+
+bool RfcQueue::Cancel(uint32_t id) {
+  RfcWorker *removed{};
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    if (current != nullptr && current->Id() == id) {
+      // The worker cannot finish while the lock is held
+      current->Cancel();
+      return true;
+    }
+    for (auto it = workers.begin(); it != workers.end(); ++it) {
+      if ((*it)->Id() == id) {
+        removed = *it;
+        workers.erase(it);
+        break;
+      }
+    }
+  }
+
+  if (removed == nullptr) {
+    return false;
+  }
+  removed->RfcWorker::Cancel();
+  removed->SetError("Call cancelled");
+  removed->Finish();
+  return true;
+}
+
+void RfcQueue::Interrupt(RfcWorker *worker) {
+  std::lock_guard<std::mutex> lock{mutex};
+  if (current == worker) {
+    worker->Cancel();
+  } else {
+    // Only the running worker may interrupt the connection
+    worker->RfcWorker::Cancel();
+  }
+}
+
+void RfcQueue::RunNext() {
+  RfcWorker *worker;
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    // All waiting workers may have been cancelled meanwhile
+    if (workers.empty()) {
+      scheduled = false;
+      return;
+    }
+    worker = workers.front();
+    workers.pop_front();
+    current = worker;
+  }
+
+  try {
+    worker->Execute();
+  } catch (const std::exception &e) {
+    worker->SetError(e.what());
+  }
+
+  auto retryDelay = worker->TakeRetryDelay();
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    current = nullptr;
+    if (retryDelay.count() > 0 && !drained) {
+      // Later workers of the connection wait for the retry
+      workers.push_front(worker);
+      RfcExecutor::Instance().ScheduleAfter(shared_from_this(), retryDelay);
+      return;
+    }
+    if (workers.empty()) {
+      scheduled = false;
+    } else {
+      RfcExecutor::Instance().Schedule(shared_from_this());
+    }
+    finishing = true;
+  }
+
+  worker->Finish();
+
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    finishing = false;
+  }
+  idle.notify_all();
+}
+
+void RfcQueue::Drain() {
+  std::deque<RfcWorker *> dropped;
+  {
+    std::unique_lock<std::mutex> lock{mutex};
+    drained = true;
+    dropped.swap(workers);
+    if (current != nullptr) {
+      current->Cancel();
+    }
+    // The completion of the running worker must have been posted
+    idle.wait(lock, [this] { return current == nullptr && !finishing; });
+  }
+
+  for (auto worker : dropped) {
+    worker->Discard();
+  }
+}
@@ -0,0 +1,92 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef SAPNWRFC_RFCQUEUE_H
+#define SAPNWRFC_RFCQUEUE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+class RfcWorker;
+
+/*
+ * FIFO of the workers of one connection. While it has pending work, the queue is scheduled on
+ * the RfcExecutor, which runs one worker at a time. Calls waiting for a busy connection
+ * therefore occupy no thread at all.
+ *
+ * Queues are shared between their connection and the executor, which may still hold a queue
+ * whose waiting workers have all been cancelled.
+ */
+class RfcQueue : public std::enable_shared_from_this<RfcQueue> {
+  public:
+    RfcQueue() = default;
+    RfcQueue(const RfcQueue &) = delete;
+    RfcQueue &operator=(const RfcQueue &) = delete;
+
+    void Push(RfcWorker *worker);
+
+    /*
+     * @return number of workers waiting or running
+     */
+    size_t Size();
+
+    /*
+     * Cancels a worker of this queue, called on the main thread. A waiting worker is removed
+     * and completed with a cancellation error, a running one is asked to interrupt its SDK call.
+     *
+     * @return false if no such worker is waiting or running
+     */
+    bool Cancel(uint32_t id);
+
+    /*
+     * Flags a worker of this queue as cancelled and interrupts it if it is running. Unlike
+     * Cancel(), a waiting worker stays queued and fails as soon as it is executed.
+     */
+    void Interrupt(RfcWorker *worker);
+
+    /*
+     * Executes the first worker, called by an executor thread.
+     */
+    void RunNext();
+
+    /*
+     * Drops the waiting workers and cancels the running one, then waits until it has finished.
+     * Called on the main thread when the environment of the connection is torn down.
+     */
+    void Drain();
+
+  private:
+    std::mutex mutex;
+    std::condition_variable idle;
+    std::deque<RfcWorker *> workers;
+    RfcWorker *current{};
+    bool finishing{};
+    bool drained{};
+    bool scheduled{};
+};
+
+#endif //SAPNWRFC_RFCQUEUE_H
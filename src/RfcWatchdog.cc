@@ -0,0 +1,78 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "RfcWatchdog.h"
+#include "RfcWorker.h"
+
+RfcWatchdog &RfcWatchdog::Instance() {
+  // Never destroyed, like the executor its detached thread lives until the process exits
+  static auto instance = new RfcWatchdog;
+  return *instance;
+}
+
+void RfcWatchdog::Arm(RfcWorker *worker, uint32_t timeout) {
+  std::lock_guard<std::mutex> lock{mutex};
+  if (!started) {
+    started = true;
+    std::thread{&RfcWatchdog::Run, this}.detach();
+  }
+
+  auto it = deadlines.emplace(Clock::now() + std::chrono::milliseconds(timeout), worker);
+  armed[worker] = it;
+  // Only an earlier deadline changes the thread's wait time
+  if (it == deadlines.begin()) {
+    changed.notify_one();
+  }
+}
+
+void RfcWatchdog::Disarm(RfcWorker *worker) {
+  // Expiring happens with the lock held
+  std::lock_guard<std::mutex> lock{mutex};
+  auto it = armed.find(worker);
+  if (it != armed.end()) {
+    deadlines.erase(it->second);
+    armed.erase(it);
+  }
+}
+
+void RfcWatchdog::Run() {
+  std::unique_lock<std::mutex> lock{mutex};
+  while (true) {
+    if (deadlines.empty()) {
+      changed.wait(lock);
+      continue;
+    }
+
+    auto next = deadlines.begin()->first;
+    if (Clock::now() < next) {
+      changed.wait_until(lock, next);
+      continue;
+    }
+
+    auto worker = deadlines.begin()->second;
+    deadlines.erase(deadlines.begin());
+    armed.erase(worker);
+    worker->Expire();
+  }
+}
@@ -0,0 +1,68 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef SAPNWRFC_RFCWATCHDOG_H
+#define SAPNWRFC_RFCWATCHDOG_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+class RfcWorker;
+
+/*
+ * Single thread tracking the deadlines of all workers with a timeout. Overdue workers are
+ * expired (see RfcWorker::Expire()), which cancels the SDK call of a running invocation.
+ */
+class RfcWatchdog {
+  public:
+    typedef std::chrono::steady_clock Clock;
+
+    static RfcWatchdog &Instance();
+
+    void Arm(RfcWorker *worker, uint32_t timeout);
+
+    /*
+     * Stops watching the worker. Waits if the worker is being expired right now, so that
+     * the worker can be completed afterwards.
+     */
+    void Disarm(RfcWorker *worker);
+
+  private:
+    RfcWatchdog() = default;
+
+    void Run();
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::multimap<Clock::time_point, RfcWorker *> deadlines;
+    std::unordered_map<RfcWorker *, std::multimap<Clock::time_point, RfcWorker *>::iterator> armed;
+    bool started{};
+};
+
+#endif //SAPNWRFC_RFCWATCHDOG_H
@@ -0,0 +1,220 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "RfcWorker.h"
+#include "AddonData.h"
+#include "RfcQueue.h"
+#include "RfcWatchdog.h"
+#include "Utils.h"
+#include <cassert>
+
+std::atomic<uint32_t> RfcWorker::nextId{1};
+
+RfcWorker::RfcWorker(Napi::Env env, const Napi::Function &callback, RfcQueue &queue)
+    : env{env}, completions{AddonData::Get(env).completions}, queue{queue}, id{nextId++} {
+  if (!callback.IsEmpty()) {
+    this->callback = Napi::Persistent(callback);
+  }
+}
+
+RfcWorker::~RfcWorker() = default;
+
+void RfcWorker::CreateCompletions(Napi::Env env, napi_threadsafe_function &completions) {
+  auto status = napi_create_threadsafe_function(env, nullptr, nullptr, Napi::String::New(env, "sapnwrfc"),
+                                                0, 1, nullptr, nullptr, nullptr, CallJs, &completions);
+  if (status != napi_ok) {
+    throw Napi::Error::New(env);
+  }
+  napi_unref_threadsafe_function(env, completions);
+}
+
+void RfcWorker::Queue() {
+  // Pending workers keep the event loop running, just like libuv work requests do
+  auto &data = AddonData::Get(env);
+  if (data.pendingWorkers++ == 0) {
+    napi_ref_threadsafe_function(env, completions);
+  }
+
+  if (UsesConnection()) {
+    if (timeout > 0) {
+      RfcWatchdog::Instance().Arm(this, timeout);
+    }
+    queue.Push(this);
+  } else {
+    Post(this);
+  }
+}
+
+void RfcWorker::Discard() {
+  if (timeout > 0) {
+    RfcWatchdog::Instance().Disarm(this);
+  }
+  delete this;
+}
+
+uint32_t RfcWorker::Id() const {
+  return id;
+}
+
+bool RfcWorker::IsCancelled() const {
+  return cancelled;
+}
+
+void RfcWorker::Cancel() {
+  cancelled = true;
+}
+
+void RfcWorker::SetTimeout(uint32_t timeout) {
+  this->timeout = timeout;
+}
+
+uint32_t RfcWorker::Timeout() const {
+  return timeout;
+}
+
+bool RfcWorker::IsTimedOut() const {
+  return timedOut;
+}
+
+void RfcWorker::Expire() {
+  timedOut = true;
+  queue.Interrupt(this);
+
+  // Posted before the regular completion, Finish() waits for the watchdog
+  expiryPending = true;
+  Post(this);
+}
+
+Napi::Env RfcWorker::Env() const {
+  return env;
+}
+
+Napi::FunctionReference &RfcWorker::Callback() {
+  return callback;
+}
+
+void RfcWorker::SetError(const std::string &message) {
+  failed = true;
+  error = message;
+}
+
+bool RfcWorker::UsesConnection() {
+  return true;
+}
+
+void RfcWorker::RetryAfter(std::chrono::milliseconds delay) {
+  retryDelay = delay;
+}
+
+std::chrono::milliseconds RfcWorker::TakeRetryDelay() {
+  auto delay = retryDelay;
+  retryDelay = std::chrono::milliseconds{};
+  return delay;
+}
+
+void RfcWorker::Finish() {
+  if (timeout > 0) {
+    RfcWatchdog::Instance().Disarm(this);
+  }
+  Post(this);
+}
+
+void RfcWorker::Continue() {
+  continued = true;
+}
+
+void RfcWorker::OnOK() {
+  if (!callback.IsEmpty()) {
+    callback.Call({});
+  }
+}
+
+void RfcWorker::OnError(const Napi::Error &e) {
+  if (!callback.IsEmpty()) {
+    callback.Call({e.Value()});
+  }
+}
+
+void RfcWorker::OnTimeout() {
+  OnError(TimeoutError(env, timeout));
+}
+
+void RfcWorker::Post(RfcWorker *worker) {
+  auto status = napi_call_threadsafe_function(worker->completions, worker, napi_tsfn_blocking);
+  assert(status == napi_ok);
+  (void) status;
+}
+
+void RfcWorker::CallJs(napi_env env, napi_value, void *, void *data) {
+  // The environment is being torn down, nothing can be called anymore and the worker is leaked
+  if (env == nullptr) {
+    return;
+  }
+  Complete(static_cast<RfcWorker *>(data));
+}
+
+void RfcWorker::Complete(RfcWorker *worker) {
+  auto env = worker->env;
+  Napi::HandleScope scope{env};
+
+  Napi::Value exception;
+  if (worker->expiryPending.exchange(false)) {
+    worker->reported = true;
+    try {
+      worker->OnTimeout();
+    } catch (const Napi::Error &e) {
+      napi_throw(env, e.Value());
+    }
+    return;
+  }
+
+  // Exceptions of callbacks are rethrown after the worker has been cleaned up
+  try {
+    if (worker->reported) {
+      // The timeout has already been reported
+    } else if (worker->failed) {
+      worker->OnError(worker->cancelled ? CancelledError(env) : Napi::Error::New(env, worker->error));
+    } else {
+      worker->OnOK();
+    }
+  } catch (const Napi::Error &e) {
+    exception = e.Value();
+  }
+
+  if (worker->continued) {
+    worker->continued = false;
+    worker->Queue();
+  } else {
+    delete worker;
+  }
+
+  auto &data = AddonData::Get(env);
+  if (--data.pendingWorkers == 0) {
+    napi_unref_threadsafe_function(env, data.completions);
+  }
+
+  if (!exception.IsEmpty()) {
+    napi_throw(env, exception);
+  }
+}
@@ -0,0 +1,150 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef SAPNWRFC_RFCWORKER_H
+#define SAPNWRFC_RFCWORKER_H
+
+#include <napi.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+class RfcQueue;
+
+/*
+ * Unit of blocking SDK work. Execute() runs on the thread serving the connection's queue,
+ * OnOK()/OnError() run on the main thread afterwards, then the worker deletes itself.
+ * Completions are posted back through a single threadsafe function, which only keeps the
+ * event loop alive while workers are pending.
+ *
+ * A worker with a timeout is watched by the RfcWatchdog from being queued until it has finished.
+ * When the deadline passes, the worker is cancelled and OnTimeout() reports the timeout at once,
+ * the regular completion then only cleans up.
+ */
+class RfcWorker {
+  public:
+    RfcWorker(Napi::Env env, const Napi::Function &callback, RfcQueue &queue);
+    RfcWorker(const RfcWorker &) = delete;
+    RfcWorker &operator=(const RfcWorker &) = delete;
+
+    virtual ~RfcWorker();
+
+    /*
+     * Creates the threadsafe function through which the workers of an environment complete.
+     */
+    static void CreateCompletions(Napi::Env env, napi_threadsafe_function &completions);
+
+    /*
+     * Appends the worker to its connection's queue.
+     */
+    void Queue();
+
+    /*
+     * Deletes a worker which will never be executed, as its environment is torn down.
+     */
+    void Discard();
+
+    /*
+     * @return id identifying the worker within its queue, see RfcQueue::Cancel()
+     */
+    uint32_t Id() const;
+    bool IsCancelled() const;
+
+    /*
+     * Requests cancellation of the running worker, called on the main thread or by the watchdog
+     * while the queue is locked. Overrides interrupt the blocking SDK call.
+     */
+    virtual void Cancel();
+
+    /*
+     * Sets the timeout in milliseconds, 0 means no timeout. Must be called before Queue().
+     */
+    void SetTimeout(uint32_t timeout);
+    uint32_t Timeout() const;
+    bool IsTimedOut() const;
+
+    /*
+     * Called by the watchdog when the deadline has passed.
+     */
+    void Expire();
+
+    Napi::Env Env() const;
+    Napi::FunctionReference &Callback();
+    void SetError(const std::string &message);
+
+    /*
+     * Workers which only deliver an already available result skip the queue.
+     */
+    virtual bool UsesConnection();
+
+    virtual void Execute() = 0;
+
+    /*
+     * Called by Execute() instead of SetError() to execute the worker again after a delay.
+     * The worker stays at the head of its queue meanwhile.
+     */
+    void RetryAfter(std::chrono::milliseconds delay);
+    std::chrono::milliseconds TakeRetryDelay();
+
+    /*
+     * Called on the worker thread after Execute(), posts the completion to the main thread.
+     */
+    void Finish();
+
+    /*
+     * Called by OnOK() to queue the worker again instead of deleting it, for work which needs the main thread
+     * between two steps on the connection. The worker keeps its id, a timeout starts again.
+     */
+    void Continue();
+
+  protected:
+    virtual void OnOK();
+    virtual void OnError(const Napi::Error &e);
+    virtual void OnTimeout();
+
+  private:
+    static void CallJs(napi_env env, napi_value jsCallback, void *context, void *data);
+    static void Post(RfcWorker *worker);
+    static void Complete(RfcWorker *worker);
+
+    static std::atomic<uint32_t> nextId;
+
+    Napi::Env env;
+    napi_threadsafe_function completions;
+    Napi::FunctionReference callback;
+    RfcQueue &queue;
+    uint32_t id;
+    std::atomic<bool> cancelled{false};
+    std::string error;
+    bool failed{};
+    std::chrono::milliseconds retryDelay{};
+    uint32_t timeout{};
+    std::atomic<bool> timedOut{false};
+    std::atomic<bool> expiryPending{false};
+    bool reported{};
+    bool continued{};
+};
+
+#endif //SAPNWRFC_RFCWORKER_H
@@ -0,0 +1,274 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#include "SchemaValidator.h"
+#include <cmath>
+#include <limits>
+
+namespace {
+
+bool IsDigits(const std::u16string &value) {
+  for (auto c : value) {
+    if (c < u'0' || c > u'9') {
+      return false;
+    }
+  }
+  return true;
+}
+
+unsigned Number(const std::u16string &value, size_t offset, size_t length) {
+  unsigned number = 0;
+  for (size_t i = offset; i < offset + length; i++) {
+    number = number * 10 + (value[i] - u'0');
+  }
+  return number;
+}
+
+bool IsLeapYear(unsigned year) {
+  return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+// The initial value 00000000 is a valid date in ABAP
+bool IsValidDate(const std::u16string &value) {
+  if (value.size() != 8 || !IsDigits(value)) {
+    return false;
+  }
+  auto year = Number(value, 0, 4);
+  auto month = Number(value, 4, 2);
+  auto day = Number(value, 6, 2);
+  if (year == 0 && month == 0 && day == 0) {
+    return true;
+  }
+  static const unsigned days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  if (month < 1 || month > 12 || day < 1) {
+    return false;
+  }
+  return day <= days[month - 1] + (month == 2 && IsLeapYear(year) ? 1 : 0);
+}
+
+bool IsValidTime(const std::u16string &value) {
+  return value.size() == 6 && IsDigits(value) && Number(value, 0, 2) < 24 && Number(value, 2, 2) < 60 &&
+         Number(value, 4, 2) < 60;
+}
+
+bool IsIntegerInRange(double value, double min, double max) {
+  return std::floor(value) == value && value >= min && value <= max;
+}
+
+}
+
+SchemaValidator::SchemaValidator(Napi::Env env) : env{env}, violations{Napi::Array::New(env)} {}
+
+Napi::Error SchemaValidator::ValidationError(Napi::Env env, Napi::Array violations) {
+  auto first = violations.Get(uint32_t{0}).As<Napi::Object>();
+  auto message = "Invalid input: " + first.Get("path").ToString().Utf8Value() + " " +
+                 first.Get("message").ToString().Utf8Value();
+  if (violations.Length() > 1) {
+    message += " (and " + std::to_string(violations.Length() - 1) + " more)";
+  }
+  auto e = Napi::TypeError::New(env, message);
+  e.Set("violations", violations);
+  return e;
+}
+
+void SchemaValidator::AddViolation(const std::string &message) {
+  std::u16string rendered;
+  for (const auto &segment : path) {
+    if (segment.row >= 0) {
+      auto row = std::to_string(segment.row);
+      rendered += u'[';
+      rendered.append(row.begin(), row.end());
+      rendered += u']';
+    } else {
+      if (!rendered.empty()) {
+        rendered += u'.';
+      }
+      rendered += *segment.name;
+    }
+  }
+
+  auto violation = Napi::Object::New(env);
+  violation.Set("path", Napi::String::New(env, rendered));
+  violation.Set("message", Napi::String::New(env, message));
+  violations.Set(count++, violation);
+}
+
+Napi::Array SchemaValidator::Validate(const FunctionSchema &schema, Napi::Object input) {
+  Napi::HandleScope scope{env};
+
+  auto names = input.GetPropertyNames();
+  for (uint32_t i = 0; i < names.Length(); i++) {
+    auto name = names.Get(i).ToString().Utf16Value();
+    auto it = schema.index.find(name);
+    path.push_back({&name, -1});
+    if (it == schema.index.end()) {
+      AddViolation("is not a parameter of the function");
+    } else if (schema.parameters[it->second].direction == RFC_EXPORT && !input.Get(names.Get(i)).IsNull()) {
+      AddViolation("is an export parameter");
+    }
+    path.pop_back();
+  }
+
+  for (const auto &parameter : schema.parameters) {
+    path.push_back({&parameter.name, -1});
+    auto value = input.Get(Napi::String::New(env, parameter.name));
+    // Like in SetParameters(), null leaves a parameter initial
+    if (value.IsUndefined() || value.IsNull()) {
+      if (!parameter.optional && (parameter.direction == RFC_IMPORT || parameter.direction == RFC_CHANGING)) {
+        AddViolation("is mandatory");
+      }
+    } else if (parameter.direction != RFC_EXPORT) {
+      ValidateElement(parameter, value);
+    }
+    path.pop_back();
+  }
+
+  return violations;
+}
+
+void SchemaValidator::ValidateStructure(const TypeSchema &type, Napi::Value value) {
+  if (!value.IsObject() || value.IsArray()) {
+    AddViolation("must be an object");
+    return;
+  }
+
+  auto object = value.ToObject();
+  auto names = object.GetPropertyNames();
+  for (uint32_t i = 0; i < names.Length(); i++) {
+    Napi::HandleScope scope{env};
+    auto name = names.Get(i).ToString().Utf16Value();
+    path.push_back({&name, -1});
+    auto it = type.index.find(name);
+    if (it == type.index.end()) {
+      AddViolation("is not a field of " + Napi::String::New(env, type.name).Utf8Value());
+    } else {
+      ValidateElement(type.fields[it->second], object.Get(names.Get(i)));
+    }
+    path.pop_back();
+  }
+}
+
+void SchemaValidator::ValidateElement(const ElementSchema &element, Napi::Value value) {
+  switch (element.type) {
+    case RFCTYPE_CHAR:
+    case RFCTYPE_NUM: {
+      if (!value.IsString()) {
+        AddViolation("must be a string");
+        break;
+      }
+      auto text = value.ToString().Utf16Value();
+      if (text.size() > element.nucLength) {
+        AddViolation("exceeds " + std::to_string(element.nucLength) + " characters");
+      }
+      if (element.type == RFCTYPE_NUM && !IsDigits(text)) {
+        AddViolation("must only contain digits");
+      }
+      break;
+    }
+    case RFCTYPE_DATE:
+      if (!value.IsString() || !IsValidDate(value.ToString().Utf16Value())) {
+        AddViolation("must be a date formatted as YYYYMMDD");
+      }
+      break;
+    case RFCTYPE_TIME:
+      if (!value.IsString() || !IsValidTime(value.ToString().Utf16Value())) {
+        AddViolation("must be a time formatted as HHMMSS");
+      }
+      break;
+    case RFCTYPE_STRING:
+      if (!value.IsString()) {
+        AddViolation("must be a string");
+      }
+      break;
+    case RFCTYPE_BYTE:
+      if (!value.IsBuffer()) {
+        AddViolation("must be a Buffer");
+      } else if (value.As<Napi::Buffer<uint8_t>>().Length() > element.nucLength) {
+        AddViolation("exceeds " + std::to_string(element.nucLength) + " bytes");
+      }
+      break;
+    case RFCTYPE_XSTRING:
+      if (!value.IsBuffer()) {
+        AddViolation("must be a Buffer");
+      }
+      break;
+    case RFCTYPE_INT:
+      if (!value.IsNumber() || !IsIntegerInRange(value.ToNumber().DoubleValue(),
+                                                 std::numeric_limits<int32_t>::min(),
+                                                 std::numeric_limits<int32_t>::max())) {
+        AddViolation("must be an integer of 4 bytes");
+      }
+      break;
+    case RFCTYPE_INT2:
+      if (!value.IsNumber() || !IsIntegerInRange(value.ToNumber().DoubleValue(),
+                                                 std::numeric_limits<int16_t>::min(),
+                                                 std::numeric_limits<int16_t>::max())) {
+        AddViolation("must be an integer from -32768 to 32767");
+      }
+      break;
+    case RFCTYPE_INT1:
+      if (!value.IsNumber() || !IsIntegerInRange(value.ToNumber().DoubleValue(), 0, 255)) {
+        AddViolation("must be an integer from 0 to 255");
+      }
+      break;
+    case RFCTYPE_FLOAT:
+      if (!value.IsNumber() || !std::isfinite(value.ToNumber().DoubleValue())) {
+        AddViolation("must be a finite number");
+      }
+      break;
+    case RFCTYPE_BCD: {
+      // A packed number of n bytes holds 2n - 1 digits, decimals of them after the decimal point
+      if (!value.IsNumber() || !std::isfinite(value.ToNumber().DoubleValue())) {
+        AddViolation("must be a finite number");
+        break;
+      }
+      int integerDigits = static_cast<int>(element.nucLength * 2) - 1 - static_cast<int>(element.decimals);
+      if (std::fabs(value.ToNumber().DoubleValue()) >= std::pow(10.0, integerDigits)) {
+        AddViolation("exceeds " + std::to_string(integerDigits < 0 ? 0 : integerDigits) + " integer digits");
+      }
+      break;
+    }
+    case RFCTYPE_STRUCTURE:
+      ValidateStructure(*element.rowType, value);
+      break;
+    case RFCTYPE_TABLE: {
+      if (!value.IsArray()) {
+        AddViolation("must be an array");
+        break;
+      }
+      auto rows = value.As<Napi::Array>();
+      for (uint32_t i = 0; i < rows.Length(); i++) {
+        Napi::HandleScope scope{env};
+        path.push_back({nullptr, i});
+        ValidateStructure(*element.rowType, rows.Get(i));
+        path.pop_back();
+      }
+      break;
+    }
+    default:
+      AddViolation("has a type which is not supported");
+      break;
+  }
+}
@@ -0,0 +1,73 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#ifndef SAPNWRFC_SCHEMAVALIDATOR_H
+#define SAPNWRFC_SCHEMAVALIDATOR_H
+
+#include <napi.h>
+#include <string>
+#include <vector>
+#include "FunctionSchema.h"
+
+/*
+ * Checks the input parameters of an invocation against the schema of the function in a single pass, before a
+ * function container is created. Unlike the converters of Function::SetValue(), which stop at the first error,
+ * it collects every violation as { path, message }, e.g. { path: 'ITEMS[3].MATNR', message: 'exceeds 18 characters' }.
+ *
+ * Besides the types and lengths checked by the converters, it rejects unknown parameters and fields, export
+ * parameters, missing mandatory parameters and invalid dates and times.
+ */
+class SchemaValidator {
+  public:
+    explicit SchemaValidator(Napi::Env env);
+
+    /*
+     * @return array of violations, empty if the input is valid
+     */
+    Napi::Array Validate(const FunctionSchema &schema, Napi::Object input);
+
+    /*
+     * Creates the error reported for invalid input, with the violations attached.
+     */
+    static Napi::Error ValidationError(Napi::Env env, Napi::Array violations);
+
+  protected:
+    void ValidateElement(const ElementSchema &element, Napi::Value value);
+    void ValidateStructure(const TypeSchema &type, Napi::Value value);
+    void AddViolation(const std::string &message);
+
+    // The path is only rendered for violations
+    struct Segment {
+      const std::u16string *name;
+      int64_t row;
+    };
+
+    Napi::Env env;
+    Napi::Array violations;
+    uint32_t count{};
+    std::vector<Segment> path;
+};
+
+#endif //SAPNWRFC_SCHEMAVALIDATOR_H
@@ -0,0 +1,688 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#include "Server.h"
+#include "AddonData.h"
+#include "Function.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cstring>
+
+// Seconds RfcListenAndDispatch() waits for a call, bounds the time Stop() takes
+static const int LISTEN_TIMEOUT = 1;
+
+static const std::chrono::milliseconds REGISTER_INITIAL_DELAY{1000};
+static const std::chrono::milliseconds REGISTER_MAX_DELAY{30000};
+
+thread_local Server::Listener *Server::listening = nullptr;
+
+static uint32_t uint32Option(Napi::Env env, Napi::Object options, const char *name, uint32_t defaultValue) {
+  auto value = options.Get(name);
+  if (value.IsUndefined()) {
+    return defaultValue;
+  }
+  if (!value.IsNumber() || value.As<Napi::Number>().DoubleValue() < 1) {
+    throw Napi::TypeError::New(env, std::string("Option ") + name + " must be a positive number");
+  }
+  return value.As<Napi::Number>().Uint32Value();
+}
+
+static void copyToSAPUC(SAP_UC *target, size_t size, const std::u16string &value) {
+  auto length = std::min(value.size(), size - 1);
+  memcpy(target, value.data(), length * sizeof(SAP_UC));
+  target[length] = 0;
+}
+
+static void setFailure(RFC_ERROR_INFO *errorInfo, RFC_RC code, RFC_ERROR_GROUP group, const std::u16string &message) {
+  errorInfo->code = code;
+  errorInfo->group = group;
+  copyToSAPUC(errorInfo->message, sizeof(errorInfo->message) / sizeof(SAP_UC), message);
+}
+
+static double milliseconds(std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+/**
+ * new Server(registrationParams[, {listeners, maxQueue, overload}])
+ *
+ * registrationParams are gwhost, gwserv, program_id etc. or dest of a sapnwrfc.ini entry. maxQueue defaults to the
+ * number of listeners, overload is 'wait' (default) or 'reject'.
+ */
+Server::Server(const Napi::CallbackInfo &info)
+    : Napi::ObjectWrap<Server>(info) {
+  auto env = info.Env();
+  init(Value());
+
+  if (info.Length() < 1 || !info[0].IsObject()) {
+    throw Napi::TypeError::New(env, "Argument 1 must be an object");
+  }
+  if (info.Length() > 1 && !info[1].IsUndefined() && !info[1].IsObject()) {
+    throw Napi::TypeError::New(env, "Argument 2 must be an object");
+  }
+
+  if (info.Length() > 1 && info[1].IsObject()) {
+    auto options = info[1].ToObject();
+    listenerCount = uint32Option(env, options, "listeners", listenerCount);
+    maxQueue = uint32Option(env, options, "maxQueue", listenerCount);
+    auto overload = options.Get("overload");
+    if (!overload.IsUndefined()) {
+      auto policy = overload.IsString() ? overload.ToString().Utf8Value() : std::string{};
+      if (policy != "wait" && policy != "reject") {
+        throw Napi::TypeError::New(env, "Option overload must be 'wait' or 'reject'");
+      }
+      rejectOnOverload = policy == "reject";
+    }
+  } else {
+    maxQueue = listenerCount;
+  }
+
+  auto params = info[0].ToObject();
+  auto names = params.GetPropertyNames();
+  registrationParamsSize = names.Length();
+  registrationParams = static_cast<RFC_CONNECTION_PARAMETER *>(
+      calloc(registrationParamsSize, sizeof(RFC_CONNECTION_PARAMETER)));
+  for (unsigned int i = 0; i < registrationParamsSize; i++) {
+    auto name = names.Get(i);
+    registrationParams[i].name = convertToSAPUC(name.ToString());
+    registrationParams[i].value = convertToSAPUC(params.Get(name).ToString());
+  }
+
+  log(env, Levels::SILLY, "Server::Server");
+}
+
+Server::~Server() {
+  deferLog(Levels::SILLY, "Server::~Server");
+
+  for (unsigned int i = 0; i < registrationParamsSize; i++) {
+    free(const_cast<SAP_UC *>(registrationParams[i].name));
+    free(const_cast<SAP_UC *>(registrationParams[i].value));
+  }
+  free(registrationParams);
+}
+
+Napi::Object Server::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "Server", {
+      InstanceMethod("AddFunction", &Server::AddFunction),
+      InstanceMethod("Start", &Server::Start),
+      InstanceMethod("Stop", &Server::Stop),
+      InstanceMethod("IsRunning", &Server::IsRunning),
+      InstanceMethod("Stats", &Server::Stats)
+  });
+
+  exports.Set("Server", func);
+  return exports;
+}
+
+/**
+ * AddFunction(func, handler): installs the function module described by func, calls from ABAP are passed to
+ * handler(params, { functionName }). The handler returns the exporting, changing and table parameters to be sent
+ * back, or a Promise of them. Errors with a string property abapException raise that ABAP exception, other errors
+ * are reported as system failure.
+ */
+Napi::Value Server::AddFunction(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::HandleScope scope{env};
+
+  log(env, Levels::SILLY, "Server::AddFunction");
+
+  if (info.Length() < 2) {
+    throw Napi::Error::New(env, "Function expects 2 arguments");
+  }
+  if (!info[0].IsObject() || !info[0].ToObject().InstanceOf(AddonData::Get(env).functionCtor.Value())) {
+    throw Napi::TypeError::New(env, "Argument 1 must be a Function");
+  }
+  if (!info[1].IsFunction()) {
+    throw Napi::TypeError::New(env, "Argument 2 must be a function");
+  }
+
+  auto function = Napi::ObjectWrap<Function>::Unwrap(info[0].ToObject());
+
+  // Installed for all systems, the server of the listening thread picks the handler
+  RfcInstallServerFunction(nullptr, function->functionDescHandle, Dispatch, &errorInfo);
+  LOG_API(env, this, "RfcInstallServerFunction");
+  if (errorInfo.code != RFC_OK) {
+    throw RfcError(env, errorInfo);
+  }
+
+  auto &handler = handlers[function->functionName];
+  handler.function = Napi::Persistent(info[0].ToObject());
+  handler.handler = Napi::Persistent(info[1].As<Napi::Function>());
+  return env.Undefined();
+}
+
+/**
+ * Start([callback]): registers the listeners at the gateway, callback(err) is called once all of them are
+ * listening. If a listener cannot register, the others are stopped again.
+ */
+Napi::Value Server::Start(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::HandleScope scope{env};
+
+  log(env, Levels::SILLY, "Server::Start");
+
+  if (info.Length() > 0 && !info[0].IsUndefined() && !info[0].IsFunction()) {
+    throw Napi::TypeError::New(env, "Argument 1 must be a function");
+  }
+  if (running) {
+    throw Napi::Error::New(env, "Server is already running");
+  }
+
+  auto status = napi_create_threadsafe_function(env, nullptr, nullptr, Napi::String::New(env, "sapnwrfc.Server"),
+                                                0, 1, nullptr, nullptr, this, CallJs, &events);
+  if (status != napi_ok) {
+    throw Napi::Error::New(env);
+  }
+  status = napi_add_env_cleanup_hook(env, Cleanup, this);
+  if (status != napi_ok) {
+    napi_release_threadsafe_function(events, napi_tsfn_abort);
+    throw Napi::Error::New(env);
+  }
+
+  if (info.Length() > 0 && info[0].IsFunction()) {
+    startCallback = Napi::Persistent(info[0].As<Napi::Function>());
+  }
+
+  // A running server stays alive and keeps the event loop running until it is stopped
+  Reference::Ref();
+  running = true;
+  stopping = false;
+  aborted = false;
+  startError = RFC_ERROR_INFO{};
+  queueDepth = 0;
+  reservedSlots = 0;
+  peakQueueDepth = 0;
+
+  // Statistics of the previous run are kept until the server is started again
+  listeners.clear();
+  for (uint32_t i = 0; i < listenerCount; i++) {
+    listeners.emplace_back(new Listener);
+    listeners.back()->server = this;
+  }
+  runningListeners = listenerCount;
+  startingListeners = listenerCount;
+  for (auto &listener : listeners) {
+    listener->thread = std::thread{&Server::Listen, this, listener.get()};
+  }
+  return env.Undefined();
+}
+
+/**
+ * Stop([callback]): stops listening and closes the registrations, callback() is called when the calls in progress
+ * have been answered.
+ */
+Napi::Value Server::Stop(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::HandleScope scope{env};
+
+  log(env, Levels::SILLY, "Server::Stop");
+
+  if (info.Length() > 0 && !info[0].IsUndefined() && !info[0].IsFunction()) {
+    throw Napi::TypeError::New(env, "Argument 1 must be a function");
+  }
+  if (!running || stopping) {
+    throw Napi::Error::New(env, "Server is not running");
+  }
+
+  if (info.Length() > 0 && info[0].IsFunction()) {
+    stopCallback = Napi::Persistent(info[0].As<Napi::Function>());
+  }
+
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    stopping = true;
+  }
+  wakeup.notify_all();
+  return env.Undefined();
+}
+
+Napi::Value Server::IsRunning(const Napi::CallbackInfo &info) {
+  return Napi::Boolean::New(info.Env(), running && !stopping);
+}
+
+/**
+ * Stats(): queue depth and per listener whether it is registered and busy, its number of calls and rejected calls
+ * and the latency of its calls in milliseconds, from receiving them until they were answered. queueTime is the part
+ * spent waiting for the main thread.
+ */
+Napi::Value Server::Stats(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+
+  std::lock_guard<std::mutex> lock{mutex};
+
+  auto stats = Napi::Object::New(env);
+  stats.Set("queueDepth", Napi::Number::New(env, queueDepth));
+  stats.Set("peakQueueDepth", Napi::Number::New(env, peakQueueDepth));
+  stats.Set("maxQueue", Napi::Number::New(env, maxQueue));
+
+  auto listenerStats = Napi::Array::New(env, listeners.size());
+  for (uint32_t i = 0; i < listeners.size(); i++) {
+    const auto &listener = *listeners[i];
+    auto entry = Napi::Object::New(env);
+    entry.Set("registered", Napi::Boolean::New(env, listener.registered));
+    entry.Set("busy", Napi::Boolean::New(env, listener.busy));
+    entry.Set("registrations", Napi::Number::New(env, listener.registrations));
+    entry.Set("calls", Napi::Number::New(env, listener.calls));
+    entry.Set("rejected", Napi::Number::New(env, listener.rejected));
+    entry.Set("lastLatency", Napi::Number::New(env, listener.lastLatency));
+    entry.Set("averageLatency", Napi::Number::New(env, listener.calls ? listener.totalLatency / listener.calls : 0));
+    entry.Set("maxLatency", Napi::Number::New(env, listener.maxLatency));
+    entry.Set("averageQueueTime",
+              Napi::Number::New(env, listener.calls ? listener.totalQueueTime / listener.calls : 0));
+    listenerStats.Set(i, entry);
+  }
+  stats.Set("listeners", listenerStats);
+
+  return scope.Escape(stats);
+}
+
+void Server::Listen(Listener *listener) {
+  listening = listener;
+
+  RFC_ERROR_INFO errorInfo{};
+  auto connectionHandle = RfcRegisterServer(registrationParams, registrationParamsSize, &errorInfo);
+  if (connectionHandle == nullptr) {
+    Post(new Event{Event::STOPPED, listener, nullptr, errorInfo});
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    listener->registered = true;
+    listener->registrations++;
+  }
+  Post(new Event{Event::STARTED, listener, nullptr, RFC_ERROR_INFO{}});
+
+  auto delay = REGISTER_INITIAL_DELAY;
+  while (!stopping) {
+    if (connectionHandle == nullptr) {
+      connectionHandle = RfcRegisterServer(registrationParams, registrationParamsSize, &errorInfo);
+      if (connectionHandle == nullptr) {
+        deferLogAPICall("RfcRegisterServer", __FILE__, BOOST_CURRENT_FUNCTION, __LINE__, errorInfo);
+
+        // Registering again is delayed, unless the server is stopped meanwhile
+        std::unique_lock<std::mutex> lock{mutex};
+        if (wakeup.wait_for(lock, delay, [this] { return stopping.load(); })) {
+          break;
+        }
+        delay = std::min(delay * 2, REGISTER_MAX_DELAY);
+        continue;
+      }
+      std::lock_guard<std::mutex> lock{mutex};
+      listener->registered = true;
+      listener->registrations++;
+      delay = REGISTER_INITIAL_DELAY;
+    }
+
+    if (!Reserve(listener)) {
+      break;
+    }
+    auto rc = RfcListenAndDispatch(connectionHandle, LISTEN_TIMEOUT, &errorInfo);
+    Unreserve(listener);
+
+    switch (rc) {
+      case RFC_OK:
+      case RFC_RETRY:
+      case RFC_ABAP_EXCEPTION:
+        // Call answered or no call within the timeout, the connection is still open
+        break;
+      default: {
+        // The SDK has closed the connection, e.g. after a system failure was reported or the gateway went away
+        deferLogAPICall("RfcListenAndDispatch", __FILE__, BOOST_CURRENT_FUNCTION, __LINE__, errorInfo);
+        RfcCloseConnection(connectionHandle, &errorInfo);
+        connectionHandle = nullptr;
+        std::lock_guard<std::mutex> lock{mutex};
+        listener->registered = false;
+        break;
+      }
+    }
+  }
+
+  if (connectionHandle != nullptr) {
+    RfcCloseConnection(connectionHandle, &errorInfo);
+  }
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    listener->registered = false;
+  }
+  Post(new Event{Event::STOPPED, listener, nullptr, RFC_ERROR_INFO{}});
+}
+
+/*
+ * With overload 'wait' a listener only listens while the queue has room for its call, so that calls wait at the
+ * gateway instead. Returns false if the server is stopped meanwhile.
+ */
+bool Server::Reserve(Listener *listener) {
+  if (rejectOnOverload) {
+    return !stopping;
+  }
+
+  std::unique_lock<std::mutex> lock{mutex};
+  wakeup.wait(lock, [this] { return stopping || queueDepth + reservedSlots < maxQueue; });
+  if (stopping) {
+    return false;
+  }
+  reservedSlots++;
+  listener->reserved = true;
+  return true;
+}
+
+/*
+ * Releases the slot of a listener which has received no call.
+ */
+void Server::Unreserve(Listener *listener) {
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    if (!listener->reserved) {
+      return;
+    }
+    listener->reserved = false;
+    reservedSlots--;
+  }
+  wakeup.notify_all();
+}
+
+RFC_RC SAP_API Server::Dispatch(RFC_CONNECTION_HANDLE, RFC_FUNCTION_HANDLE functionHandle,
+                                RFC_ERROR_INFO *errorInfo) {
+  auto listener = listening;
+  if (listener == nullptr) {
+    setFailure(errorInfo, RFC_EXTERNAL_FAILURE, EXTERNAL_RUNTIME_FAILURE, u"No server is listening on this thread");
+    return RFC_EXTERNAL_FAILURE;
+  }
+  return listener->server->Forward(listener, functionHandle, errorInfo);
+}
+
+RFC_RC Server::Forward(Listener *listener, RFC_FUNCTION_HANDLE functionHandle, RFC_ERROR_INFO *errorInfo) {
+  Call call{};
+  call.functionHandle = functionHandle;
+  call.errorInfo = errorInfo;
+  call.queued = Clock::now();
+
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    if (listener->reserved) {
+      listener->reserved = false;
+      reservedSlots--;
+    } else if (queueDepth >= maxQueue) {
+      listener->rejected++;
+      setFailure(errorInfo, RFC_EXTERNAL_FAILURE, EXTERNAL_RUNTIME_FAILURE, u"Server is overloaded");
+      return RFC_EXTERNAL_FAILURE;
+    }
+    queueDepth++;
+    peakQueueDepth = std::max(peakQueueDepth, queueDepth);
+    listener->busy = true;
+  }
+
+  RFC_ABAP_NAME functionName;
+  auto functionDescHandle = RfcDescribeFunction(functionHandle, errorInfo);
+  if (functionDescHandle != nullptr && RfcGetFunctionName(functionDescHandle, functionName, errorInfo) == RFC_OK) {
+    call.functionName = (const char16_t *) functionName;
+    if (!Post(new Event{Event::CALL, listener, &call, RFC_ERROR_INFO{}})) {
+      setFailure(errorInfo, RFC_EXTERNAL_FAILURE, EXTERNAL_RUNTIME_FAILURE, u"Server is shutting down");
+      call.rc = RFC_EXTERNAL_FAILURE;
+      call.completed = true;
+    }
+  } else {
+    call.rc = errorInfo->code;
+    call.completed = true;
+  }
+
+  {
+    std::unique_lock<std::mutex> lock{mutex};
+    completed.wait(lock, [this, &call] { return call.completed || aborted; });
+    if (!call.completed) {
+      setFailure(errorInfo, RFC_EXTERNAL_FAILURE, EXTERNAL_RUNTIME_FAILURE, u"Server is shutting down");
+      call.rc = RFC_EXTERNAL_FAILURE;
+    }
+
+    queueDepth--;
+    listener->busy = false;
+    if (call.started != Clock::time_point{}) {
+      auto latency = milliseconds(Clock::now() - call.queued);
+      listener->calls++;
+      listener->lastLatency = latency;
+      listener->totalLatency += latency;
+      listener->maxLatency = std::max(listener->maxLatency, latency);
+      listener->totalQueueTime += milliseconds(call.started - call.queued);
+    }
+  }
+
+  // There is room for a listener waiting in Reserve()
+  wakeup.notify_all();
+  return call.rc;
+}
+
+bool Server::Post(Event *event) {
+  auto status = napi_call_threadsafe_function(events, event, napi_tsfn_blocking);
+  if (status != napi_ok) {
+    // The environment is being torn down
+    delete event;
+    return false;
+  }
+  return true;
+}
+
+void Server::CallJs(napi_env env, napi_value, void *context, void *data) {
+  std::unique_ptr<Event> event{static_cast<Event *>(data)};
+  if (env == nullptr) {
+    return;
+  }
+
+  auto server = static_cast<Server *>(context);
+  Napi::Env napiEnv{env};
+  Napi::HandleScope scope{napiEnv};
+  try {
+    switch (event->kind) {
+      case Event::STARTED:
+        if (--server->startingListeners == 0 && server->startError.code == RFC_OK) {
+          server->log(napiEnv, Levels::VERBOSE, "Server is listening");
+          if (!server->startCallback.IsEmpty()) {
+            auto callback = std::move(server->startCallback);
+            callback.Call({});
+          }
+        }
+        break;
+      case Event::CALL:
+        server->Handle(napiEnv, event->call);
+        break;
+      case Event::STOPPED:
+        server->ListenerStopped(napiEnv, event->listener, event->errorInfo);
+        break;
+    }
+  } catch (const Napi::Error &e) {
+    napi_throw(env, e.Value());
+  }
+}
+
+void Server::Handle(Napi::Env env, Call *call) {
+  Napi::HandleScope scope{env};
+
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    call->started = Clock::now();
+  }
+
+  auto it = handlers.find(call->functionName);
+  if (it == handlers.end()) {
+    auto message = "No handler for function " + Napi::String::New(env, call->functionName).Utf8Value();
+    Fail(env, call, Napi::Error::New(env, message).Value());
+    return;
+  }
+  call->function = Napi::ObjectWrap<Function>::Unwrap(it->second.function.Value());
+
+  auto params = call->function->DoReceive(env, call->functionHandle);
+  if (IsException(env, params)) {
+    Fail(env, call, params);
+    return;
+  }
+
+  auto request = Napi::Object::New(env);
+  request.Set("functionName", Napi::String::New(env, call->functionName));
+
+  Napi::Value result;
+  try {
+    result = it->second.handler.Call({params, request});
+  } catch (const Napi::Error &e) {
+    Fail(env, call, e.Value());
+    return;
+  }
+
+  if (!result.IsPromise()) {
+    Complete(env, call, result);
+    return;
+  }
+
+  // The listener keeps waiting, so the call stays valid until the Promise has settled
+  auto onFulfilled = Napi::Function::New(env, [this, call](const Napi::CallbackInfo &info) {
+    Complete(info.Env(), call, info[0]);
+  });
+  auto onRejected = Napi::Function::New(env, [this, call](const Napi::CallbackInfo &info) {
+    Fail(info.Env(), call, info[0]);
+  });
+  auto promise = result.ToObject();
+  promise.Get("then").As<Napi::Function>().Call(promise, {onFulfilled, onRejected});
+}
+
+void Server::Complete(Napi::Env env, Call *call, Napi::Value result) {
+  Napi::HandleScope scope{env};
+
+  if (!result.IsUndefined() && !result.IsNull()) {
+    if (!result.IsObject()) {
+      Fail(env, call, Napi::TypeError::New(env, "Handler result must be an object").Value());
+      return;
+    }
+    auto written = call->function->SetParameters(env, result.ToObject(), call->functionHandle, true);
+    if (IsException(env, written)) {
+      Fail(env, call, written);
+      return;
+    }
+  }
+
+  Finish(call, RFC_OK);
+}
+
+void Server::Fail(Napi::Env env, Call *call, Napi::Value error) {
+  Napi::HandleScope scope{env};
+
+  auto message = error.IsObject() ? error.ToObject().Get("message").ToString() : error.ToString();
+  log(env, Levels::DBG, "Server::Fail: " + message.Utf8Value());
+
+  auto abapException = error.IsObject() ? error.ToObject().Get("abapException") : env.Undefined();
+  if (abapException.IsString()) {
+    setFailure(call->errorInfo, RFC_ABAP_EXCEPTION, ABAP_APPLICATION_FAILURE, message.Utf16Value());
+    copyToSAPUC(call->errorInfo->key, sizeof(call->errorInfo->key) / sizeof(SAP_UC),
+                abapException.ToString().Utf16Value());
+  } else {
+    setFailure(call->errorInfo, RFC_EXTERNAL_FAILURE, EXTERNAL_APPLICATION_FAILURE, message.Utf16Value());
+  }
+
+  Finish(call, call->errorInfo->code);
+}
+
+void Server::Finish(Call *call, RFC_RC rc) {
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    call->rc = rc;
+    call->completed = true;
+  }
+  completed.notify_all();
+}
+
+void Server::ListenerStopped(Napi::Env env, Listener *listener, const RFC_ERROR_INFO &errorInfo) {
+  // The listener has posted its last event
+  listener->thread.join();
+
+  // The first registration of the listener failed, the others are stopped as well
+  if (errorInfo.code != RFC_OK) {
+    startingListeners--;
+    if (startError.code == RFC_OK) {
+      startError = errorInfo;
+      {
+        std::lock_guard<std::mutex> lock{mutex};
+        stopping = true;
+      }
+      wakeup.notify_all();
+    }
+  }
+
+  if (--runningListeners == 0) {
+    Stopped(env);
+  }
+}
+
+void Server::Stopped(Napi::Env env) {
+  napi_release_threadsafe_function(events, napi_tsfn_release);
+  events = nullptr;
+  napi_remove_env_cleanup_hook(env, Cleanup, this);
+  running = false;
+  stopping = false;
+
+  log(env, Levels::VERBOSE, "Server has stopped");
+
+  auto startCallback = std::move(this->startCallback);
+  auto stopCallback = std::move(this->stopCallback);
+  auto startError = this->startError;
+  Reference::Unref();
+
+  if (startError.code != RFC_OK) {
+    log(env, Levels::DBG, "Server::Stopped: RfcRegisterServer finished with error");
+    if (!startCallback.IsEmpty()) {
+      startCallback.Call({RfcError(env, startError).Value()});
+    }
+  }
+  if (!stopCallback.IsEmpty()) {
+    stopCallback.Call({});
+  }
+}
+
+/*
+ * Called when the environment is torn down while the server is running. Waiting calls are answered with a system
+ * failure, then the listeners are joined.
+ */
+void Server::Cleanup(void *arg) {
+  auto server = static_cast<Server *>(arg);
+
+  napi_release_threadsafe_function(server->events, napi_tsfn_abort);
+  {
+    std::lock_guard<std::mutex> lock{server->mutex};
+    server->stopping = true;
+    server->aborted = true;
+  }
+  server->completed.notify_all();
+  server->wakeup.notify_all();
+  for (auto &listener : server->listeners) {
+    if (listener->thread.joinable()) {
+      listener->thread.join();
+    }
+  }
+  server->events = nullptr;
+  server->running = false;
+}
+
+void Server::addObjectInfoToLogMeta(Napi::Object meta) {
+  char ptr[2 + sizeof(void *) * 2 + 1]; // optional "0x" + each byte of pointer represented by 2 digits + terminator
+  snprintf(ptr, 2 + sizeof(void *) * 2 + 1, "%p", this);
+  meta.Set("nativeServer", ptr);
+}
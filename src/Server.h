@@ -0,0 +1,185 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#ifndef SAPNWRFC_SERVER_H
+#define SAPNWRFC_SERVER_H
+
+#include "Loggable.h"
+#include <sapnwrfc.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class Function;
+
+/*
+ * RFC server registered at an SAP gateway, so that ABAP can call function modules implemented in JavaScript:
+ *
+ *   new Server(registrationParams[, { listeners, maxQueue, overload }])
+ *   AddFunction(func, handler): handler(params, request) returns the exporting parameters or a Promise of them
+ *   Start([callback]), Stop([callback]), Stats()
+ *
+ * The function modules are described by Function objects, e.g. from Connection.Lookup() or Connection.Define().
+ *
+ * Each of the listener threads registers the server once and blocks in RfcListenAndDispatch(), so the gateway can
+ * pass as many calls at a time as there are listeners. Incoming calls are queued to the main thread through a
+ * threadsafe function and decoded with the converters of Function::DoReceive(); the listener waits until the
+ * handler has settled and the result has been written back with Function::SetValue(). When the gateway connection
+ * of a listener is lost, it registers again.
+ *
+ * At most maxQueue calls are queued or handled in JavaScript. If the queue is full, listeners either stop
+ * listening until there is room again, so that further calls wait at the gateway (overload 'wait'), or answer
+ * calls at once with a system failure (overload 'reject').
+ */
+class Server : public Loggable, public Napi::ObjectWrap<Server> {
+  public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+
+    explicit Server(const Napi::CallbackInfo &info);
+    ~Server();
+
+    RFC_ERROR_INFO errorInfo{};
+
+  protected:
+    Napi::Value AddFunction(const Napi::CallbackInfo &info);
+    Napi::Value Start(const Napi::CallbackInfo &info);
+    Napi::Value Stop(const Napi::CallbackInfo &info);
+    Napi::Value IsRunning(const Napi::CallbackInfo &info);
+    Napi::Value Stats(const Napi::CallbackInfo &info);
+
+    void addObjectInfoToLogMeta(Napi::Object meta) override;
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    // Listener thread and its statistics, which are guarded by the server's mutex
+    struct Listener {
+      Server *server{};
+      std::thread thread;
+
+      bool registered{};
+      bool reserved{};
+      bool busy{};
+      uint64_t registrations{};
+      uint64_t calls{};
+      uint64_t rejected{};
+      double lastLatency{};
+      double totalLatency{};
+      double maxLatency{};
+      double totalQueueTime{};
+    };
+
+    // Incoming call, owned by the listener thread which waits until it is completed
+    struct Call {
+      RFC_FUNCTION_HANDLE functionHandle{};
+      std::u16string functionName;
+      RFC_ERROR_INFO *errorInfo{};
+      Function *function{};
+      RFC_RC rc{RFC_OK};
+      bool completed{};
+      Clock::time_point queued;
+      Clock::time_point started;
+    };
+
+    // Posted by a listener thread to the main thread
+    struct Event {
+      enum Kind { STARTED, CALL, STOPPED };
+
+      Kind kind;
+      Listener *listener;
+      Call *call;
+      RFC_ERROR_INFO errorInfo;
+    };
+
+    struct Handler {
+      Napi::ObjectReference function;
+      Napi::FunctionReference handler;
+    };
+
+    /*
+     * Server function installed for all handlers, called by the SDK on a listener thread.
+     */
+    static RFC_RC SAP_API Dispatch(RFC_CONNECTION_HANDLE connectionHandle, RFC_FUNCTION_HANDLE functionHandle,
+                                   RFC_ERROR_INFO *errorInfo);
+    static void CallJs(napi_env env, napi_value, void *context, void *data);
+    static void Cleanup(void *arg);
+
+    /*
+     * The following run on the listener threads.
+     */
+    void Listen(Listener *listener);
+    bool Reserve(Listener *listener);
+    void Unreserve(Listener *listener);
+    RFC_RC Forward(Listener *listener, RFC_FUNCTION_HANDLE functionHandle, RFC_ERROR_INFO *errorInfo);
+    bool Post(Event *event);
+
+    /*
+     * The following run on the main thread.
+     */
+    void Handle(Napi::Env env, Call *call);
+    void Complete(Napi::Env env, Call *call, Napi::Value result);
+    void Fail(Napi::Env env, Call *call, Napi::Value error);
+    void Finish(Call *call, RFC_RC rc);
+    void ListenerStopped(Napi::Env env, Listener *listener, const RFC_ERROR_INFO &errorInfo);
+    void Stopped(Napi::Env env);
+
+    static thread_local Listener *listening;
+
+    unsigned int registrationParamsSize{};
+    RFC_CONNECTION_PARAMETER *registrationParams{};
+    std::unordered_map<std::u16string, Handler> handlers;
+
+    uint32_t listenerCount{1};
+    uint32_t maxQueue{};
+    bool rejectOnOverload{};
+
+    Napi::FunctionReference startCallback;
+    Napi::FunctionReference stopCallback;
+    napi_threadsafe_function events{};
+    std::vector<std::unique_ptr<Listener> > listeners;
+    uint32_t runningListeners{};
+    uint32_t startingListeners{};
+    RFC_ERROR_INFO startError{};
+    bool running{};
+
+    std::atomic<bool> stopping{false};
+    std::mutex mutex;
+    std::condition_variable completed;
+    std::condition_variable wakeup;
+    bool aborted{};
+
+    // Guarded by the mutex, reserved slots belong to listeners waiting for a call
+    uint32_t queueDepth{};
+    uint32_t reservedSlots{};
+    uint32_t peakQueueDepth{};
+};
+
+#endif //SAPNWRFC_SERVER_H
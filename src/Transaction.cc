@@ -0,0 +1,232 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#include "Transaction.h"
+#include "AddonData.h"
+#include "Function.h"
+#include "TransactionSubmit.h"
+#include "Utils.h"
+#include <cassert>
+
+// Length of the queue names of qRFC
+static const size_t MAX_QUEUE_NAME = 24;
+
+static std::string stringify(Napi::Env env, Napi::Value value) {
+  auto json = env.Global().Get("JSON").As<Napi::Object>();
+  return json.Get("stringify").As<Napi::Function>().Call(json, {value}).ToString().Utf8Value();
+}
+
+Transaction::Transaction(const Napi::CallbackInfo &info)
+    : Napi::ObjectWrap<Transaction>(info) {
+  init(Value());
+  log(info.Env(), Levels::SILLY, "Transaction::Transaction");
+}
+
+Transaction::~Transaction() {
+  deferLog(Levels::SILLY, "Transaction::~Transaction");
+  DestroyCalls();
+}
+
+Napi::Object Transaction::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "Transaction", {
+      InstanceMethod("Add", &Transaction::Add),
+      InstanceMethod("Submit", &Transaction::Submit),
+      InstanceMethod("Id", &Transaction::Id)
+  });
+
+  AddonData::Get(env).transactionCtor = Napi::Persistent(func);
+  exports.Set("Transaction", func);
+  return exports;
+}
+
+/**
+ * Options: queue (qRFC queue name), tid (TID of a transaction to retry) and store (directory of the TID store).
+ */
+Napi::Value Transaction::NewInstance(Napi::Env env, Connection &connection, Napi::Value options) {
+  Napi::EscapableHandleScope scope{env};
+
+  auto obj = AddonData::Get(env).transactionCtor.New({});
+  Transaction *self = Napi::ObjectWrap<Transaction>::Unwrap(obj);
+  assert(self != nullptr);
+
+  self->connection = &connection;
+  self->connectionRef = Napi::Persistent(connection.Value());
+
+  if (options.IsObject()) {
+    auto queue = options.ToObject().Get("queue");
+    if (!queue.IsUndefined()) {
+      if (!queue.IsString() || queue.ToString().Utf16Value().empty() ||
+          queue.ToString().Utf16Value().size() > MAX_QUEUE_NAME) {
+        throw Napi::TypeError::New(env, "Option queue must be a string of 1 to 24 characters");
+      }
+      self->queueName = queue.ToString().Utf16Value();
+      self->queueJson = stringify(env, queue);
+    }
+
+    auto tid = options.ToObject().Get("tid");
+    if (!tid.IsUndefined()) {
+      if (!tid.IsString() || tid.ToString().Utf16Value().size() != sizeof(RFC_TID) / sizeof(SAP_UC) - 1) {
+        throw Napi::TypeError::New(env, "Option tid must be a string of 24 characters");
+      }
+      self->tid = tid.ToString().Utf16Value();
+    }
+
+    auto store = options.ToObject().Get("store");
+    if (!store.IsUndefined()) {
+      if (!store.IsString()) {
+        throw Napi::TypeError::New(env, "Option store must be a string");
+      }
+      self->hasStore = true;
+      self->store = ToNativePath(store.ToString());
+    }
+  }
+
+  self->log(env, Levels::SILLY, "Transaction::NewInstance");
+  return scope.Escape(obj);
+}
+
+/**
+ * Add(func, params): marshals the input parameters of a call to func, which must belong to the same connection.
+ */
+Napi::Value Transaction::Add(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::HandleScope scope{env};
+
+  log(env, Levels::SILLY, "Transaction::Add");
+
+  if (info.Length() < 1 || info.Length() > 2) {
+    throw Napi::Error::New(env, "Function expects 1 or 2 arguments");
+  }
+  if (!info[0].IsObject() || !info[0].ToObject().InstanceOf(AddonData::Get(env).functionCtor.Value())) {
+    throw Napi::TypeError::New(env, "Argument 1 must be a Function");
+  }
+  if (info.Length() > 1 && !info[1].IsUndefined() && !info[1].IsObject()) {
+    throw Napi::TypeError::New(env, "Argument 2 must be an object");
+  }
+  if (submitting || submitted) {
+    throw Napi::Error::New(env, "Transaction has already been submitted");
+  }
+
+  auto function = Napi::ObjectWrap<Function>::Unwrap(info[0].ToObject());
+  if (function->connection != connection) {
+    throw Napi::TypeError::New(env, "Function belongs to another connection");
+  }
+  auto inputParam = info.Length() > 1 && info[1].IsObject() ? info[1].ToObject() : Napi::Object::New(env);
+
+  RFC_FUNCTION_HANDLE functionHandle{};
+  auto prepared = function->PrepareInvocation(env, inputParam, functionHandle);
+  if (IsException(env, prepared)) {
+    throw Napi::Error(env, prepared);
+  }
+  calls.push_back(Call{function, Napi::Persistent(info[0].ToObject()), functionHandle});
+
+  if (hasStore) {
+    if (!callsJson.empty()) {
+      callsJson += ',';
+    }
+    callsJson += "{\"name\":" + stringify(env, Napi::String::New(env, function->functionName)) +
+                 ",\"params\":" + stringify(env, inputParam) + "}";
+  }
+  return env.Undefined();
+}
+
+/**
+ * Submit([callback]): sends the calls, callback(err, { tid, confirmed }) or a Promise if no callback is given.
+ */
+Napi::Value Transaction::Submit(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+
+  log(env, Levels::SILLY, "Transaction::Submit");
+
+  if (info.Length() > 0 && !info[0].IsUndefined() && !info[0].IsFunction()) {
+    throw Napi::TypeError::New(env, "Argument 1 must be a function");
+  }
+  if (submitting) {
+    throw Napi::Error::New(env, "Transaction is being submitted");
+  }
+  if (submitted) {
+    throw Napi::Error::New(env, "Transaction has already been submitted");
+  }
+  if (calls.empty()) {
+    throw Napi::Error::New(env, "Transaction has no calls");
+  }
+
+  // The transaction stays alive until the submission has finished
+  submitting = true;
+  Reference::Ref();
+
+  auto worker = new TransactionSubmit{env, info.Length() > 0 ? info[0] : env.Undefined(), this};
+  auto promise = worker->Promise();
+  worker->Queue();
+  return scope.Escape(promise);
+}
+
+/**
+ * @return TID of the transaction, null until it has been submitted for the first time
+ */
+Napi::Value Transaction::Id(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  if (tid.empty() || submitting) {
+    return env.Null();
+  }
+  return Napi::String::New(env, tid);
+}
+
+void Transaction::Submitted(bool succeeded) {
+  submitting = false;
+  if (succeeded) {
+    submitted = true;
+    DestroyCalls();
+  }
+  Reference::Unref();
+}
+
+void Transaction::DestroyCalls() {
+  for (auto &call : calls) {
+    RFC_ERROR_INFO destroyErrorInfo{};
+    RfcDestroyFunction(call.functionHandle, &destroyErrorInfo);
+  }
+  calls.clear();
+}
+
+bool Transaction::WriteStoreEntry() {
+  std::string name{tid.begin(), tid.end()};
+  return WriteFileAtomically(JoinPath(store, name + ".json"),
+                             "{\"tid\":\"" + name + "\",\"queue\":" + queueJson + ",\"calls\":[" + callsJson + "]}");
+}
+
+void Transaction::RemoveStoreEntry() {
+  std::string name{tid.begin(), tid.end()};
+  if (!RemoveFile(JoinPath(store, name + ".json"))) {
+    deferLog(Levels::WARN, "Transaction: Cannot remove TID store entry " + name);
+  }
+}
+
+void Transaction::addObjectInfoToLogMeta(Napi::Object meta) {
+  if (connection) {
+    connection->addObjectInfoToLogMeta(meta);
+  }
+}
@@ -0,0 +1,100 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#ifndef SAPNWRFC_TRANSACTION_H
+#define SAPNWRFC_TRANSACTION_H
+
+#include "Loggable.h"
+#include <sapnwrfc.h>
+#include <string>
+#include <vector>
+#include "Connection.h"
+#include "FileSystem.h"
+
+class Function;
+
+/*
+ * Transactional RFC (tRFC) call, or queued RFC (qRFC) if a queue name is given, created by
+ * Connection.Transaction([{ queue, tid, store }]). Any number of function calls are added with Add() and sent in
+ * a single round trip by Submit(), which the backend executes exactly once per transaction ID (TID).
+ *
+ * If Submit() fails, the transaction keeps its TID and can be submitted again. With a store directory, every
+ * transaction is recorded as <TID>.json before it is sent and removed once the backend has executed it, so that
+ * transactions of a process which exited meanwhile can be found and retried under their TID.
+ */
+class Transaction : public Loggable, public Napi::ObjectWrap<Transaction> {
+    friend class TransactionSubmit;
+
+  public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    static Napi::Value NewInstance(Napi::Env env, Connection &connection, Napi::Value options);
+
+    explicit Transaction(const Napi::CallbackInfo &info);
+    ~Transaction();
+
+    RFC_ERROR_INFO errorInfo{};
+
+  protected:
+    Napi::Value Add(const Napi::CallbackInfo &info);
+    Napi::Value Submit(const Napi::CallbackInfo &info);
+    Napi::Value Id(const Napi::CallbackInfo &info);
+
+    /*
+     * Called on the main thread when a submission has finished.
+     */
+    void Submitted(bool succeeded);
+    void DestroyCalls();
+
+    /*
+     * The following are called on the executor thread.
+     */
+    bool WriteStoreEntry();
+    void RemoveStoreEntry();
+
+    void addObjectInfoToLogMeta(Napi::Object meta) override;
+
+    struct Call {
+      Function *function;
+      Napi::ObjectReference functionRef;
+      RFC_FUNCTION_HANDLE functionHandle;
+    };
+
+    Connection *connection{};
+    Napi::ObjectReference connectionRef;
+    std::vector<Call> calls;
+    std::u16string queueName;
+    std::u16string tid;
+
+    bool hasStore{};
+    NativePath store;
+    // JSON of the queue name and the calls, written to the store entry
+    std::string queueJson{"null"};
+    std::string callsJson;
+
+    bool submitting{};
+    bool submitted{};
+};
+
+#endif //SAPNWRFC_TRANSACTION_H
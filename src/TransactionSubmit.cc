@@ -0,0 +1,136 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#include "TransactionSubmit.h"
+#include "Utils.h"
+#include <cerrno>
+#include <cstring>
+
+TransactionSubmit::TransactionSubmit(Napi::Env env, const Napi::Value &callback, Transaction *transaction)
+    : ConnectionWorker{env, callback, transaction->connection}, transaction{transaction} {}
+
+void TransactionSubmit::Execute() {
+  connection->LockMutex();
+
+  if (connection->reconnect.enabled && !connection->IsHandleValid() && !connection->Reopen(errorInfo)) {
+    connection->UnlockMutex();
+    SetError("Transaction::Submit: Reopening the connection failed");
+    return;
+  }
+  auto connectionHandle = connection->GetConnectionHandle();
+
+  // A transaction submitted again keeps its TID, so that the backend executes it at most once
+  RFC_TID tid{};
+  if (transaction->tid.empty()) {
+    RfcGetTransactionID(connectionHandle, tid, &errorInfo);
+    connection->deferLogAPICall("RfcGetTransactionID", __FILE__, BOOST_CURRENT_FUNCTION, __LINE__, errorInfo);
+    if (errorInfo.code != RFC_OK) {
+      connection->UnlockMutex();
+      SetError("Transaction::Submit: RfcGetTransactionID failed");
+      return;
+    }
+    transaction->tid = (const char16_t *) tid;
+  } else {
+    std::copy(transaction->tid.begin(), transaction->tid.end(), tid);
+  }
+
+  // Recorded before anything is sent, so that the transaction can be retried after a crash
+  if (transaction->hasStore && !transaction->WriteStoreEntry()) {
+    connection->UnlockMutex();
+    storeError = std::string("Cannot write TID store entry: ") + strerror(errno);
+    SetError(storeError);
+    return;
+  }
+
+  auto transactionHandle = RfcCreateTransaction(connectionHandle, tid,
+                                                transaction->queueName.empty() ? nullptr
+                                                    : (const SAP_UC *) transaction->queueName.c_str(),
+                                                &errorInfo);
+  connection->deferLogAPICall("RfcCreateTransaction", __FILE__, BOOST_CURRENT_FUNCTION, __LINE__, errorInfo);
+
+  if (transactionHandle != nullptr) {
+    for (auto &call : transaction->calls) {
+      RfcInvokeInTransaction(transactionHandle, call.functionHandle, &errorInfo);
+      if (errorInfo.code != RFC_OK) {
+        connection->deferLogAPICall("RfcInvokeInTransaction", __FILE__, BOOST_CURRENT_FUNCTION, __LINE__,
+                                    errorInfo);
+        break;
+      }
+    }
+
+    if (errorInfo.code == RFC_OK) {
+      RfcSubmitTransaction(transactionHandle, &errorInfo);
+      connection->deferLogAPICall("RfcSubmitTransaction", __FILE__, BOOST_CURRENT_FUNCTION, __LINE__, errorInfo);
+    }
+
+    if (errorInfo.code == RFC_OK) {
+      // Executed by the backend, a retry is no longer needed. Unconfirmed TIDs are cleaned up by the backend later.
+      if (transaction->hasStore) {
+        transaction->RemoveStoreEntry();
+      }
+      RFC_ERROR_INFO confirmErrorInfo{};
+      confirmed = RfcConfirmTransaction(transactionHandle, &confirmErrorInfo) == RFC_OK;
+      connection->deferLogAPICall("RfcConfirmTransaction", __FILE__, BOOST_CURRENT_FUNCTION, __LINE__,
+                                  confirmErrorInfo);
+    }
+
+    RFC_ERROR_INFO destroyErrorInfo{};
+    RfcDestroyTransaction(transactionHandle, &destroyErrorInfo);
+  }
+
+  connection->UnlockMutex();
+
+  if (errorInfo.code != RFC_OK) {
+    SetError("Transaction::Submit: Submitting the transaction failed");
+  }
+}
+
+void TransactionSubmit::OnOK() {
+  transaction->Submitted(true);
+  ConnectionWorker::OnOK();
+}
+
+void TransactionSubmit::OnError(const Napi::Error &) {
+  auto env = Env();
+  Napi::HandleScope scope{env};
+  connection->logDeferred(env);
+  transaction->Submitted(false);
+
+  auto error = storeError.empty() ? RfcError(env, errorInfo) : Napi::Error::New(env, storeError);
+  if (!transaction->tid.empty()) {
+    error.Set("tid", Napi::String::New(env, transaction->tid));
+  }
+  Reject(error.Value());
+}
+
+Napi::Value TransactionSubmit::Result() {
+  auto env = Env();
+  Napi::EscapableHandleScope scope{env};
+
+  auto result = Napi::Object::New(env);
+  result.Set("tid", Napi::String::New(env, transaction->tid));
+  result.Set("confirmed", Napi::Boolean::New(env, confirmed));
+  return scope.Escape(result);
+}
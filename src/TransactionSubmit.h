@@ -0,0 +1,52 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#ifndef SAPNWRFC_TRANSACTIONSUBMIT_H
+#define SAPNWRFC_TRANSACTIONSUBMIT_H
+
+#include "ConnectionWorker.h"
+#include "Transaction.h"
+
+/*
+ * Sends the calls of a Transaction with RfcCreateTransaction(), RfcInvokeInTransaction() and
+ * RfcSubmitTransaction(), then confirms it. Resolves with { tid, confirmed }, errors carry the TID to retry with.
+ */
+class TransactionSubmit : public ConnectionWorker {
+  public:
+    TransactionSubmit(Napi::Env env, const Napi::Value &callback, Transaction *transaction);
+
+  protected:
+    void Execute() override;
+    void OnOK() override;
+    void OnError(const Napi::Error &e) override;
+    Napi::Value Result() override;
+
+  private:
+    Transaction *transaction;
+    std::string storeError;
+    bool confirmed{};
+};
+
+#endif //SAPNWRFC_TRANSACTIONSUBMIT_H
@@ -0,0 +1,207 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#include "Unit.h"
+#include "AddonData.h"
+#include "Function.h"
+#include "UnitSubmit.h"
+#include "Utils.h"
+#include <cassert>
+
+// Length of unit IDs, without the terminator
+static const size_t UNIT_ID_LENGTH = sizeof(RFC_UNITID) / sizeof(SAP_UC) - 1;
+
+Unit::Unit(const Napi::CallbackInfo &info)
+    : Napi::ObjectWrap<Unit>(info) {
+  init(Value());
+  log(info.Env(), Levels::SILLY, "Unit::Unit");
+}
+
+Unit::~Unit() {
+  deferLog(Levels::SILLY, "Unit::~Unit");
+  DestroyCalls();
+}
+
+Napi::Object Unit::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "Unit", {
+      InstanceMethod("Add", &Unit::Add),
+      InstanceMethod("Submit", &Unit::Submit),
+      InstanceMethod("Id", &Unit::Id)
+  });
+
+  AddonData::Get(env).unitCtor = Napi::Persistent(func);
+  exports.Set("Unit", func);
+  return exports;
+}
+
+/**
+ * Options: queues (names of bgRFC inbound queues, none for a transactional unit), unitId (ID of a unit to retry)
+ * and history (keep the unit history in the backend).
+ */
+Napi::Value Unit::NewInstance(Napi::Env env, Connection &connection, Napi::Value options) {
+  Napi::EscapableHandleScope scope{env};
+
+  auto obj = AddonData::Get(env).unitCtor.New({});
+  Unit *self = Napi::ObjectWrap<Unit>::Unwrap(obj);
+  assert(self != nullptr);
+
+  self->connection = &connection;
+  self->connectionRef = Napi::Persistent(connection.Value());
+
+  if (options.IsObject()) {
+    auto queues = options.ToObject().Get("queues");
+    if (!queues.IsUndefined()) {
+      if (!queues.IsArray()) {
+        throw Napi::TypeError::New(env, "Option queues must be an array of queue names");
+      }
+      auto names = queues.As<Napi::Array>();
+      for (uint32_t i = 0; i < names.Length(); i++) {
+        auto name = names.Get(i);
+        if (!name.IsString() || name.ToString().Utf16Value().empty()) {
+          throw Napi::TypeError::New(env, "Option queues must be an array of queue names");
+        }
+        self->queueNames.push_back(name.ToString().Utf16Value());
+      }
+    }
+
+    auto unitId = options.ToObject().Get("unitId");
+    if (!unitId.IsUndefined()) {
+      if (!unitId.IsString() || unitId.ToString().Utf16Value().size() != UNIT_ID_LENGTH) {
+        throw Napi::TypeError::New(env, "Option unitId must be a string of 32 characters");
+      }
+      auto id = unitId.ToString().Utf16Value();
+      std::copy(id.begin(), id.end(), self->identifier.unitID);
+    }
+
+    self->attributes.unitHistory = options.ToObject().Get("history").ToBoolean() ? 1 : 0;
+  }
+
+  self->log(env, Levels::SILLY, "Unit::NewInstance");
+  return scope.Escape(obj);
+}
+
+/**
+ * Add(func, params): marshals the input parameters of a call to func, which must belong to the same connection.
+ */
+Napi::Value Unit::Add(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::HandleScope scope{env};
+
+  log(env, Levels::SILLY, "Unit::Add");
+
+  if (info.Length() < 1 || info.Length() > 2) {
+    throw Napi::Error::New(env, "Function expects 1 or 2 arguments");
+  }
+  if (!info[0].IsObject() || !info[0].ToObject().InstanceOf(AddonData::Get(env).functionCtor.Value())) {
+    throw Napi::TypeError::New(env, "Argument 1 must be a Function");
+  }
+  if (info.Length() > 1 && !info[1].IsUndefined() && !info[1].IsObject()) {
+    throw Napi::TypeError::New(env, "Argument 2 must be an object");
+  }
+  if (submitting || submitted) {
+    throw Napi::Error::New(env, "Unit has already been submitted");
+  }
+
+  auto function = Napi::ObjectWrap<Function>::Unwrap(info[0].ToObject());
+  if (function->connection != connection) {
+    throw Napi::TypeError::New(env, "Function belongs to another connection");
+  }
+  auto inputParam = info.Length() > 1 && info[1].IsObject() ? info[1].ToObject() : Napi::Object::New(env);
+
+  RFC_FUNCTION_HANDLE functionHandle{};
+  auto prepared = function->PrepareInvocation(env, inputParam, functionHandle);
+  if (IsException(env, prepared)) {
+    throw Napi::Error(env, prepared);
+  }
+  calls.push_back(Call{function, Napi::Persistent(info[0].ToObject()), functionHandle});
+  return env.Undefined();
+}
+
+/**
+ * Submit([callback]): sends the calls, callback(err, { unitId, unitType, confirmed }) or a Promise if no callback
+ * is given.
+ */
+Napi::Value Unit::Submit(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  Napi::EscapableHandleScope scope{env};
+
+  log(env, Levels::SILLY, "Unit::Submit");
+
+  if (info.Length() > 0 && !info[0].IsUndefined() && !info[0].IsFunction()) {
+    throw Napi::TypeError::New(env, "Argument 1 must be a function");
+  }
+  if (submitting) {
+    throw Napi::Error::New(env, "Unit is being submitted");
+  }
+  if (submitted) {
+    throw Napi::Error::New(env, "Unit has already been submitted");
+  }
+  if (calls.empty()) {
+    throw Napi::Error::New(env, "Unit has no calls");
+  }
+
+  // The unit stays alive until the submission has finished
+  submitting = true;
+  Reference::Ref();
+
+  auto worker = new UnitSubmit{env, info.Length() > 0 ? info[0] : env.Undefined(), this};
+  auto promise = worker->Promise();
+  worker->Queue();
+  return scope.Escape(promise);
+}
+
+/**
+ * @return unit ID, null until the unit has been submitted for the first time
+ */
+Napi::Value Unit::Id(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  if (identifier.unitID[0] == 0 || submitting) {
+    return env.Null();
+  }
+  return Napi::String::New(env, (const char16_t *) identifier.unitID);
+}
+
+void Unit::Submitted(bool succeeded) {
+  submitting = false;
+  if (succeeded) {
+    submitted = true;
+    DestroyCalls();
+  }
+  Reference::Unref();
+}
+
+void Unit::DestroyCalls() {
+  for (auto &call : calls) {
+    RFC_ERROR_INFO destroyErrorInfo{};
+    RfcDestroyFunction(call.functionHandle, &destroyErrorInfo);
+  }
+  calls.clear();
+}
+
+void Unit::addObjectInfoToLogMeta(Napi::Object meta) {
+  if (connection) {
+    connection->addObjectInfoToLogMeta(meta);
+  }
+}
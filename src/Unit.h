@@ -0,0 +1,86 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#ifndef SAPNWRFC_UNIT_H
+#define SAPNWRFC_UNIT_H
+
+#include "Loggable.h"
+#include <sapnwrfc.h>
+#include <string>
+#include <vector>
+#include "Connection.h"
+
+class Function;
+
+/*
+ * Background RFC (bgRFC) unit, created by Connection.Unit([{ queues, unitId, history }]). Like a Transaction it
+ * collects any number of calls with Add() and sends them in one round trip with Submit(), but is processed by the
+ * bgRFC scheduler of the backend: as transactional unit, or in the order of the given inbound queues.
+ *
+ * A unit which failed keeps its unit ID and can be submitted again, the backend executes it at most once.
+ */
+class Unit : public Loggable, public Napi::ObjectWrap<Unit> {
+    friend class UnitSubmit;
+
+  public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    static Napi::Value NewInstance(Napi::Env env, Connection &connection, Napi::Value options);
+
+    explicit Unit(const Napi::CallbackInfo &info);
+    ~Unit();
+
+    RFC_ERROR_INFO errorInfo{};
+
+  protected:
+    Napi::Value Add(const Napi::CallbackInfo &info);
+    Napi::Value Submit(const Napi::CallbackInfo &info);
+    Napi::Value Id(const Napi::CallbackInfo &info);
+
+    /*
+     * Called on the main thread when a submission has finished.
+     */
+    void Submitted(bool succeeded);
+    void DestroyCalls();
+
+    void addObjectInfoToLogMeta(Napi::Object meta) override;
+
+    struct Call {
+      Function *function;
+      Napi::ObjectReference functionRef;
+      RFC_FUNCTION_HANDLE functionHandle;
+    };
+
+    Connection *connection{};
+    Napi::ObjectReference connectionRef;
+    std::vector<Call> calls;
+    std::vector<std::u16string> queueNames;
+    RFC_UNIT_ATTRIBUTES attributes{};
+    RFC_UNIT_IDENTIFIER identifier{};
+
+    bool submitting{};
+    bool submitted{};
+};
+
+#endif //SAPNWRFC_UNIT_H
@@ -0,0 +1,123 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#include "UnitSubmit.h"
+#include "Utils.h"
+
+UnitSubmit::UnitSubmit(Napi::Env env, const Napi::Value &callback, Unit *unit)
+    : ConnectionWorker{env, callback, unit->connection}, unit{unit} {}
+
+void UnitSubmit::Execute() {
+  connection->LockMutex();
+
+  if (connection->reconnect.enabled && !connection->IsHandleValid() && !connection->Reopen(errorInfo)) {
+    connection->UnlockMutex();
+    SetError("Unit::Submit: Reopening the connection failed");
+    return;
+  }
+  auto connectionHandle = connection->GetConnectionHandle();
+
+  // A unit submitted again keeps its ID, so that the backend executes it at most once
+  if (unit->identifier.unitID[0] == 0) {
+    RfcGetUnitID(connectionHandle, unit->identifier.unitID, &errorInfo);
+    connection->deferLogAPICall("RfcGetUnitID", __FILE__, BOOST_CURRENT_FUNCTION, __LINE__, errorInfo);
+    if (errorInfo.code != RFC_OK) {
+      connection->UnlockMutex();
+      SetError("Unit::Submit: RfcGetUnitID failed");
+      return;
+    }
+  }
+
+  std::vector<const SAP_UC *> queueNames;
+  for (const auto &name : unit->queueNames) {
+    queueNames.push_back((const SAP_UC *) name.c_str());
+  }
+
+  auto unitHandle = RfcCreateUnit(connectionHandle, unit->identifier.unitID,
+                                  queueNames.empty() ? nullptr : queueNames.data(),
+                                  static_cast<unsigned>(queueNames.size()), &unit->attributes, &unit->identifier,
+                                  &errorInfo);
+  connection->deferLogAPICall("RfcCreateUnit", __FILE__, BOOST_CURRENT_FUNCTION, __LINE__, errorInfo);
+
+  if (unitHandle != nullptr) {
+    for (auto &call : unit->calls) {
+      RfcInvokeInUnit(unitHandle, call.functionHandle, &errorInfo);
+      if (errorInfo.code != RFC_OK) {
+        connection->deferLogAPICall("RfcInvokeInUnit", __FILE__, BOOST_CURRENT_FUNCTION, __LINE__, errorInfo);
+        break;
+      }
+    }
+
+    if (errorInfo.code == RFC_OK) {
+      RfcSubmitUnit(unitHandle, &errorInfo);
+      connection->deferLogAPICall("RfcSubmitUnit", __FILE__, BOOST_CURRENT_FUNCTION, __LINE__, errorInfo);
+    }
+
+    if (errorInfo.code == RFC_OK) {
+      // The unit has been persisted by the backend, an unconfirmed one is cleaned up by the backend later
+      RFC_ERROR_INFO confirmErrorInfo{};
+      confirmed = RfcConfirmUnit(connectionHandle, &unit->identifier, &confirmErrorInfo) == RFC_OK;
+      connection->deferLogAPICall("RfcConfirmUnit", __FILE__, BOOST_CURRENT_FUNCTION, __LINE__, confirmErrorInfo);
+    }
+
+    RFC_ERROR_INFO destroyErrorInfo{};
+    RfcDestroyUnit(unitHandle, &destroyErrorInfo);
+  }
+
+  connection->UnlockMutex();
+
+  if (errorInfo.code != RFC_OK) {
+    SetError("Unit::Submit: Submitting the unit failed");
+  }
+}
+
+void UnitSubmit::OnOK() {
+  unit->Submitted(true);
+  ConnectionWorker::OnOK();
+}
+
+void UnitSubmit::OnError(const Napi::Error &) {
+  auto env = Env();
+  Napi::HandleScope scope{env};
+  connection->logDeferred(env);
+  unit->Submitted(false);
+
+  auto error = RfcError(env, errorInfo);
+  if (unit->identifier.unitID[0] != 0) {
+    error.Set("unitId", Napi::String::New(env, (const char16_t *) unit->identifier.unitID));
+  }
+  Reject(error.Value());
+}
+
+Napi::Value UnitSubmit::Result() {
+  auto env = Env();
+  Napi::EscapableHandleScope scope{env};
+
+  auto result = Napi::Object::New(env);
+  result.Set("unitId", Napi::String::New(env, (const char16_t *) unit->identifier.unitID));
+  result.Set("unitType", Napi::String::New(env, std::u16string(1, static_cast<char16_t>(unit->identifier.unitType))));
+  result.Set("confirmed", Napi::Boolean::New(env, confirmed));
+  return scope.Escape(result);
+}
@@ -0,0 +1,51 @@
+/*
+-----------------------------------------------------------------------------
+Copyright (c) 2019 Scheer E2E AG
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#ifndef SAPNWRFC_UNITSUBMIT_H
+#define SAPNWRFC_UNITSUBMIT_H
+
+#include "ConnectionWorker.h"
+#include "Unit.h"
+
+/*
+ * Sends the calls of a Unit with RfcCreateUnit(), RfcInvokeInUnit() and RfcSubmitUnit(), then confirms it with
+ * RfcConfirmUnit(). Resolves with { unitId, unitType, confirmed }, errors carry the unit ID to retry with.
+ */
+class UnitSubmit : public ConnectionWorker {
+  public:
+    UnitSubmit(Napi::Env env, const Napi::Value &callback, Unit *unit);
+
+  protected:
+    void Execute() override;
+    void OnOK() override;
+    void OnError(const Napi::Error &e) override;
+    Napi::Value Result() override;
+
+  private:
+    Unit *unit;
+    bool confirmed{};
+};
+
+#endif //SAPNWRFC_UNITSUBMIT_H
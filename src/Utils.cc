@@ -71,3 +71,26 @@ bool IsException(Napi::Env env, const Napi::Value value) {
   napi_is_error(env, value, &result);
   return result;
 }
+
+Napi::Error CancelledError(Napi::Env env) {
+  using namespace Napi;
+  HandleScope scope{env};
+
+  auto e = Error::New(env, "Call cancelled");
+  e.Set("code", Number::New(env, RFC_CANCELED));
+  e.Set("key", String::New(env, "RFC_CANCELED"));
+
+  return e;
+}
+
+Napi::Error TimeoutError(Napi::Env env, uint32_t timeout) {
+  using namespace Napi;
+  HandleScope scope{env};
+
+  auto e = Error::New(env, "Call timed out after " + std::to_string(timeout) + " ms");
+  e.Set("code", Number::New(env, RFC_TIMEOUT));
+  e.Set("key", String::New(env, "RFC_TIMEOUT"));
+  e.Set("timeout", Number::New(env, timeout));
+
+  return e;
+}
@@ -44,6 +44,16 @@ void FillRfcInfo(Napi::Env env, const RFC_ERROR_INFO &info, Napi::Object out);
 Napi::Error RfcError(Napi::Env env, const RFC_ERROR_INFO &info);
 bool IsException(Napi::Env env, const Napi::Value value);
 
+/*
+ * Error of calls cancelled by the caller, with key RFC_CANCELED like the SDK's own error.
+ */
+Napi::Error CancelledError(Napi::Env env);
+
+/*
+ * Error of calls which exceeded their timeout option, with key RFC_TIMEOUT.
+ */
+Napi::Error TimeoutError(Napi::Env env, uint32_t timeout);
+
 
 template<typename This, typename Api, typename... Args>
 Napi::Value call_api(Napi::Env env, Napi::EscapableHandleScope* scope, This* that, const std::string& file, const std::string& function,
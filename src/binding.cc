@@ -25,12 +25,30 @@ SOFTWARE.
 
 #include <napi.h>
 
+#include "AddonData.h"
 #include "Connection.h"
+#include "ConnectionPool.h"
+#include "DescriptorCache.h"
 #include "Function.h"
+#include "LazyResult.h"
+#include "ResultCache.h"
+#include "RfcExecutor.h"
+#include "Server.h"
+#include "Transaction.h"
+#include "Unit.h"
 
 Napi::Object init(Napi::Env env, Napi::Object exports) {
+  AddonData::Init(env);
   Connection::Init(env, exports);
+  ConnectionPool::Init(env, exports);
+  DescriptorCache::Init(env, exports);
   Function::Init(env, exports);
+  LazyResult::Init(env, exports);
+  ResultCache::Init(env, exports);
+  RfcExecutor::Init(env, exports);
+  Server::Init(env, exports);
+  Transaction::Init(env, exports);
+  Unit::Init(env, exports);
   return exports;
 }
 
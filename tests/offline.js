@@ -26,6 +26,24 @@ describe('Offline tests [ci]', function () {
       con.should.be.an.Object();
     });
 
+    it('should report result cache statistics', function () {
+      var stats = sapnwrfc.Cache.Stats();
+      stats.should.have.properties('hits', 'misses', 'evictions', 'expirations', 'entries', 'bytes', 'maxBytes');
+    });
+
+    it('should configure the RFC executor', function () {
+      var maxThreads = sapnwrfc.Executor.Stats().maxThreads;
+      try {
+        sapnwrfc.Executor.Configure({ threads: 16 }).should.be.true();
+        var stats = sapnwrfc.Executor.Stats();
+        stats.maxThreads.should.equal(16);
+        stats.should.have.properties('threads', 'busy', 'queued', 'executed');
+      } finally {
+        // The executor is shared by all later tests
+        sapnwrfc.Executor.Configure({ threads: maxThreads });
+      }
+    });
+
     it('should return a version number', function () {
       var version = con.GetVersion();
       version.should.be.an.Array().and.have.length(3);
@@ -34,6 +52,282 @@ describe('Offline tests [ci]', function () {
     it('should still be closed', function () {
       con.IsOpen().should.be.false();
     });
+
+    it('should load in a worker thread', function (done) {
+      var Worker = require('worker_threads').Worker;
+      var worker = new Worker(
+        "var sapnwrfc = require(" + JSON.stringify(require.resolve('../sapnwrfc')) + ");" +
+        "require('worker_threads').parentPort.postMessage(new sapnwrfc.Connection().GetVersion());",
+        { eval: true });
+      worker.on('error', done);
+      worker.on('message', function (version) {
+        version.should.eql(con.GetVersion());
+        worker.terminate();
+        done();
+      });
+    });
+
+    it('should report reconnect statistics', function () {
+      var stats = con.ReconnectStats();
+      stats.enabled.should.be.false();
+      stats.attempts.should.equal(0);
+      stats.should.have.properties('reconnects', 'failures', 'retriedCalls', 'lastLatency', 'totalLatency');
+    });
+  });
+
+  context('Descriptor cache', function () {
+    var os = require('os');
+    var fs = require('fs');
+    var path = require('path');
+
+    it('should report a missing descriptor file', function () {
+      var result = sapnwrfc.Descriptors.Load(os.tmpdir(), 'NOSYS');
+      result.loaded.should.be.false();
+      result.reason.should.equal('missing');
+    });
+
+    it('should reject a corrupt descriptor file', function () {
+      var dir = fs.mkdtempSync(path.join(os.tmpdir(), 'nwrfcdesc-'));
+      fs.writeFileSync(path.join(dir, 'NSP.nwrfcdesc'), 'NWRFCDC1 garbage');
+      sapnwrfc.Descriptors.Load(dir, 'NSP').reason.should.equal('format');
+      sapnwrfc.Descriptors.Remove(dir, 'NSP').should.be.true();
+      sapnwrfc.Descriptors.Load(dir, 'NSP').reason.should.equal('missing');
+      fs.rmdirSync(dir);
+    });
+  });
+
+  context('Function schemas', function () {
+    var schema = {
+      title: 'Signature of SAP RFC function Z_OFFLINE_TEST',
+      type: 'object',
+      properties: {
+        TEXT: { type: 'string', length: '10', sapType: 'RFCTYPE_CHAR', sapDirection: 'RFC_IMPORT' },
+        ITEMS: {
+          type: 'array', length: '0', sapType: 'RFCTYPE_TABLE', sapDirection: 'RFC_TABLES',
+          items: {
+            sapTypeName: 'ZOFFLINE_ITEM', type: 'object',
+            properties: {
+              ID: { type: 'integer', length: '4', sapType: 'RFCTYPE_INT' },
+              NAME: { type: 'string', length: '0', sapType: 'RFCTYPE_STRING' }
+            }
+          }
+        }
+      }
+    };
+
+    it('should define a function without a system', function () {
+      var func = con.Define(schema, { repository: 'OFFLINE' });
+      func.should.have.properties('TEXT', 'ITEMS');
+      var signature = func.MetaData();
+      signature.title.should.equal(schema.title);
+      signature.properties.TEXT.length.should.equal('10');
+      signature.properties.ITEMS.items.sapTypeName.should.equal('ZOFFLINE_ITEM');
+      signature.properties.ITEMS.items.properties.should.have.properties('ID', 'NAME');
+    });
+
+    it('should keep the schema of a function', function () {
+      var func = con.Define(schema, { repository: 'OFFLINE' });
+      var frozen = func.MetaData({ format: 'frozen' });
+      Object.isFrozen(frozen.properties.ITEMS.items).should.be.true();
+      func.MetaData({ format: 'frozen' }).should.equal(frozen);
+      JSON.parse(func.MetaData({ format: 'json' }).toString()).should.eql(func.MetaData());
+      return func.MetaDataAsync({ format: 'json' }).then(function (json) {
+        json.should.be.an.instanceOf(Buffer);
+        JSON.parse(json.toString()).title.should.equal(schema.title);
+      });
+    });
+
+    it('should keep the schema of a pending request when the metadata is refreshed', function () {
+      var func = con.Define(schema, { repository: 'OFFLINE' });
+      func.MetaData();
+      var pending = func.MetaDataAsync();
+      func.MetaData({ refresh: true }).title.should.equal(schema.title);
+      return pending.then(function (signature) {
+        signature.title.should.equal(schema.title);
+        signature.properties.should.have.properties('TEXT', 'ITEMS');
+      });
+    });
+
+    it('should validate input against the schema', function () {
+      var func = con.Define(schema, { repository: 'OFFLINE' });
+      func.Validate({ TEXT: 'ABC', ITEMS: [{ ID: 1, NAME: 'x' }] }).should.eql([]);
+      func.Validate({ TEXT: 'ABCDEFGHIJK', ITEMS: [{ ID: 1 }, { ID: 1.5, COUNT: 1 }] }).should.eql([
+        { path: 'TEXT', message: 'exceeds 10 characters' },
+        { path: 'ITEMS[1].ID', message: 'must be an integer of 4 bytes' },
+        { path: 'ITEMS[1].COUNT', message: 'is not a field of ZOFFLINE_ITEM' }
+      ]);
+      func.Validate({ OTHER: 1 }).map(function (violation) { return violation.path; }).should.eql(['OTHER', 'TEXT']);
+
+      var failed;
+      func.Invoke({ TEXT: 5 }, function (err) {
+        failed = err;
+      }, { validate: true });
+      failed.should.be.an.instanceOf(TypeError);
+      failed.violations.should.eql([{ path: 'TEXT', message: 'must be a string' }]);
+    });
+
+    it('should define a function from its metadata', function () {
+      var packed = {
+        title: 'Signature of SAP RFC function Z_OFFLINE_PACKED',
+        type: 'object',
+        properties: {
+          AMOUNT: { type: 'string', length: '7', sapType: 'RFCTYPE_BCD', decimals: 2, sapDirection: 'RFC_IMPORT', optional: true },
+          TOTAL: { type: 'string', length: '8', sapType: 'RFCTYPE_DECF16', sapDirection: 'RFC_EXPORT' }
+        }
+      };
+      var signature = con.Define(packed, { repository: 'OFFLINE' }).MetaData();
+      signature.properties.AMOUNT.decimals.should.equal('2');
+      signature.properties.AMOUNT.optional.should.be.true();
+      signature.properties.TOTAL.optional.should.be.false();
+      con.Define(signature, { repository: 'OFFLINE', refresh: true }).MetaData().should.eql(signature);
+    });
+
+    it('should reject an invalid schema', function () {
+      (function () {
+        con.Define({ properties: { X: { sapType: 'RFCTYPE_CHAR', sapDirection: 'RFC_IMPORT' } } });
+      }).should.throw(TypeError);
+    });
+  });
+
+  context('Columnar tables', function () {
+    it('should decode cells of a shared buffer', function () {
+      var buffer = new SharedArrayBuffer(48);
+      new Int32Array(buffer, 0, 2).set([7, -3]);
+      new Uint16Array(buffer, 8, 6).set([65, 66, 32, 67, 0, 0]);
+      new Uint32Array(buffer, 24, 4).set([0, 4, 4, 2]);
+      new Uint16Array(buffer, 40, 3).set([104, 105, 33]);
+
+      var table = new sapnwrfc.ColumnarTable({
+        buffer: buffer, rows: 2, byteLength: 46, heapOffset: 40, heapLength: 6, columns: [
+          { name: 'INT', type: 'RFCTYPE_INT', kind: 'int32', offset: 0, width: 4 },
+          { name: 'CHAR', type: 'RFCTYPE_CHAR', kind: 'char', offset: 8, width: 6 },
+          { name: 'STR', type: 'RFCTYPE_STRING', kind: 'string', offset: 24, width: 8 }
+        ]
+      });
+
+      table.length.should.equal(2);
+      table.toArray().should.eql([{ INT: 7, CHAR: 'AB ', STR: 'hi' }, { INT: -3, CHAR: 'C', STR: '!' }]);
+      Array.from(table.column('INT')).should.eql([7, -3]);
+    });
+  });
+
+  context('Server', function () {
+    it('should reject invalid handlers', function () {
+      var server = new sapnwrfc.Server({ gwhost: '127.0.0.1', gwserv: '1', program_id: 'NODE_OFFLINE' });
+      (function () {
+        server.AddFunction({}, function () {});
+      }).should.throw(TypeError);
+      server.IsRunning().should.be.false();
+    });
+
+    it('should validate listener options', function () {
+      (function () {
+        new sapnwrfc.Server({ program_id: 'NODE_OFFLINE' }, { listeners: 0 });
+      }).should.throw(TypeError);
+      (function () {
+        new sapnwrfc.Server({ program_id: 'NODE_OFFLINE' }, { overload: 'drop' });
+      }).should.throw(TypeError);
+      var server = new sapnwrfc.Server({ program_id: 'NODE_OFFLINE' }, { listeners: 4, maxQueue: 2 });
+      server.Stats().should.eql({ queueDepth: 0, peakQueueDepth: 0, maxQueue: 2, listeners: [] });
+    });
+
+    it('should fail to register without a gateway', function () {
+      this.timeout(10000);
+      var server = new sapnwrfc.Server({ gwhost: '127.0.0.1', gwserv: '1', program_id: 'NODE_OFFLINE' },
+        { listeners: 2 });
+      return server.StartAsync().then(function () {
+        throw new Error('StartAsync should have failed');
+      }, function (err) {
+        err.should.be.an.Error();
+        server.IsRunning().should.be.false();
+        server.Stats().listeners.should.have.length(2);
+      });
+    });
+  });
+
+  context('Transactions', function () {
+    var os = require('os');
+    var fs = require('fs');
+    var path = require('path');
+    var schema = {
+      title: 'Signature of SAP RFC function Z_OFFLINE_POST',
+      properties: {
+        DOC: { type: 'string', length: '10', sapType: 'RFCTYPE_CHAR', sapDirection: 'RFC_IMPORT' }
+      }
+    };
+
+    it('should validate transaction options', function () {
+      (function () {
+        con.Transaction({ queue: 'Q'.repeat(25) });
+      }).should.throw(TypeError);
+      (function () {
+        con.Transaction({ tid: 'SHORT' });
+      }).should.throw(TypeError);
+      should(con.Transaction().Id()).be.null();
+    });
+
+    it('should keep the TID store unchanged when submitting fails', function () {
+      var dir = fs.mkdtempSync(path.join(os.tmpdir(), 'nwrfctid-'));
+      var tx = con.Transaction({ queue: 'OFFLINE', store: dir });
+      tx.Add(con.Define(schema, { repository: 'OFFLINE' }), { DOC: '4711' });
+      return tx.Submit().then(function () {
+        throw new Error('Submit should have failed');
+      }, function (err) {
+        err.should.be.an.Error();
+        sapnwrfc.PendingTransactions(dir).should.eql([]);
+      });
+    });
+
+    it('should list pending transactions of a TID store', function () {
+      var dir = fs.mkdtempSync(path.join(os.tmpdir(), 'nwrfctid-'));
+      var tid = '0A0B0C0D0E0F101112131415';
+      fs.writeFileSync(path.join(dir, tid + '.json'), JSON.stringify({
+        tid: tid, queue: null, calls: [{ name: 'Z_OFFLINE_POST', params: { DOC: '4711', RAW: Buffer.from([1, 2]) } }]
+      }));
+      var pending = sapnwrfc.PendingTransactions(dir);
+      pending.should.have.length(1);
+      pending[0].tid.should.equal(tid);
+      pending[0].calls[0].params.RAW.should.eql(Buffer.from([1, 2]));
+    });
+  });
+
+  context('Background RFC units', function () {
+    var schema = {
+      title: 'Signature of SAP RFC function Z_OFFLINE_UNIT',
+      properties: {
+        DOC: { type: 'string', length: '10', sapType: 'RFCTYPE_CHAR', sapDirection: 'RFC_IMPORT' }
+      }
+    };
+
+    it('should validate unit options', function () {
+      (function () {
+        con.Unit({ queues: 'OFFLINE' });
+      }).should.throw(TypeError);
+      (function () {
+        con.Unit({ queues: [''] });
+      }).should.throw(TypeError);
+      (function () {
+        con.Unit({ unitId: 'SHORT' });
+      }).should.throw(TypeError);
+      should(con.Unit().Id()).be.null();
+    });
+
+    it('should not submit an empty unit', function () {
+      (function () {
+        con.Unit().Submit();
+      }).should.throw(/no calls/);
+    });
+
+    it('should reject submitting a unit on a closed connection', function () {
+      var unit = con.Unit({ queues: ['OFFLINE_1', 'OFFLINE_2'] });
+      unit.Add(con.Define(schema, { repository: 'OFFLINE' }), { DOC: '4711' });
+      return unit.Submit().then(function () {
+        throw new Error('Submit should have failed');
+      }, function (err) {
+        err.should.be.an.Error();
+        should(unit.Id()).be.null();
+      });
+    });
   });
 
   context('Closed connection', function () {
@@ -42,6 +336,29 @@ describe('Offline tests [ci]', function () {
       pong.should.be.an.Error();
       should(pong.key).equal('RFC_INVALID_HANDLE');
     });
+
+    it('should reject an asynchronous ping', function () {
+      return con.PingAsync().then(function () {
+        throw new Error('PingAsync should have failed');
+      }, function (err) {
+        should(err.key).equal('RFC_INVALID_HANDLE');
+      });
+    });
+
+    it('should report closed asynchronously', function (done) {
+      con.IsOpenAsync(function (err, isOpen) {
+        should(err).be.undefined();
+        isOpen.should.be.false();
+        done();
+      });
+    });
+
+    it('should report batch calls whose name cannot be resolved in their result', function () {
+      return con.InvokeBatch([{ fn: 'STFC_CONNECTION', params: { REQUTEXT: 'Hello' } }]).then(function (results) {
+        results.should.have.length(1);
+        results[0].should.be.an.Error();
+      });
+    });
   });
 });
 
@@ -69,6 +386,31 @@ describe('Online tests', function () {
       pong.should.be.true();
     });
 
+    it('should save and load function descriptors', function () {
+      var os = require('os');
+      var func = con.Lookup('STFC_STRUCTURE');
+      var saved = sapnwrfc.Descriptors.Save(os.tmpdir(), [func]);
+      saved.functions.should.equal(1);
+      saved.types.should.be.above(0);
+      var loaded = sapnwrfc.Descriptors.Load(os.tmpdir(), saved.sysId, { maxAge: 60000 });
+      loaded.loaded.should.be.true();
+      loaded.timestamp.should.equal(saved.timestamp);
+      // The looked up descriptors are still in use and are not replaced
+      loaded.skipped.should.equal(saved.functions + saved.types);
+      sapnwrfc.Descriptors.Load(os.tmpdir(), saved.sysId, { notBefore: new Date(saved.timestamp + 1) }).reason.should.equal('expired');
+      sapnwrfc.Descriptors.Remove(os.tmpdir(), saved.sysId);
+    });
+
+    it('should reuse looked up functions', function () {
+      var before = con.LookupStats();
+      var func = con.Lookup('STFC_CONNECTION');
+      con.Lookup('STFC_CONNECTION').should.equal(func);
+      con.Lookup('STFC_CONNECTION', { refreshMeta: true }).should.not.equal(func);
+      var stats = con.LookupStats();
+      stats.hits.should.equal(before.hits + 1);
+      stats.misses.should.be.above(before.misses);
+    });
+
     it('should fail on lookup of a non-existing FM', function () {
       var func = con.Lookup('AAAAAAAA');
       func.should.be.an.instanceof(Error).and.have.enumerable('key');
@@ -80,6 +422,20 @@ describe('Online tests', function () {
       func.should.not.be.an.Error();
       func.Invoke.should.be.an.Function;
     });
+
+    it('should look up a FM asynchronously', function () {
+      return con.LookupAsync('RFC_PING', {refreshMeta: true}).then(function (func) {
+        func.Invoke.should.be.an.Function;
+      });
+    });
+
+    it('should pong my asynchronous ping', function (done) {
+      con.PingAsync(function (err, pong) {
+        should(err).be.undefined();
+        pong.should.be.true();
+        done();
+      });
+    });
   });
 
   context('Simple function calls', function () {
@@ -167,6 +523,242 @@ describe('Online tests', function () {
       });
     });
 
+    it('should visit table rows', function (done) {
+      var func = con.Lookup('STFC_STRUCTURE');
+      var params = { IMPORTSTRUCT: { RFCINT4: 1234 } };
+      params.RFCTABLE = [{}, params.IMPORTSTRUCT];
+      var rows = [];
+
+      func.Invoke(params, function (err, result) {
+        should(err).be.Null();
+
+        result.should.have.property('RFCTABLE').and.equal(3);
+        rows.should.have.length(3);
+        rows[1].RFCINT4.should.equal(1234);
+        rows[2].RFCINT4.should.equal(1235);
+        done();
+      }, {
+        visitRows: {
+          RFCTABLE: function (row, index) {
+            index.should.equal(rows.length);
+            rows.push(row);
+          }
+        }
+      });
+    });
+
+    it('should reuse the visited row object', function (done) {
+      var func = con.Lookup('STFC_STRUCTURE');
+      var params = { IMPORTSTRUCT: {}, RFCTABLE: [{}] };
+      var seen = [];
+
+      func.Invoke(params, function (err, result) {
+        should(err).be.Null();
+
+        seen.should.have.length(2);
+        seen[0].should.equal(seen[1]);
+        done();
+      }, {
+        reuseRow: true,
+        visitRows: {
+          RFCTABLE: function (row) {
+            seen.push(row);
+          }
+        }
+      });
+    });
+
+    it('should decode lazy results on access', function (done) {
+      var func = con.Lookup('STFC_STRUCTURE');
+      var params = { IMPORTSTRUCT: { RFCINT4: 1234 }, RFCTABLE: [{}] };
+
+      func.Invoke(params, function (err, result) {
+        should(err).be.Null();
+
+        result.should.have.property('ECHOSTRUCT');
+        result.ECHOSTRUCT.RFCINT4.should.equal(1234);
+        result.RFCTABLE.should.have.length(2);
+        result.RFCTABLE[1].RFCINT4.should.equal(1235);
+        result.dispose().should.be.true();
+        (function () {
+          return result.RESPTEXT;
+        }).should.throw(/disposed/);
+        done();
+      }, { lazy: true });
+    });
+
+    it('should answer repeated calls from the result cache', function (done) {
+      sapnwrfc.Cache.Enable('STFC_CONNECTION');
+      var func = con.Lookup('STFC_CONNECTION');
+      var params = { REQUTEXT: 'cached' };
+      var hits = sapnwrfc.Cache.Stats().hits;
+
+      func.Invoke(params, function (err, first) {
+        should(err).be.Null();
+
+        func.Invoke(params, function (err, second) {
+          should(err).be.Null();
+          sapnwrfc.Cache.Disable('STFC_CONNECTION');
+
+          sapnwrfc.Cache.Stats().hits.should.equal(hits + 1);
+          second.should.eql(first);
+          second.should.not.equal(first);
+          done();
+        });
+      });
+    });
+
+    it('should key cached results by the marshaled input', function (done) {
+      sapnwrfc.Cache.Enable('stfc_connection');
+      var func = con.Lookup('STFC_CONNECTION');
+      var hits = sapnwrfc.Cache.Stats().hits;
+
+      func.Invoke({ REQUTEXT: 'padded' }, function (err) {
+        should(err).be.Null();
+
+        // CHAR values are padded with blanks in the container
+        func.Invoke({ REQUTEXT: 'padded   ' }, function (err) {
+          should(err).be.Null();
+          sapnwrfc.Cache.Disable('STFC_CONNECTION');
+
+          sapnwrfc.Cache.Stats().hits.should.equal(hits + 1);
+          done();
+        });
+      });
+    });
+
+    it('should coalesce identical invocations', function (done) {
+      var func = con.Lookup('STFC_CONNECTION');
+      var params = { REQUTEXT: 'coalesced' };
+      var results = [];
+
+      function handler(err, result) {
+        should(err).be.Null();
+        results.push(result);
+        if (results.length === 2) {
+          results[0].should.eql(results[1]);
+          results[0].should.not.equal(results[1]);
+          done();
+        }
+      }
+
+      func.Invoke(params, handler, { coalesce: true });
+      func.Invoke(params, handler, { coalesce: true });
+    });
+
+    it('should invoke coalesced followers when the leader is cancelled', function (done) {
+      var func = con.Lookup('STFC_CONNECTION');
+      var params = { REQUTEXT: 'leader cancelled' };
+      var pending = 3;
+
+      function finish() {
+        if (--pending === 0) {
+          done();
+        }
+      }
+
+      // Keeps the leader waiting in the queue
+      func.Invoke({ REQUTEXT: 'ahead' }, function (err) {
+        should(err).be.Null();
+        finish();
+      });
+      var id = func.Invoke(params, function (err) {
+        should(err.key).equal('RFC_CANCELED');
+        finish();
+      }, { coalesce: true });
+      func.Invoke(params, function (err, result) {
+        should(err).be.Null();
+        result.ECHOTEXT.should.startWith('leader cancelled');
+        finish();
+      }, { coalesce: true });
+      func.Cancel(id).should.be.true();
+    });
+
+    it('should return a Promise from InvokeAsync', function () {
+      var func = con.Lookup('STFC_CONNECTION');
+      return func.InvokeAsync({ REQUTEXT: 'Hello' }).then(function (result) {
+        result.ECHOTEXT.should.startWith('Hello');
+      });
+    });
+
+    it('should not start an invocation with an aborted signal', function () {
+      var func = con.Lookup('STFC_CONNECTION');
+      var controller = new AbortController();
+      controller.abort();
+      return func.InvokeAsync({ REQUTEXT: 'Hello' }, { signal: controller.signal }).then(function () {
+        throw new Error('InvokeAsync should have been rejected');
+      }, function (err) {
+        err.name.should.equal('AbortError');
+      });
+    });
+
+    it('should reject an invalid timeout option', function () {
+      var func = con.Lookup('STFC_CONNECTION');
+      (function () {
+        func.Invoke({ REQUTEXT: 'Hello' }, function () {}, { timeout: 'soon' });
+      }).should.throw(TypeError);
+    });
+
+    it('should complete calls within their timeout', function (done) {
+      var func = con.Lookup('STFC_CONNECTION');
+      func.Invoke({ REQUTEXT: 'Hello' }, function (err, result) {
+        should(err).be.undefined();
+        result.ECHOTEXT.should.startWith('Hello');
+        done();
+      }, { timeout: 60000 });
+    });
+
+    it('should invoke a batch of calls in a single completion', function (done) {
+      var func = con.Lookup('STFC_CONNECTION');
+      con.InvokeBatch([
+        { fn: func, params: { REQUTEXT: 'first' } },
+        { fn: 'NOT_EXISTING', params: {} },
+        { fn: 'STFC_CONNECTION', params: { REQUTEXT: 'second' } }
+      ], function (err, results) {
+        should(err).be.undefined();
+        results.length.should.equal(3);
+        results[0].ECHOTEXT.should.startWith('first');
+        results[1].should.be.an.instanceOf(Error);
+        results[2].ECHOTEXT.should.startWith('second');
+        done();
+      });
+    });
+
+    it('should return a Promise from InvokeBatch without callback', function () {
+      return con.InvokeBatch([{ fn: 'STFC_CONNECTION', params: { REQUTEXT: 'Hello' } }]).then(function (results) {
+        results[0].ECHOTEXT.should.startWith('Hello');
+      });
+    });
+
+    it('should pass the results of a cancelled batch', function (done) {
+      var func = con.Lookup('STFC_CONNECTION');
+
+      // Keeps the batch waiting in the queue
+      func.Invoke({ REQUTEXT: 'ahead' }, function () {});
+      var id = con.InvokeBatch([{ fn: func, params: { REQUTEXT: 'cancelled' } }], function (err, results) {
+        should(err).be.undefined();
+        results.should.have.length(1);
+        should(results[0].key).equal('RFC_CANCELED');
+        done();
+      });
+      con.Cancel(id).should.be.true();
+    });
+
+    it('should return tables in shared buffers', function (done) {
+      var func = con.Lookup('STFC_STRUCTURE');
+      func.Invoke({ RFCTABLE: [{ RFCINT4: 42, RFCCHAR4: 'ABCD' }] }, function (err, result) {
+        should(err).be.undefined();
+        var table = result.RFCTABLE;
+        table.should.be.an.instanceOf(sapnwrfc.ColumnarTable);
+        table.descriptor.buffer.should.be.an.instanceOf(SharedArrayBuffer);
+        table.length.should.equal(2);
+        table.get(0, 'RFCINT4').should.equal(42);
+        table.get(0, 'RFCCHAR4').should.equal('ABCD');
+        result.ECHOSTRUCT.should.be.an.Object();
+        done();
+      }, { columnar: true });
+    });
+
     it('should handle XSTRING parameters', function (done) {
       var func = con.Lookup('STFC_XSTRING');
       var params = { QUESTION: new Buffer('C0FFEE', 'hex') };
@@ -222,6 +814,70 @@ describe('Online tests', function () {
     });
   });
 
+  context('Connection pool', function () {
+    var pool = undefined;
+
+    before(function (done) {
+      pool = new sapnwrfc.ConnectionPool(connectionParams, { min: 1, max: 2 });
+      pool.Open(function (err) {
+        should(err).be.undefined();
+        done();
+      });
+    });
+
+    it('should warm up connections and function descriptors', function () {
+      return pool.WarmUpAsync({ connections: 2, functions: ['STFC_CONNECTION', 'STFC_STRUCTURE'] }).then(function (report) {
+        report.connections.size.should.equal(2);
+        report.connections.failed.should.equal(0);
+        report.functions.fetched.should.equal(2);
+        report.millis.should.be.aboveOrEqual(report.connections.millis);
+      });
+    });
+
+    it('should fan out table chunks over pooled connections', function (done) {
+      var rows = [];
+      for (var i = 0; i < 5; i++) {
+        rows.push({ RFCINT4: i });
+      }
+      var events = [];
+      pool.FanOut('STFC_STRUCTURE', { RFCTABLE: rows }, {
+        table: 'RFCTABLE', chunkSize: 2, parallel: 2, progress: function (event) {
+          events.push(event);
+        }
+      }, function (err, merged, chunkResults) {
+        should(err).be.undefined();
+        chunkResults.should.have.length(3);
+        // STFC_STRUCTURE appends one row to every chunk
+        merged.RFCTABLE.should.have.length(8);
+        merged.RFCTABLE[0].RFCINT4.should.equal(0);
+        merged.RFCTABLE[3].RFCINT4.should.equal(2);
+        events.should.have.length(3);
+        events[2].rows.should.equal(5);
+        events[2].totalRows.should.equal(5);
+        pool.Stats().leased.should.equal(0);
+        done();
+      });
+    });
+
+    it('should run invocations on pooled connections', function (done) {
+      var pending = 3;
+      for (var i = 0; i < 3; i++) {
+        pool.Invoke('STFC_CONNECTION', { REQUTEXT: 'pooled' }, function (err, result) {
+          should(err).be.undefined();
+          result.ECHOTEXT.should.startWith('pooled');
+          if (--pending === 0) {
+            var stats = pool.Stats();
+            stats.size.should.be.belowOrEqual(2);
+            stats.leased.should.equal(0);
+            stats.acquired.should.equal(3);
+            pool.Close();
+            done();
+          }
+        });
+      }
+    });
+  });
+
   /*context('Load tests', function () {
     it('should not run out of memory 1', function (done) {
       for (var i = 0; i < 10000; i++) {